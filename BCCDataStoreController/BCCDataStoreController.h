@@ -9,12 +9,19 @@
 
 #import <Foundation/Foundation.h>
 #import <CoreData/CoreData.h>
+#import "BCCDataStoreControllerMetrics.h"
 
 @class BCCTargetActionQueue;
 @class BCCDataStoreController;
 @class BCCDataStoreControllerIdentityParameters;
 @class BCCDataStoreControllerWorkParameters;
 @class BCCDataStoreControllerImportParameters;
+@class BCCDataStoreControllerObserverParameters;
+@class BCCDataStoreControllerObjectCache;
+@class BCCDataStoreControllerSaveStatistics;
+@class BCCDataStoreControllerPreparedQuery;
+@class BCCDataStoreControllerQueryParameters;
+@class BCCDataStoreControllerQueryCursor;
 
 
 extern NSString *BCCDataStoreControllerWillClearDatabaseNotification;
@@ -23,10 +30,33 @@ extern NSString *BCCDataStoreControllerDidClearDatabaseNotification;
 extern NSString *BCCDataStoreControllerWillClearIncompatibleDatabaseNotification;
 extern NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification;
 
+// Change notification dictionary key for the IDs of deleted objects
+extern NSString *BCCDataStoreChangeNotificationDeletedObjectIDsKey;
+
+extern NSString * const BCCDataStoreControllerErrorDomain;
+extern const NSInteger BCCDataStoreControllerErrorStreamReadFailed;
+extern const NSInteger BCCDataStoreControllerErrorInvalidJSON;
+extern const NSInteger BCCDataStoreControllerErrorTruncatedJSON;
+extern const NSInteger BCCDataStoreControllerErrorModelUnavailable;
+extern const NSInteger BCCDataStoreControllerErrorStoreUnavailable;
+extern const NSInteger BCCDataStoreControllerErrorCommitDeferred;
+
+extern const NSUInteger BCCDataStoreControllerDefaultFindExistingBatchSize;
+extern const NSUInteger BCCDataStoreControllerDefaultStreamingChunkSize;
+
 typedef void (^BCCDataStoreControllerWorkBlock)(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters);
 
+typedef void (^BCCDataStoreControllerPersistCompletionBlock)(NSError *error);
+
+typedef void (^BCCDataStoreControllerStartupCompletionBlock)(BCCDataStoreController *dataStoreController, NSError *error);
+
 typedef void (^BCCDataStoreControllerPostCreateBlock)(NSManagedObject *createdObject, id sourceObject, NSUInteger idx, NSManagedObjectContext *managedObjectContext);
 
+typedef void (^BCCDataStoreControllerImportChunkBlock)(NSArray *objectIDs, NSUInteger firstRecordIndex);
+typedef void (^BCCDataStoreControllerImportProgressBlock)(NSUInteger recordCount, unsigned long long byteCount);
+typedef void (^BCCDataStoreControllerImportCompletionBlock)(NSUInteger recordCount, NSError *error);
+typedef void (^BCCDataStoreControllerCreateObjectsCompletionBlock)(NSArray *createdObjects, NSError *error);
+
 typedef enum {
     BCCDataStoreControllerWorkExecutionStyleMainMOCAndWait,
     BCCDataStoreControllerWorkExecutionStyleMainMOC,
@@ -36,6 +66,12 @@ typedef enum {
     BCCDataStoreControllerWorkExecutionStyleThreadMOC
 } BCCDataStoreControllerWorkExecutionStyle;
 
+typedef enum {
+    BCCDataStoreControllerQueryResultTypeManagedObjects,
+    BCCDataStoreControllerQueryResultTypeObjectIDs,
+    BCCDataStoreControllerQueryResultTypeDictionaries
+} BCCDataStoreControllerQueryResultType;
+
 
 @interface BCCDataStoreController : NSObject {
     
@@ -51,6 +87,52 @@ typedef enum {
 @property (strong, nonatomic, readonly) NSManagedObjectContext *mainMOC;
 @property (strong, nonatomic, readonly) NSManagedObjectContext *backgroundMOC;
 
+// Set once the persistent store is open. If it couldn't be opened,
+// startupError says why and work submitted to the controller is dropped.
+// Until then, other work is queued, and calls that wait (the ...AndWait
+// methods, persistChangesAndWait:, reset, deletePersistentStore and
+// setting the identifier) block until startup finishes, including on the
+// main thread. Use the startup completion to avoid blocking the main
+// thread through a long migration.
+@property (readonly, getter=isReady) BOOL ready;
+@property (strong, readonly) NSError *startupError;
+
+// Observers are called on the main MOC's queue with its objects by
+// default. When this is set they're called on it instead; unless it's the
+// main queue the objects can't be used there, so their notifications only
+// carry object IDs (newly inserted objects' may be temporary). Saves don't wait for
+// observers unless waitsForObserverNotifications is set; saves made on the
+// queue itself then deliver inline.
+@property (strong, nonatomic) dispatch_queue_t observerNotificationQueue;
+@property (nonatomic) BOOL waitsForObserverNotifications;
+
+// Main MOC saves reach disk asynchronously, in group commits made at most
+// writeCommitLatency seconds after the first save in the group or as soon
+// as maximumWriteCommitSaveCount saves have piled up (0 for no limit).
+// Use the persist methods below when changes need to be durable.
+@property (nonatomic) NSTimeInterval writeCommitLatency;
+@property (nonatomic) NSUInteger maximumWriteCommitSaveCount;
+
+// When set, entity, group and identity value list deletes are carried out
+// by the store with NSBatchDeleteRequest instead of fetching and deleting
+// each object. Worker caches and contexts are updated and observers are
+// told about the deletions afterwards. The store only sees what has been
+// committed to it, so persist first (e.g. persistChangesWithCompletion:)
+// if saves still on their way down need to be covered; unsaved inserts in
+// the calling context are deleted the ordinary way.
+@property (nonatomic) BOOL usesBatchDeleteRequests;
+
+// Metrics are only gathered while a recorder is set (nil by default). Set
+// it before starting work; it's read from every queue the controller uses.
+@property (strong) id <BCCDataStoreControllerMetricsRecorder> metricsRecorder;
+
+// Wraps blocks run through performWorkWithParameters: in signpost
+// intervals so they show up in Instruments
+@property (nonatomic) BOOL tracesWorkBlocks;
+
+// A snapshot of per-stage save timings
+@property (strong, nonatomic, readonly) BCCDataStoreControllerSaveStatistics *saveStatistics;
+
 // Class Methods
 + (NSString *)defaultRootDirectory;
 
@@ -58,10 +140,24 @@ typedef enum {
 - (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath;
 - (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory;
 
+// Returns right away and loads the model and opens (and if needed
+// migrates) the store on a background queue. Work handed to the perform
+// methods in the meantime is queued and run in order once the store is
+// open. Waiting variants called off the main thread block until then.
+// Don't use the contexts directly before the completion, which is called on
+// the main queue. The incompatible database notifications may be posted
+// from the background queue.
+- (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory completion:(BCCDataStoreControllerStartupCompletionBlock)completion;
+
 // Persistent Store State
 - (void)reset;
 - (void)deletePersistentStore;
 
+// Persistent Store Metadata. Values set here are held until the next
+// commit to disk and written out with it.
+- (id)persistentStoreMetadataValueForKey:(NSString *)key;
+- (void)setPersistentStoreMetadataValue:(id)value forKey:(NSString *)key;
+
 // Managed Object Contexts
 - (NSManagedObjectContext *)newMOCWithConcurrencyType:(NSManagedObjectContextConcurrencyType)concurrencyType;
 - (NSManagedObjectContext *)currentMOC;
@@ -71,6 +167,19 @@ typedef enum {
 - (void)saveMainMOC;
 - (void)saveBackgroundMOC;
 
+// Durability. The completion is called on the main queue once everything
+// saved to the main MOC so far has been written to the persistent store.
+- (void)persistChangesWithCompletion:(BCCDataStoreControllerPersistCompletionBlock)completion;
+- (BOOL)persistChangesAndWait:(NSError **)error;
+
+// Called on the write MOC's queue before each commit to disk. Subclasses
+// that keep data outside the store for rows to point at flush it here;
+// returning NO holds the changes (and any pending store metadata) back and
+// retries the commit after a growing delay.
+- (BOOL)prepareToCommitChanges:(NSError **)error;
+
+- (void)resetSaveStatistics;
+
 // Work Queueing
 - (void)performWorkWithParameters:(BCCDataStoreControllerWorkParameters *)importParameters;
 
@@ -86,6 +195,7 @@ typedef enum {
 - (void)performBlockOnThreadMOCAndWait:(BCCDataStoreControllerWorkBlock)block;
 
 // Worker Context Memory Cache
+- (BCCDataStoreControllerObjectCache *)objectCacheForMOC:(NSManagedObjectContext *)managedObjectContext;
 - (void)setCacheObject:(NSManagedObject *)cacheObject forMOC:(NSManagedObjectContext *)managedObjectContext identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters;
 - (NSManagedObject *)cacheObjectForMOC:(NSManagedObjectContext *)managedObjectContext identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
 - (void)removeCacheObjectForMOC:(NSManagedObjectContext *)managedObjectContext identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
@@ -97,9 +207,15 @@ typedef enum {
 // Entity Find Or Create
 - (NSManagedObject *)findOrCreateObjectWithIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
 
+// Returns existing objects keyed by normalized identity value, fetched
+// using as few IN queries as the batch size allows (0 uses the default).
+- (NSDictionary *)existingObjectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValueList:(NSArray *)identityValues groupIdentifier:(NSString *)groupIdentifier batchSize:(NSUInteger)batchSize;
+
 // Entity Deletion
 - (void)deleteObjects:(NSArray *)affectedObjects;
 - (void)deleteObjectsWithEntityName:(NSString *)entityName;
+- (void)deleteObjectsWithEntityName:(NSString *)entityName matchingPredicate:(NSPredicate *)predicate;
+- (void)deleteObjectsWithEntityName:(NSString *)entityName identityProperty:(NSString *)identityPropertyName valueList:(NSArray *)valueList;
 - (void)deleteObjectsWithIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifer;
 - (void)deleteObjectWithIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
 
@@ -109,16 +225,33 @@ typedef enum {
 - (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors;
 - (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors;
 
+// Paged, partial and projected variants. The value set filter is applied
+// in the store, so offsets and limits count filtered results.
+- (NSArray *)objectsForEntityWithName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters;
+- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters;
+
+// Counts are taken by the store without loading any objects. They return
+// NSNotFound on error.
+- (NSUInteger)countForEntityWithName:(NSString *)entityName;
+- (NSUInteger)countForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet;
+
+- (BCCDataStoreControllerQueryCursor *)queryCursorForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors pageSize:(NSUInteger)pageSize queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters;
+
 // Fetch Request Creation
 - (NSFetchRequest *)fetchRequestForEntityName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors;
 
 - (NSFetchRequest *)fetchRequestForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors;
 - (NSFetchRequest *)fetchRequestForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValueList:(NSArray *)identityValues groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors;
+- (NSFetchRequest *)fetchRequestForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors;
 
 - (NSFetchRequest *)fetchRequestForEntityName:(NSString *)entityName usingPropertyList:(NSArray *)propertyList valueList:(NSArray *)valueList sortDescriptors:(NSArray *)sortDescriptors;
 
 - (NSFetchRequest *)fetchRequestForTemplateName:(NSString *)templateName substitutionDictionary:(NSDictionary *)substitutionDictionary sortDescriptors:(NSArray *)sortDescriptors;
 
+// Properties in listPropertyNames are matched with IN against an array or
+// set; the rest are matched with ==.
+- (BCCDataStoreControllerPreparedQuery *)preparedQueryForEntityName:(NSString *)entityName usingPropertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames sortDescriptors:(NSArray *)sortDescriptors;
+
 // Fetching
 - (NSManagedObject *)performSingleResultFetchForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier error:(NSError **)error;
 - (NSManagedObject *)performSingleResultFetchOfEntityWithName:(NSString *)entityName usingPropertyList:(NSArray *)propertyList valueList:(NSArray *)valueList error:(NSError **)error;
@@ -127,14 +260,32 @@ typedef enum {
 - (NSArray *)performFetchOfEntityWithName:(NSString *)entityName usingPropertyList:(NSArray *)propertyList valueList:(NSArray *)valueList sortDescriptors:(NSArray *)sortDescriptors error:(NSError **)error;
 
 - (NSArray *)performFetchRequest:(NSFetchRequest *)fetchRequest error:(NSError **)error;
+- (NSArray *)performFetchRequest:(NSFetchRequest *)fetchRequest queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters error:(NSError **)error;
+- (NSUInteger)countForFetchRequest:(NSFetchRequest *)fetchRequest error:(NSError **)error;
+
+// The cursor fetches on the calling context, so only page through it on
+// that context's queue
+- (BCCDataStoreControllerQueryCursor *)queryCursorForFetchRequest:(NSFetchRequest *)fetchRequest pageSize:(NSUInteger)pageSize queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters;
+
+// Fetching Using Prepared Queries (valueList lines up with the query's
+// property list)
+- (NSArray *)performFetchWithPreparedQuery:(BCCDataStoreControllerPreparedQuery *)preparedQuery valueList:(NSArray *)valueList error:(NSError **)error;
+- (NSManagedObject *)performSingleResultFetchWithPreparedQuery:(BCCDataStoreControllerPreparedQuery *)preparedQuery valueList:(NSArray *)valueList error:(NSError **)error;
 
 // Fetching Using Templates
 - (NSArray *)performFetchRequestWithTemplateName:(NSString *)templateName substitutionDictionary:(NSDictionary *)substitutionDictionary sortDescriptors:(NSArray *)sortDescriptors error:(NSError **)error;
 - (NSManagedObject *)performSingleResultFetchRequestWithTemplateName:(NSString *)templateName substitutionDictionary:(NSDictionary *)substitutionDictionary error:(NSError **)error;
 
-// Change Observation
+// Change Observation. With a predicate, updated objects are passed along
+// if they matched it before or after the change, and deleted ones if they
+// matched before it (or their earlier values were never loaded).
 - (void)addObserver:(id)observer action:(SEL)action forEntityName:(NSString *)entityName;
 - (void)addObserver:(id)observer action:(SEL)action forEntityName:(NSString *)entityName withPredicate:(NSPredicate *)predicate requiredChangedKeys:(NSArray *)changedKeys;
+- (void)addObserver:(id)observer action:(SEL)action forEntityName:(NSString *)entityName withParameters:(BCCDataStoreControllerObserverParameters *)observerParameters;
+
+// Coalescing settings for observers of an entity that were added without
+// their own parameters. Pass nil to go back to one notification per save.
+- (void)setDefaultObserverParameters:(BCCDataStoreControllerObserverParameters *)observerParameters forEntityName:(NSString *)entityName;
 
 - (BOOL)hasObserver:(id)observer;
 - (BOOL)hasObserver:(id)observer forEntityName:(NSString *)entityName;
@@ -150,6 +301,30 @@ typedef enum {
 // Entity Mass Creation
 - (NSArray *)createObjectsFromJSONArray:(NSArray *)dictionaryArray usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters;
 
+// Parallel Mass Creation. Splits the import across parallelShardCount
+// contexts that save straight to the store, so it can be started from any
+// queue, including the main MOC's. The completion is called on the main
+// queue with the created objects in the main MOC, in input order. Records
+// from a shard that fails to save are left out and the first failure is
+// passed along.
+- (void)createObjectsInParallelFromJSONArray:(NSArray *)dictionaryArray usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerCreateObjectsCompletionBlock)completion;
+
+// Streaming Import. Takes either a JSON array of objects or one object per
+// line, parsed incrementally and imported streamingChunkSize records at a
+// time on a context of its own. Each chunk is saved, merged into the main
+// contexts and then reset, so memory use doesn't grow with the payload.
+// Chunk and progress blocks are called on the import context's queue; the
+// completion is called on the main queue. If a chunk fails to save the
+// import stops there and the completion gets the save error along with
+// the number of records saved before it. The import isn't atomic: with
+// deleteExisting, the group's old objects stay alongside the new ones
+// until every record has saved, and are only deleted then, so a failed
+// or truncated import leaves both. The stream is read with blocking reads
+// on the import context's queue and no run loop, so it should be a file
+// or in-memory stream; a network stream would stall the import.
+- (void)importObjectsFromJSONFileAtPath:(NSString *)path usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerImportCompletionBlock)completion;
+- (void)importObjectsFromJSONInputStream:(NSInputStream *)inputStream usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerImportCompletionBlock)completion;
+
 @end
 
 
@@ -159,11 +334,108 @@ typedef enum {
 @property (strong, nonatomic) NSSet *insertedObjects;
 @property (strong, nonatomic) NSSet *deletedObjects;
 
+// Only set for observers called on an observerNotificationQueue, in place
+// of the objects above
+@property (strong, nonatomic) NSSet *updatedObjectIDs;
+@property (strong, nonatomic) NSSet *insertedObjectIDs;
+
+// IDs of every deleted object, including ones removed at the store level
+// that were never loaded and so can't appear in deletedObjects. Those
+// can't be checked against an observer's predicate, so observers with one
+// get all of them for their entity.
+@property (strong, nonatomic) NSSet *deletedObjectIDs;
+
 - (id)initWithDictionary:(NSDictionary *)dictionary;
 
 @end
 
 
+// Per-context identity map used by the find-or-create paths. Objects are
+// keyed by (entity, normalized identity value, group) and can be removed
+// by object in constant time. Not thread safe; only touch it from the
+// queue of the context that owns it.
+@interface BCCDataStoreControllerObjectCache : NSObject
+
+@property (nonatomic, readonly) NSUInteger count;
+
+@property (nonatomic, readonly) NSUInteger hitCount;
+@property (nonatomic, readonly) NSUInteger missCount;
+
+- (NSManagedObject *)objectForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
+
+- (void)setObject:(NSManagedObject *)object forEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
+
+- (void)removeObjectForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
+- (void)removeObject:(NSManagedObject *)object;
+- (void)removeAllObjectsForEntityName:(NSString *)entityName;
+- (void)removeAllObjects;
+
+- (void)resetStatistics;
+
+@end
+
+
+// Walks a fetch pageSize results at a time. The matching object IDs are
+// fetched with the first page and each page is then fetched by ID, so
+// only one page is realized at once and later pages don't get slower.
+// Objects deleted since the first page are left out; ones inserted since
+// aren't picked up. Grouped dictionary fetches can't be paged this way.
+// Objects from earlier pages stay registered with the context; use object
+// ID or dictionary results, or reset the context between pages, for very
+// large walks.
+@interface BCCDataStoreControllerQueryCursor : NSObject
+
+@property (nonatomic, readonly) NSUInteger pageSize;
+@property (nonatomic, readonly) BOOL hasMoreResults;
+
+// Returns nil once the results are exhausted or on error
+- (NSArray *)nextPage:(NSError **)error;
+
+@end
+
+
+// A fetch with its entity, compared properties and sort order fixed up
+// front, so executing it only binds values into an already parsed
+// predicate. Immutable; hold on to one and reuse it from any context.
+@interface BCCDataStoreControllerPreparedQuery : NSObject
+
+@property (strong, nonatomic, readonly) NSString *entityName;
+@property (strong, nonatomic, readonly) NSArray *propertyList;
+@property (strong, nonatomic, readonly) NSSet *listPropertyNames;
+@property (strong, nonatomic, readonly) NSArray *sortDescriptors;
+
+// Returns nil if valueList doesn't line up with propertyList
+- (NSFetchRequest *)fetchRequestWithValueList:(NSArray *)valueList;
+
+@end
+
+
+@interface BCCDataStoreControllerSaveStageStatistics : NSObject <NSCopying>
+
+@property (nonatomic, readonly) NSUInteger count;
+@property (nonatomic, readonly) NSTimeInterval lastDuration;
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+@property (nonatomic, readonly) NSTimeInterval maximumDuration;
+@property (nonatomic, readonly) NSTimeInterval averageDuration;
+
+@end
+
+
+// Timings for each stage of the save pipeline: background MOC saves into
+// the main MOC, main MOC saves into the write MOC, how long main MOC
+// saves wait before their group commit starts, and the commit itself.
+@interface BCCDataStoreControllerSaveStatistics : NSObject <NSCopying>
+
+@property (strong, nonatomic, readonly) BCCDataStoreControllerSaveStageStatistics *backgroundSaveStage;
+@property (strong, nonatomic, readonly) BCCDataStoreControllerSaveStageStatistics *mainSaveStage;
+@property (strong, nonatomic, readonly) BCCDataStoreControllerSaveStageStatistics *writeCommitQueueStage;
+@property (strong, nonatomic, readonly) BCCDataStoreControllerSaveStageStatistics *writeCommitStage;
+
+@property (nonatomic, readonly) NSUInteger lastWriteCommitSaveCount;
+
+@end
+
+
 @interface BCCDataStoreControllerWorkParameters : NSObject
 
 @property (nonatomic) BCCDataStoreControllerWorkExecutionStyle workExecutionStyle;
@@ -198,12 +470,68 @@ typedef enum {
 @property (nonatomic) BOOL findExisting;
 @property (nonatomic) BOOL deleteExisting;
 
+// When finding existing objects, look them all up front with chunked
+// IN queries rather than issuing one fetch per dictionary.
+@property (nonatomic) BOOL findsExistingInBatches;
+@property (nonatomic) NSUInteger findExistingBatchSize;
+
+// Parallel imports only. The import is split by identity value across
+// this many private contexts attached straight to the store coordinator.
+// Shards run and save concurrently, so the postCreateBlock must be thread
+// safe. Shards only see what has been persisted to the store: objects
+// still waiting in the main contexts aren't found, and their unpersisted
+// changes can be overwritten, so persist first (e.g.
+// persistChangesWithCompletion:) if that matters. The merged results are
+// handed to observers as one change notification.
+@property (nonatomic) NSUInteger parallelShardCount;
+
 @property (strong, nonatomic) NSString *dictionaryIdentityPropertyName;
 
 @property (strong, nonatomic) NSString *groupIdentifier;
 
 @property (copy) BCCDataStoreControllerPostCreateBlock postCreateBlock;
 
+// Streaming imports only
+@property (nonatomic) NSUInteger streamingChunkSize;
+@property (copy) BCCDataStoreControllerImportChunkBlock chunkBlock;
+@property (copy) BCCDataStoreControllerImportProgressBlock progressBlock;
+
+@end
+
+
+@interface BCCDataStoreControllerQueryParameters : NSObject <NSCopying>
+
+// 0 leaves the corresponding fetch request setting unbounded
+@property (nonatomic) NSUInteger fetchBatchSize;
+@property (nonatomic) NSUInteger fetchOffset;
+@property (nonatomic) NSUInteger fetchLimit;
+
+// Object ID results skip loading property values entirely. Dictionary
+// results load only propertiesToFetch, or every attribute if it's unset.
+@property (nonatomic) BCCDataStoreControllerQueryResultType resultType;
+@property (strong, nonatomic) NSArray *propertiesToFetch;
+
+@property (strong, nonatomic) NSArray *relationshipKeyPathsForPrefetching;
+@property (nonatomic) BOOL returnsObjectsAsFaults;
+
+@end
+
+
+@interface BCCDataStoreControllerObserverParameters : NSObject <NSCopying>
+
+@property (strong, nonatomic) NSPredicate *predicate;
+@property (strong, nonatomic) NSArray *requiredChangedKeys;
+
+// When either limit is set, changes are merged across saves and delivered
+// as one notification once coalescingInterval has passed since the first
+// merged save or maximumCoalescedSaveCount saves have been merged,
+// whichever comes first. Objects inserted and deleted in the same window
+// are left out entirely.
+@property (nonatomic) NSTimeInterval coalescingInterval;
+@property (nonatomic) NSUInteger maximumCoalescedSaveCount;
+
+@property (nonatomic, readonly) BOOL coalescesChanges;
+
 @end
 
 
@@ -6,6 +6,7 @@
 //
 
 #import "BCCDataStoreController.h"
+#import "BCCDataStoreControllerMetrics.h"
 #import "BCCTargetActionQueue.h"
 #import "NSFileManager+BCCAdditions.h"
 #import "NSString+BCCAdditions.h"
@@ -23,13 +24,51 @@ NSString *BCCDataStoreControllerWillClearDatabaseNotification = @"BCCDataStoreCo
 NSString *BCCDataStoreControllerDidClearDatabaseNotification = @"BCCDataStoreControllerDidClearDatabaseNotification";
 
 NSString *BCCDataStoreControllerThreadMOCKey = @"BCCDataStoreControllerThreadMOCKey";
+NSString *BCCDataStoreControllerThreadCurrentMOCKey = @"BCCDataStoreControllerThreadCurrentMOCKey";
 
-NSString *BCCDataStoreControllerCurrentUpdatedKeysUserInfoKey = @"BCCDataStoreControllerCurrentUpdatedKeysUserInfoKey";
+NSString *BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey = @"BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey";
+NSString *BCCDataStoreControllerCurrentCommittedValuesUserInfoKey = @"BCCDataStoreControllerCurrentCommittedValuesUserInfoKey";
 NSString *BCCDataStoreControllerContextObjectCacheUserInfoKey = @"BCCDataStoreControllerContextObjectCacheUserInfoKey";
 
+// IDs of deleted objects that never made it into the main MOC, passed
+// along with change notifications built from store-level changes
+NSString *BCCDataStoreChangeNotificationDeletedObjectIDsKey = @"BCCDataStoreChangeNotificationDeletedObjectIDsKey";
+
+NSString *BCCDataStoreControllerUnregisteredDeletedObjectIDsKey = @"BCCDataStoreControllerUnregisteredDeletedObjectIDsKey";
+
 NSString *BCCDataStoreControllerWillClearIncompatibleDatabaseNotification = @"BCCDataStoreControllerWillClearIncompatibleDatabaseNotification";
 NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCCDataStoreControllerDidClearIncompatibleDatabaseNotification";
 
+// Errors
+NSString * const BCCDataStoreControllerErrorDomain = @"BCCDataStoreControllerErrorDomain";
+const NSInteger BCCDataStoreControllerErrorStreamReadFailed = 1;
+const NSInteger BCCDataStoreControllerErrorInvalidJSON = 2;
+const NSInteger BCCDataStoreControllerErrorTruncatedJSON = 3;
+const NSInteger BCCDataStoreControllerErrorModelUnavailable = 4;
+const NSInteger BCCDataStoreControllerErrorStoreUnavailable = 5;
+const NSInteger BCCDataStoreControllerErrorCommitDeferred = 6;
+
+// Keep IN queries comfortably under SQLite's bound variable limit
+const NSUInteger BCCDataStoreControllerDefaultFindExistingBatchSize = 500;
+
+const NSUInteger BCCDataStoreControllerDefaultStreamingChunkSize = 500;
+const NSUInteger BCCDataStoreControllerJSONRecordReaderReadLength = 32768;
+
+// Changed keys are tracked as one bit per property. Properties past the
+// last bit share it, so filtering on them can over-match but never miss.
+const NSUInteger BCCDataStoreControllerMaximumChangedKeyIndex = 63;
+
+// Deferred write commits are retried after this delay, doubling up to the
+// maximum while they keep getting deferred
+const NSTimeInterval BCCDataStoreControllerMinimumWriteCommitRetryDelay = 0.5;
+const NSTimeInterval BCCDataStoreControllerMaximumWriteCommitRetryDelay = 30.0;
+
+// Tags the startup queue with the controller it's starting up
+static const void *BCCDataStoreControllerStartupQueueKey = &BCCDataStoreControllerStartupQueueKey;
+
+
+@class BCCDataStoreTargetAction;
+
 
 @interface BCCDataStoreController ()
 
@@ -46,38 +85,187 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 @property (strong, nonatomic) dispatch_queue_t workerQueue;
 
+// Startup state. startingUp and pendingWorkParameters are guarded by
+// @synchronized on pendingWorkParameters.
+@property (readwrite, getter=isReady) BOOL ready;
+@property (strong, readwrite) NSError *startupError;
+@property (nonatomic) BOOL startingUp;
+@property (strong, nonatomic) NSMutableArray *pendingWorkParameters;
+@property (strong, nonatomic) dispatch_group_t startupGroup;
+
+// Save pipeline state. All guarded by @synchronized on
+// pendingPersistCompletions.
+@property (strong, nonatomic) NSMutableArray *pendingPersistCompletions;
+@property (nonatomic) NSUInteger pendingWriteCommitSaveCount;
+@property (nonatomic) CFAbsoluteTime firstPendingWriteCommitSaveTime;
+@property (nonatomic) BOOL writeCommitScheduled;
+@property (nonatomic) NSTimeInterval writeCommitRetryDelay;
+@property (nonatomic) BOOL mainMOCSaveScheduled;
+
+// Key -> metadata value (or NSNull for a removal) waiting for the next
+// write commit. Guarded by @synchronized on the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *pendingPersistentStoreMetadata;
+
+// Guarded by @synchronized on itself
+@property (strong, nonatomic) BCCDataStoreControllerSaveStatistics *currentSaveStatistics;
+
 @property (strong, nonatomic) BCCTargetActionQueue *observerInfo;
 
+// Entity name -> observer parameters used by observers that were added
+// without their own. Guarded by @synchronized on the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *defaultObserverParametersByEntityName;
+
+// Entity name -> entity description for the current model. Never mutated
+// once built, so it's safe to read from any context's queue.
+@property (strong, nonatomic) NSDictionary *entitiesByName;
+
+// Query shape -> compiled predicate with substitution variables in place
+// of values. Guarded by @synchronized on the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *predicateTemplatesByShape;
+
+// Entity name -> property name -> changed key bit index. Built once per
+// model and never mutated, so it's safe to read from any context's queue.
+@property (strong, nonatomic) NSDictionary *changedKeyIndexesByEntityName;
+
 @property (nonatomic) Class identityClass;
 
+// Initialization
+- (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory asynchronously:(BOOL)asynchronously completion:(BCCDataStoreControllerStartupCompletionBlock)completion;
+- (void)finishStartupWithError:(NSError *)error;
+- (BOOL)waitForStartup;
+- (BOOL)isOnStartupQueue;
+
 // Core Data Stack Management
-- (void)initializeCoreDataStack;
-- (void)initializeMainPersistentStore;
+- (BOOL)initializeCoreDataStack:(NSError **)outError;
+- (BOOL)initializeMainPersistentStore:(NSError **)outError;
 - (void)resetCoreDataStack;
 
+// Persistent Store Metadata
+- (void)applyPendingPersistentStoreMetadata;
+
 // Persistent Stores
-- (NSPersistentStore *)newPersistentStoreForCoordinator:(NSPersistentStoreCoordinator *)coordinator path:(NSString *)storePath;
+- (NSPersistentStore *)newPersistentStoreForCoordinator:(NSPersistentStoreCoordinator *)coordinator path:(NSString *)storePath error:(NSError **)outError;
+
+// Queue Management
+- (void)runWorkWithParameters:(BCCDataStoreControllerWorkParameters *)workParameters;
 
 // Saving
 - (void)saveWriteMOC;
 - (void)saveMOC:(NSManagedObjectContext *)managedObjectContext;
+- (void)scheduleMainMOCSave;
+- (void)scheduleWriteCommit;
+- (void)commitWriteMOCAndWait:(BOOL)wait error:(NSError **)outError;
+- (void)applicationWillTerminate:(NSNotification *)notification;
+
+// Fetch Request Creation
++ (NSString *)predicateVariableNameForIndex:(NSUInteger)idx;
++ (NSDictionary *)predicateSubstitutionVariablesForValueList:(NSArray *)valueList;
+- (NSEntityDescription *)entityForName:(NSString *)entityName;
+- (NSPredicate *)predicateTemplateForPropertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames;
 
 // Change Notifications
-- (NSSet *)managedObjects:(NSSet *)managedObjects withUpdatedKeys:(NSSet *)updatedKeys matchingRequiredChangeKeys:(NSArray *)requiredChangeKeys;
-- (NSDictionary *)updatedEntityKeysForMOC:(NSManagedObjectContext *)managedObjectContext;
+- (NSDictionary *)changedKeyIndexesForModel:(NSManagedObjectModel *)managedObjectModel;
+- (uint64_t)changedKeyMaskForKeys:(id<NSFastEnumeration>)keys entityName:(NSString *)entityName;
+- (NSMapTable *)changedKeyMasksForMOC:(NSManagedObjectContext *)managedObjectContext;
+- (NSSet *)managedObjects:(NSSet *)managedObjects withChangedKeyMasks:(NSMapTable *)changedKeyMasks matchingRequiredChangedKeyMask:(uint64_t)requiredChangedKeyMask;
+- (NSMapTable *)committedValuesForObservedObjects:(NSSet *)managedObjects;
+- (NSSet *)managedObjects:(NSSet *)managedObjects withCommittedValues:(NSMapTable *)committedValues matchingPredicate:(NSPredicate *)predicate deleted:(BOOL)deleted;
 - (void)notifyObserversForChangeNotification:(NSNotification *)changeNotification;
+- (void)performTargetActions:(NSArray *)targetActions withChangeNotifications:(NSArray *)changeNotifications;
+- (void)scheduleCoalescedChangesFlushForTargetAction:(BCCDataStoreTargetAction *)targetAction entityName:(NSString *)entityName afterDelay:(NSTimeInterval)delay;
+- (void)flushCoalescedChangesForTargetAction:(BCCDataStoreTargetAction *)targetAction entityName:(NSString *)entityName generation:(NSUInteger)generation;
 
 // Worker MOC Object Caches
-- (NSMutableDictionary *)objectCacheForMOC:(NSManagedObjectContext *)managedObjectContext;
 - (void)clearObjectCacheForMOC:(NSManagedObjectContext *)managedObjectContext;
 - (void)removeCacheObject:(NSManagedObject *)affectedObject;
 
+// Batch Deletion
+- (void)batchDeleteObjectsWithEntityName:(NSString *)entityName predicate:(NSPredicate *)predicate;
+
 // Identity
 - (id)normalizedIdentityValueForValue:(id)value;
 - (NSArray *)normalizedIdentityValueListForList:(NSArray *)valueList;
 - (NSSet *)normalizedIdentityValueSetForSet:(NSSet *)valueSet;
 
-- (NSString *)cacheKeyForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier;
+@end
+
+
+@interface BCCDataStoreControllerObjectCacheEntry : NSObject
+
+@property (strong, nonatomic) NSString *entityName;
+@property (strong, nonatomic) id identityValue;
+@property (strong, nonatomic) id groupKey;
+
+@end
+
+
+@interface BCCDataStoreControllerObjectCache ()
+
+// Entity name -> group identifier (or NSNull) -> identity value -> object
+@property (strong, nonatomic) NSMutableDictionary *entityTables;
+
+// Object -> cache entry, for removal by object. Keyed by object pointer
+// rather than object ID, since an inserted object's temporary ID is
+// replaced when it's saved.
+@property (strong, nonatomic) NSMapTable *entriesByObject;
+
+@property (nonatomic) NSUInteger hitCount;
+@property (nonatomic) NSUInteger missCount;
+
+- (NSMutableDictionary *)identityTableForEntityName:(NSString *)entityName groupKey:(id)groupKey create:(BOOL)create;
+
+@end
+
+
+@interface BCCDataStoreChangeNotification ()
+
+// The same changes with object IDs in place of objects
+- (BCCDataStoreChangeNotification *)objectIDChangeNotification;
+
+@end
+
+
+@interface BCCDataStoreControllerQueryParameters ()
+
+- (void)applyToFetchRequest:(NSFetchRequest *)fetchRequest;
+
+@end
+
+
+@interface BCCDataStoreControllerQueryCursor ()
+
+@property (strong, nonatomic) NSFetchRequest *fetchRequest;
+@property (strong, nonatomic) NSManagedObjectContext *managedObjectContext;
+
+@property (nonatomic) NSUInteger pageSize;
+@property (strong, nonatomic) NSArray *objectIDs;
+@property (nonatomic) NSUInteger offset;
+@property (nonatomic) BOOL hasMoreResults;
+
+- (id)initWithFetchRequest:(NSFetchRequest *)fetchRequest managedObjectContext:(NSManagedObjectContext *)managedObjectContext pageSize:(NSUInteger)pageSize;
+
+@end
+
+
+@interface BCCDataStoreControllerSaveStageStatistics ()
+
+- (void)recordDuration:(NSTimeInterval)duration;
+
+@end
+
+
+@interface BCCDataStoreControllerSaveStatistics ()
+
+@property (nonatomic) NSUInteger lastWriteCommitSaveCount;
+
+@end
+
+
+@interface BCCDataStoreControllerPreparedQuery ()
+
+@property (strong, nonatomic) NSFetchRequest *fetchRequestTemplate;
+
+- (id)initWithFetchRequestTemplate:(NSFetchRequest *)fetchRequestTemplate propertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames;
 
 @end
 
@@ -86,9 +274,89 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 @property (nonatomic, retain) NSPredicate *predicate;
 @property (nonatomic, retain) NSArray *requiredChangedKeys;
+@property (nonatomic, retain) BCCDataStoreControllerObserverParameters *observerParameters;
+
+// requiredChangedKeys as a changed key mask for the observed entity,
+// worked out the first time the observer is considered
+@property (nonatomic) uint64_t requiredChangedKeyMask;
+@property (nonatomic) BOOL requiredChangedKeyMaskLoaded;
+
+// Changes merged since the last coalesced notification. Only touched on
+// the main context's queue.
+@property (strong, nonatomic) NSMutableSet *coalescedInsertedObjects;
+@property (strong, nonatomic) NSMutableSet *coalescedUpdatedObjects;
+@property (strong, nonatomic) NSMutableSet *coalescedDeletedObjects;
+@property (strong, nonatomic) NSMutableSet *coalescedDeletedObjectIDs;
+@property (nonatomic) NSUInteger coalescedSaveCount;
+@property (nonatomic) NSUInteger coalescingGeneration;
+@property (nonatomic) BOOL coalescingFlushScheduled;
 
 + (BCCDataStoreTargetAction *)targetActionForKey:(NSString *)key withTarget:(id)target action:(SEL)action predicate:(NSPredicate *)predicate requiredChangedKeys:(NSArray *)changedKeys;
 
+// Coalescing
+- (BOOL)coalesceInsertedObjects:(NSSet *)insertedObjects updatedObjects:(NSSet *)updatedObjects deletedObjects:(NSSet *)deletedObjects removedObjects:(NSSet *)removedObjects;
+- (BOOL)coalesceDeletedObjectIDs:(NSSet *)deletedObjectIDs;
+- (BCCDataStoreChangeNotification *)takeCoalescedChangeNotification;
+
+@end
+
+
+@interface BCCDataStoreController (JSONSupportPrivate)
+
+// Import
+- (NSArray *)createObjectsFromJSONArray:(NSArray *)dictionaryArray atIndexes:(NSIndexSet *)indexes baseIndex:(NSUInteger)baseIndex usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters affectedIndexes:(NSMutableIndexSet *)affectedIndexes;
+
+// Parallel Import
+- (NSManagedObjectContext *)newImportShardMOC;
+- (void)performWithCurrentMOC:(NSManagedObjectContext *)managedObjectContext block:(void (^)(void))block;
+- (BOOL)saveImportShardMOC:(NSManagedObjectContext *)shardMOC insertedObjectIDs:(NSMutableSet *)insertedObjectIDs updatedObjectIDs:(NSMutableSet *)updatedObjectIDs deletedObjectIDs:(NSMutableSet *)deletedObjectIDs changedKeyMasks:(NSMutableDictionary *)changedKeyMasksByObjectID error:(NSError **)outError;
+- (void)mergeStoreChangesWithInsertedObjectIDs:(NSSet *)insertedObjectIDs updatedObjectIDs:(NSSet *)updatedObjectIDs deletedObjectIDs:(NSSet *)deletedObjectIDs changedKeyMasks:(NSDictionary *)changedKeyMasksByObjectID;
+
+// Streaming Import
+- (NSArray *)importJSONRecordChunk:(NSArray *)records baseIndex:(NSUInteger)baseIndex replacedObjectIDs:(NSArray *)replacedObjectIDs intoMOC:(NSManagedObjectContext *)importMOC usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters error:(NSError **)outError;
+
+@end
+
+
+typedef enum {
+    BCCDataStoreControllerJSONRecordFormatUnknown,
+    BCCDataStoreControllerJSONRecordFormatArray,
+    BCCDataStoreControllerJSONRecordFormatLines
+} BCCDataStoreControllerJSONRecordFormat;
+
+
+// Pulls one JSON object at a time out of a stream holding either a JSON
+// array of objects or newline-delimited objects, without ever holding
+// more than the current record and one read's worth of bytes.
+@interface BCCDataStoreControllerJSONRecordReader : NSObject
+
+@property (strong, nonatomic, readonly) NSInputStream *inputStream;
+@property (nonatomic, readonly) unsigned long long bytesRead;
+
+- (id)initWithInputStream:(NSInputStream *)inputStream;
+
+// Returns nil at the end of the stream or on error. Records that aren't
+// JSON objects are skipped.
+- (NSDictionary *)nextRecord:(NSError **)outError;
+
+@end
+
+
+@interface BCCDataStoreControllerJSONRecordReader ()
+
+@property (strong, nonatomic) NSMutableData *buffer;
+@property (nonatomic) NSUInteger scanOffset;
+@property (nonatomic) NSUInteger recordStart;
+@property (nonatomic) NSUInteger depth;
+@property (nonatomic) BOOL inString;
+@property (nonatomic) BOOL escaped;
+@property (nonatomic) BCCDataStoreControllerJSONRecordFormat format;
+@property (nonatomic) BOOL finished;
+@property (nonatomic) BOOL streamAtEnd;
+
+- (NSData *)scanForRecordData;
+- (BOOL)readMoreBytes:(NSError **)outError;
+
 @end
 
 
@@ -176,23 +444,6 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return normalizedValueSet;
 }
 
-- (NSString *)cacheKeyForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
-{
-    if (!identityValue || !groupIdentifier || !entityName) {
-        return nil;
-    }
-    
-    NSMutableString *keyString = [[NSMutableString alloc] initWithString:entityName];
-    // TO DO: Force to string representation here
-    [keyString appendFormat:@":%@", identityValue];
-    
-    if (groupIdentifier) {
-        [keyString appendFormat:@":%@", groupIdentifier];
-    }
-    
-    return [keyString BCC_MD5String];
-}
-
 #pragma mark - Initialization
 
 - (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath
@@ -205,6 +456,16 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 }
 
 - (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory
+{
+    return [self initWithIdentifier:identifier modelPath:modelPath rootDirectory:rootDirectory asynchronously:NO completion:NULL];
+}
+
+- (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory completion:(BCCDataStoreControllerStartupCompletionBlock)completion
+{
+    return [self initWithIdentifier:identifier modelPath:modelPath rootDirectory:rootDirectory asynchronously:YES completion:completion];
+}
+
+- (id)initWithIdentifier:(NSString *)identifier modelPath:(NSString *)modelPath rootDirectory:(NSString *)rootDirectory asynchronously:(BOOL)asynchronously completion:(BCCDataStoreControllerStartupCompletionBlock)completion
 {
     if (!(self = [super init])) {
         return nil;
@@ -218,23 +479,128 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     
     _workerQueue = NULL;
     
+    _writeCommitLatency = 0.0;
+    _maximumWriteCommitSaveCount = 0;
+    
+    _pendingPersistCompletions = [[NSMutableArray alloc] init];
+    _pendingPersistentStoreMetadata = [[NSMutableDictionary alloc] init];
+    _currentSaveStatistics = [[BCCDataStoreControllerSaveStatistics alloc] init];
+    
 #if TARGET_OS_IPHONE
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(saveMainMOC) name:UIApplicationWillTerminateNotification object:nil];
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(saveMainMOC) name:UIApplicationWillResignActiveNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationWillTerminate:) name:UIApplicationWillTerminateNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationWillTerminate:) name:UIApplicationWillResignActiveNotification object:nil];
 #elif TARGET_OS_MAC
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(saveMainMOC) name:NSApplicationWillTerminateNotification object:nil];
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationWillTerminate:) name:NSApplicationWillTerminateNotification object:nil];
 #endif
     
     self.observerInfo = [[BCCTargetActionQueue alloc] initWithIdentifier:identifier];
+    self.defaultObserverParametersByEntityName = [[NSMutableDictionary alloc] init];
+    self.predicateTemplatesByShape = [[NSMutableDictionary alloc] init];
+    
+    _pendingWorkParameters = [[NSMutableArray alloc] init];
+    
+    if (!asynchronously) {
+        NSError *error = nil;
+        [self finishStartupWithError:([self initializeCoreDataStack:&error] ? nil : error)];
+        
+        return self;
+    }
+    
+    // Opening the store can mean a migration, which can take a while on a
+    // large database. Do it on a queue of our own and hold any work that
+    // comes in until it's done.
+    _startingUp = YES;
+    _startupGroup = dispatch_group_create();
+    
+    NSString *startupName = [NSString stringWithFormat:@"com.brooklyncomputerclub.%@.StartupQueue", NSStringFromClass([self class])];
+    dispatch_queue_t startupQueue = dispatch_queue_create([startupName UTF8String], DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(startupQueue, BCCDataStoreControllerStartupQueueKey, (__bridge void *)self, NULL);
     
-    [self initializeCoreDataStack];
+    dispatch_group_enter(_startupGroup);
+    dispatch_async(startupQueue, ^{
+        NSError *error = nil;
+        if ([self initializeCoreDataStack:&error]) {
+            error = nil;
+        }
+        
+        [self finishStartupWithError:error];
+        dispatch_group_leave(self.startupGroup);
+        
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(self, error);
+            });
+        }
+    });
     
     return self;
 }
 
+- (void)finishStartupWithError:(NSError *)error
+{
+    if (error) {
+        NSLog(@"Unable to start data store controller: %@", error);
+    }
+    
+    // Work queued while we were starting up can queue more, so keep going
+    // until there's none left before letting new work through
+    while (YES) {
+        NSArray *queuedWorkParameters = nil;
+        
+        @synchronized (self.pendingWorkParameters) {
+            if (self.pendingWorkParameters.count < 1) {
+                self.startupError = error;
+                self.ready = (error == nil);
+                self.startingUp = NO;
+                break;
+            }
+            
+            queuedWorkParameters = [self.pendingWorkParameters copy];
+            [self.pendingWorkParameters removeAllObjects];
+        }
+        
+        for (BCCDataStoreControllerWorkParameters *currentWorkParameters in queuedWorkParameters) {
+            if (error) {
+                NSLog(@"Dropping queued work; the data store controller didn't start");
+                continue;
+            }
+            
+            [self runWorkWithParameters:currentWorkParameters];
+        }
+    }
+}
+
+- (BOOL)waitForStartup
+{
+    BOOL startingUp = NO;
+    @synchronized (self.pendingWorkParameters) {
+        startingUp = self.startingUp;
+    }
+    
+    // Work queued during startup runs on the startup queue before the
+    // group is left, so anything it waits on has to go straight through
+    if (!startingUp || [self isOnStartupQueue]) {
+        return YES;
+    }
+    
+    // Startup never needs the main queue, so this is safe there too
+    dispatch_group_wait(self.startupGroup, DISPATCH_TIME_FOREVER);
+    
+    return YES;
+}
+
+- (BOOL)isOnStartupQueue
+{
+    return (dispatch_get_specific(BCCDataStoreControllerStartupQueueKey) == (__bridge void *)self);
+}
+
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
+    if (_observerNotificationQueue) {
+        dispatch_queue_set_specific(_observerNotificationQueue, (__bridge const void *)self, NULL, NULL);
+    }
 
     // This will release the main MOC, managed object model, and
     // persistent store coordinator
@@ -245,6 +611,11 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (void)setIdentifier:(NSString *)identifier
 {
+    // The stack being torn down here is still being built
+    if (![self waitForStartup]) {
+        return;
+    }
+    
     if (![_identifier isEqualToString:identifier]) {
         [self deletePersistentStore];
     }
@@ -254,22 +625,52 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     [self reset];
 }
 
+- (void)setObserverNotificationQueue:(dispatch_queue_t)observerNotificationQueue
+{
+    // Tag the queue so deliveries can tell when they're already on it
+    if (_observerNotificationQueue) {
+        dispatch_queue_set_specific(_observerNotificationQueue, (__bridge const void *)self, NULL, NULL);
+    }
+    
+    _observerNotificationQueue = observerNotificationQueue;
+    
+    if (_observerNotificationQueue) {
+        dispatch_queue_set_specific(_observerNotificationQueue, (__bridge const void *)self, (__bridge void *)_observerNotificationQueue, NULL);
+    }
+}
+
 #pragma mark - Core Data State
 
-- (void)initializeCoreDataStack
+- (BOOL)initializeCoreDataStack:(NSError **)outError
 {
     if (!self.managedObjectModelPath || ![[NSFileManager defaultManager] fileExistsAtPath:self.managedObjectModelPath isDirectory:NULL]) {
         NSLog(@"Unable to locate managed object model at path: %@", self.managedObjectModelPath);
-        return;
+        
+        if (outError) {
+            *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorModelUnavailable userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Unable to locate managed object model", @""), NSFilePathErrorKey: (self.managedObjectModelPath ? self.managedObjectModelPath : @"")}];
+        }
+        
+        return NO;
     }
 
+    // Go through the ivar; the setter deletes the store and resets the stack
     if (!self.identifier) {
-        self.identifier = NSStringFromClass([self class]);
+        _identifier = NSStringFromClass([self class]);
     }
     
     // Set up the managed object model
     NSURL *modelURL = [NSURL fileURLWithPath:self.managedObjectModelPath];
     self.managedObjectModel = [[NSManagedObjectModel alloc] initWithContentsOfURL:modelURL];
+    if (!self.managedObjectModel) {
+        if (outError) {
+            *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorModelUnavailable userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Unable to load managed object model", @""), NSFilePathErrorKey: self.managedObjectModelPath}];
+        }
+        
+        return NO;
+    }
+    
+    self.changedKeyIndexesByEntityName = [self changedKeyIndexesForModel:self.managedObjectModel];
+    self.entitiesByName = [self.managedObjectModel.entitiesByName copy];
     
     // Set up root directory
     if (!self.rootDirectory) {
@@ -284,23 +685,26 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     self.persistentStoreCoordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:self.managedObjectModel];
     
     // Set up the main persistent store
-    [self initializeMainPersistentStore];
+    if (![self initializeMainPersistentStore:outError]) {
+        return NO;
+    }
     
-    // Set up the write MOC
-    NSManagedObjectContext *writeMOC = [self newMOCWithConcurrencyType:NSMainQueueConcurrencyType];
+    // Set up the write MOC. It does all the disk I/O, so it gets a queue
+    // of its own rather than the main queue.
+    NSManagedObjectContext *writeMOC = [self newMOCWithConcurrencyType:NSPrivateQueueConcurrencyType];
     self.writeMOC = writeMOC;
     [self.writeMOC performBlockAndWait:^{
         writeMOC.persistentStoreCoordinator = self.persistentStoreCoordinator;
         writeMOC.mergePolicy = NSOverwriteMergePolicy;
     }];
     
-    // Set up main thread context (for querying)
+    // Set up main thread context (for querying). Setters on queue-based
+    // contexts are safe from any thread, so this doesn't go through the
+    // main queue, which may be blocked waiting for startup.
     NSManagedObjectContext *mainMOC = [self newMOCWithConcurrencyType:NSMainQueueConcurrencyType];
+    mainMOC.parentContext = writeMOC;
+    mainMOC.mergePolicy = NSMergeByPropertyStoreTrumpMergePolicy;
     self.mainMOC = mainMOC;
-    [self.mainMOC performBlockAndWait:^{
-        mainMOC.parentContext = writeMOC;
-        mainMOC.mergePolicy = NSMergeByPropertyStoreTrumpMergePolicy;
-    }];
     
     // Set up background private queue context
     NSManagedObjectContext *backgroundMOC = [self newMOCWithConcurrencyType:NSPrivateQueueConcurrencyType];
@@ -320,16 +724,22 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     self.identityClass = [NSString class];
     
     self.observerInfo.identifier = self.identifier;
+    
+    return YES;
 }
 
-- (void)initializeMainPersistentStore
+- (BOOL)initializeMainPersistentStore:(NSError **)outError
 {
     NSString *persistentStorePath = self.mainPersistentStorePath;
     if (!self.persistentStoreCoordinator || !persistentStorePath) {
-        return;
+        if (outError) {
+            *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorStoreUnavailable userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"No persistent store path", @"")}];
+        }
+        
+        return NO;
     }
     
-    self.mainPersistentStore = [self newPersistentStoreForCoordinator:self.persistentStoreCoordinator path:persistentStorePath];
+    self.mainPersistentStore = [self newPersistentStoreForCoordinator:self.persistentStoreCoordinator path:persistentStorePath error:NULL];
     if (!self.mainPersistentStore) {
         [[NSNotificationCenter defaultCenter] postNotificationName:BCCDataStoreControllerWillClearIncompatibleDatabaseNotification object:self];
         
@@ -337,26 +747,50 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         // delete the existing database and try again.
         [[NSFileManager defaultManager] removeItemAtPath:persistentStorePath error:NULL];
         
-        self.mainPersistentStore = [self newPersistentStoreForCoordinator:self.persistentStoreCoordinator path:persistentStorePath];
+        NSError *error = nil;
+        self.mainPersistentStore = [self newPersistentStoreForCoordinator:self.persistentStoreCoordinator path:persistentStorePath error:&error];
         if (!self.mainPersistentStore) {
             NSLog(@"Could not load database after clearing!");
-            exit(1);
+            
+            if (outError) {
+                NSMutableDictionary *userInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:NSLocalizedString(@"Could not load database after clearing", @""), NSLocalizedDescriptionKey, persistentStorePath, NSFilePathErrorKey, nil];
+                if (error) {
+                    [userInfo setObject:error forKey:NSUnderlyingErrorKey];
+                }
+                
+                *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorStoreUnavailable userInfo:userInfo];
+            }
+            
+            return NO;
         }
         
         [[NSNotificationCenter defaultCenter] postNotificationName:BCCDataStoreControllerDidClearIncompatibleDatabaseNotification object:self];
     }
+    
+    return YES;
 }
 
 #pragma Core Data State
 
 - (void)reset
 {
+    if (![self waitForStartup]) {
+        return;
+    }
+    
     [self resetCoreDataStack];
-    [self initializeCoreDataStack];
+    
+    NSError *error = nil;
+    BOOL initialized = [self initializeCoreDataStack:&error];
+    
+    self.startupError = initialized ? nil : error;
+    self.ready = initialized;
 }
 
 - (void)resetCoreDataStack
 {
+    self.ready = NO;
+    
     [[NSNotificationCenter defaultCenter] removeObserver:self name:NSManagedObjectContextDidSaveNotification object:nil];
     
     if (_workerQueue) {
@@ -380,6 +814,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }
     
     _managedObjectModel = nil;
+    _entitiesByName = nil;
     
     _persistentStoreCoordinator = nil;
     _mainPersistentStore = nil;
@@ -387,7 +822,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (void)deletePersistentStore
 {
-    if (!self.mainPersistentStore) {
+    if (![self waitForStartup] || !self.mainPersistentStore) {
         return;
     }
     
@@ -401,12 +836,94 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     
     [[NSFileManager defaultManager] removeItemAtURL:self.mainPersistentStore.URL error:NULL];
     
+    // Nothing queued for the old store applies to the new one
+    @synchronized (self.pendingPersistentStoreMetadata) {
+        [self.pendingPersistentStoreMetadata removeAllObjects];
+    }
+    
     // Clear out Core Data stack
     [self resetCoreDataStack];
     
     [[NSNotificationCenter defaultCenter] postNotificationName:BCCDataStoreControllerDidClearDatabaseNotification object:self];
 }
 
+#pragma mark - Persistent Store Metadata
+
+- (id)persistentStoreMetadataValueForKey:(NSString *)key
+{
+    NSPersistentStoreCoordinator *coordinator = self.persistentStoreCoordinator;
+    NSPersistentStore *persistentStore = self.mainPersistentStore;
+    
+    if (!key || !coordinator || !persistentStore) {
+        return nil;
+    }
+    
+    @synchronized (self.pendingPersistentStoreMetadata) {
+        id pendingValue = [self.pendingPersistentStoreMetadata objectForKey:key];
+        if (pendingValue) {
+            return (pendingValue == [NSNull null]) ? nil : pendingValue;
+        }
+    }
+    
+    __block id value = nil;
+    [coordinator performBlockAndWait:^{
+        value = [[coordinator metadataForPersistentStore:persistentStore] objectForKey:key];
+    }];
+    
+    return value;
+}
+
+- (void)setPersistentStoreMetadataValue:(id)value forKey:(NSString *)key
+{
+    if (!key || !self.mainPersistentStore) {
+        return;
+    }
+    
+    // Callers like running totals set metadata on every change, so hold
+    // the latest value and hand it to the coordinator once per commit
+    @synchronized (self.pendingPersistentStoreMetadata) {
+        [self.pendingPersistentStoreMetadata setObject:(value ? value : [NSNull null]) forKey:key];
+    }
+}
+
+- (void)applyPendingPersistentStoreMetadata
+{
+    NSDictionary *pendingMetadata = nil;
+    
+    @synchronized (self.pendingPersistentStoreMetadata) {
+        if (self.pendingPersistentStoreMetadata.count < 1) {
+            return;
+        }
+        
+        pendingMetadata = [self.pendingPersistentStoreMetadata copy];
+        [self.pendingPersistentStoreMetadata removeAllObjects];
+    }
+    
+    NSPersistentStoreCoordinator *coordinator = self.persistentStoreCoordinator;
+    NSPersistentStore *persistentStore = self.mainPersistentStore;
+    
+    if (!coordinator || !persistentStore) {
+        return;
+    }
+    
+    [coordinator performBlockAndWait:^{
+        NSMutableDictionary *metadata = [[coordinator metadataForPersistentStore:persistentStore] mutableCopy];
+        if (!metadata) {
+            metadata = [[NSMutableDictionary alloc] init];
+        }
+        
+        [pendingMetadata enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
+            if (value == [NSNull null]) {
+                [metadata removeObjectForKey:key];
+            } else {
+                [metadata setObject:value forKey:key];
+            }
+        }];
+        
+        [coordinator setMetadata:metadata forPersistentStore:persistentStore];
+    }];
+}
+
 #pragma mark - Accessors
 
 - (NSString *)mainPersistentStorePath
@@ -420,7 +937,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 #pragma mark - Persistent Stores
 
-- (NSPersistentStore *)newPersistentStoreForCoordinator:(NSPersistentStoreCoordinator *)coordinator path:(NSString *)storePath
+- (NSPersistentStore *)newPersistentStoreForCoordinator:(NSPersistentStoreCoordinator *)coordinator path:(NSString *)storePath error:(NSError **)outError
 {
     if (!coordinator || !storePath) {
         return nil;
@@ -436,6 +953,11 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     NSPersistentStore *persistentStore = [coordinator addPersistentStoreWithType:NSSQLiteStoreType configuration:nil URL:storeURL options:@{NSSQLitePragmasOption: @{@"journal_mode": @"WAL"}, NSMigratePersistentStoresAutomaticallyOption: @YES, NSInferMappingModelAutomaticallyOption: @YES} error:&error];
     if (!persistentStore) {
         NSLog(@"Error creating persistent store: %@", error);
+        
+        if (outError) {
+            *outError = error;
+        }
+        
         return nil;
     }
     
@@ -450,13 +972,20 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     
     newMOC.undoManager = nil;
     
-    [newMOC.userInfo setObject:[[NSMutableDictionary alloc] init] forKey:BCCDataStoreControllerContextObjectCacheUserInfoKey];
+    [newMOC.userInfo setObject:[[BCCDataStoreControllerObjectCache alloc] init] forKey:BCCDataStoreControllerContextObjectCacheUserInfoKey];
     
     return newMOC;
 }
 
 - (NSManagedObjectContext *)currentMOC
 {
+    // Parallel import shards stand in for the usual contexts while their
+    // work runs
+    NSManagedObjectContext *threadCurrentMOC = [[NSThread currentThread].threadDictionary objectForKey:BCCDataStoreControllerThreadCurrentMOCKey];
+    if (threadCurrentMOC && threadCurrentMOC.persistentStoreCoordinator == self.persistentStoreCoordinator) {
+        return threadCurrentMOC;
+    }
+    
     if (![[NSThread currentThread] isMainThread]) {
         return self.backgroundMOC;
     }
@@ -495,15 +1024,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (void)saveWriteMOC
 {
-    [self.writeMOC performBlockAndWait:^{
-        NSError *error = nil;
-        BOOL success = [self.writeMOC save:&error];
-        
-        if (!success) {
-            NSLog(@"BCCDataStoreController Write MOC Save Exception: %@", error);
-            return;
-        }
-    }];
+    [self commitWriteMOCAndWait:YES error:NULL];
 }
 
 - (void)saveMainMOC
@@ -523,18 +1044,58 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }
     
     void (^saveBlock)(void) = ^{
-        NSDictionary *updatedKeysInfo = [self updatedEntityKeysForMOC:managedObjectContext];
-        if (updatedKeysInfo) {
-            [managedObjectContext.userInfo setObject:updatedKeysInfo forKey:BCCDataStoreControllerCurrentUpdatedKeysUserInfoKey];
+        // Changed and committed values are gone once the save completes,
+        // so capture them now for observers with required changed keys or
+        // predicates. Observers only hear about main MOC saves, which carry
+        // everything saved up from its children, so no other context needs
+        // them.
+        BOOL capturesChangedKeyMasks = (managedObjectContext == self.mainMOC);
+        if (capturesChangedKeyMasks) {
+            NSMapTable *changedKeyMasks = [self changedKeyMasksForMOC:managedObjectContext];
+            if (changedKeyMasks) {
+                [managedObjectContext.userInfo setObject:changedKeyMasks forKey:BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey];
+            }
+            
+            NSMapTable *committedValues = [self committedValuesForObservedObjects:[managedObjectContext.updatedObjects setByAddingObjectsFromSet:managedObjectContext.deletedObjects]];
+            if (committedValues) {
+                [managedObjectContext.userInfo setObject:committedValues forKey:BCCDataStoreControllerCurrentCommittedValuesUserInfoKey];
+            }
         }
         
+        CFAbsoluteTime saveStartTime = CFAbsoluteTimeGetCurrent();
+        
         NSError *error = nil;
         BOOL success = [managedObjectContext save:&error];
         
         if (!success) {
             NSLog(@"BCCDataStoreController MOC Save Exception: %@", error);
+            
+            // No notification will come to pick these up
+            if (capturesChangedKeyMasks) {
+                [managedObjectContext.userInfo removeObjectForKey:BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey];
+                [managedObjectContext.userInfo removeObjectForKey:BCCDataStoreControllerCurrentCommittedValuesUserInfoKey];
+            }
+            
             return;
         }
+        
+        CFAbsoluteTime saveDuration = CFAbsoluteTimeGetCurrent() - saveStartTime;
+        @synchronized (self.currentSaveStatistics) {
+            if (managedObjectContext == self.mainMOC) {
+                [self.currentSaveStatistics.mainSaveStage recordDuration:saveDuration];
+            } else if (managedObjectContext == self.backgroundMOC) {
+                [self.currentSaveStatistics.backgroundSaveStage recordDuration:saveDuration];
+            }
+        }
+        
+        id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+        if (metricsRecorder) {
+            if (managedObjectContext == self.mainMOC) {
+                [metricsRecorder recordDuration:saveDuration forHistogram:BCCDataStoreControllerMetricMainSaveDuration dimension:nil];
+            } else if (managedObjectContext == self.backgroundMOC) {
+                [metricsRecorder recordDuration:saveDuration forHistogram:BCCDataStoreControllerMetricBackgroundSaveDuration dimension:nil];
+            }
+        }
     };
     
     if (managedObjectContext.concurrencyType == NSPrivateQueueConcurrencyType || managedObjectContext.concurrencyType == NSMainQueueConcurrencyType) {
@@ -544,8 +1105,249 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }
 }
 
-#pragma mark - Save Notifications
-
+- (void)scheduleMainMOCSave
+{
+    @synchronized (self.pendingPersistCompletions) {
+        if (self.mainMOCSaveScheduled) {
+            return;
+        }
+        
+        self.mainMOCSaveScheduled = YES;
+    }
+    
+    // Background saves that land before this runs ride along with it
+    [self.mainMOC performBlock:^{
+        @synchronized (self.pendingPersistCompletions) {
+            self.mainMOCSaveScheduled = NO;
+        }
+        
+        [self saveMOC:self.mainMOC];
+    }];
+}
+
+- (void)scheduleWriteCommit
+{
+    BOOL commitNow = NO;
+    BOOL scheduleCommit = NO;
+    
+    @synchronized (self.pendingPersistCompletions) {
+        self.pendingWriteCommitSaveCount++;
+        if (self.pendingWriteCommitSaveCount == 1) {
+            self.firstPendingWriteCommitSaveTime = CFAbsoluteTimeGetCurrent();
+        }
+        
+        if (self.maximumWriteCommitSaveCount > 0 && self.pendingWriteCommitSaveCount >= self.maximumWriteCommitSaveCount) {
+            commitNow = YES;
+        } else if (!self.writeCommitScheduled) {
+            self.writeCommitScheduled = YES;
+            scheduleCommit = YES;
+        }
+    }
+    
+    if (commitNow || (scheduleCommit && self.writeCommitLatency <= 0.0)) {
+        [self commitWriteMOCAndWait:NO error:NULL];
+    } else if (scheduleCommit) {
+        dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, self.writeCommitLatency * NSEC_PER_SEC);
+        dispatch_after(popTime, self.workerQueue, ^{
+            [self commitWriteMOCAndWait:NO error:NULL];
+        });
+    }
+}
+
+- (void)commitWriteMOCAndWait:(BOOL)wait error:(NSError **)outError
+{
+    NSManagedObjectContext *writeMOC = self.writeMOC;
+    if (!writeMOC) {
+        return;
+    }
+    
+    __block NSError *commitError = nil;
+    
+    void (^commitBlock)(void) = ^{
+        NSArray *persistCompletions = nil;
+        NSUInteger commitSaveCount = 0;
+        CFAbsoluteTime firstSaveTime = 0.0;
+        
+        // Everything pushed to the write MOC so far goes out in this
+        // commit, so later commit blocks that were already queued up
+        // will find nothing left to do
+        @synchronized (self.pendingPersistCompletions) {
+            persistCompletions = [self.pendingPersistCompletions copy];
+            [self.pendingPersistCompletions removeAllObjects];
+            
+            commitSaveCount = self.pendingWriteCommitSaveCount;
+            firstSaveTime = self.firstPendingWriteCommitSaveTime;
+            
+            self.pendingWriteCommitSaveCount = 0;
+            self.writeCommitScheduled = NO;
+        }
+        
+        NSError *prepareError = nil;
+        if (writeMOC.hasChanges && ![self prepareToCommitChanges:&prepareError]) {
+            NSLog(@"BCCDataStoreController Write MOC Commit Deferred: %@", prepareError);
+            commitError = prepareError ? prepareError : [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorCommitDeferred userInfo:nil];
+            
+            // The changes are still in the write MOC, so put the saves
+            // back and try again later rather than waiting for another
+            // save to come along
+            NSTimeInterval retryDelay = 0.0;
+            
+            @synchronized (self.pendingPersistCompletions) {
+                if (self.pendingWriteCommitSaveCount < 1) {
+                    self.firstPendingWriteCommitSaveTime = (commitSaveCount > 0) ? firstSaveTime : CFAbsoluteTimeGetCurrent();
+                }
+                
+                self.pendingWriteCommitSaveCount += MAX(commitSaveCount, (NSUInteger)1);
+                
+                if (!self.writeCommitScheduled) {
+                    self.writeCommitScheduled = YES;
+                    
+                    retryDelay = MIN(MAX(self.writeCommitRetryDelay * 2.0, BCCDataStoreControllerMinimumWriteCommitRetryDelay), BCCDataStoreControllerMaximumWriteCommitRetryDelay);
+                    self.writeCommitRetryDelay = retryDelay;
+                }
+            }
+            
+            if (retryDelay > 0.0) {
+                dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, retryDelay * NSEC_PER_SEC);
+                dispatch_after(popTime, self.workerQueue, ^{
+                    [self commitWriteMOCAndWait:NO error:NULL];
+                });
+            }
+        } else {
+            @synchronized (self.pendingPersistCompletions) {
+                self.writeCommitRetryDelay = 0.0;
+            }
+            
+            // Metadata goes out in the same transaction as the rows it
+            // describes, so it waits out deferred commits along with them
+            [self applyPendingPersistentStoreMetadata];
+        }
+        
+        if (!commitError && writeMOC.hasChanges) {
+            CFAbsoluteTime commitStartTime = CFAbsoluteTimeGetCurrent();
+            
+            NSError *error = nil;
+            if (![writeMOC save:&error]) {
+                NSLog(@"BCCDataStoreController Write MOC Save Exception: %@", error);
+                commitError = error;
+            }
+            
+            CFAbsoluteTime commitEndTime = CFAbsoluteTimeGetCurrent();
+            @synchronized (self.currentSaveStatistics) {
+                [self.currentSaveStatistics.writeCommitStage recordDuration:(commitEndTime - commitStartTime)];
+                
+                if (commitSaveCount > 0) {
+                    [self.currentSaveStatistics.writeCommitQueueStage recordDuration:(commitStartTime - firstSaveTime)];
+                    self.currentSaveStatistics.lastWriteCommitSaveCount = commitSaveCount;
+                }
+            }
+            
+            id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+            if (metricsRecorder) {
+                [metricsRecorder recordDuration:(commitEndTime - commitStartTime) forHistogram:BCCDataStoreControllerMetricWriteCommitDuration dimension:nil];
+                
+                if (commitSaveCount > 0) {
+                    [metricsRecorder recordDuration:(commitStartTime - firstSaveTime) forHistogram:BCCDataStoreControllerMetricWriteCommitQueueDuration dimension:nil];
+                }
+            }
+        }
+        
+        if (persistCompletions.count < 1) {
+            return;
+        }
+        
+        NSError *completionError = commitError;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (BCCDataStoreControllerPersistCompletionBlock currentCompletion in persistCompletions) {
+                currentCompletion(completionError);
+            }
+        });
+    };
+    
+    if (wait) {
+        [writeMOC performBlockAndWait:commitBlock];
+    } else {
+        [writeMOC performBlock:commitBlock];
+    }
+    
+    if (outError) {
+        *outError = commitError;
+    }
+}
+
+- (BOOL)prepareToCommitChanges:(NSError **)error
+{
+    return YES;
+}
+
+- (void)persistChangesWithCompletion:(BCCDataStoreControllerPersistCompletionBlock)completion
+{
+    NSManagedObjectContext *mainMOC = self.mainMOC;
+    if (!mainMOC) {
+        return;
+    }
+    
+    [mainMOC performBlock:^{
+        [self saveMOC:mainMOC];
+        
+        // The main MOC save has already pushed everything to the write
+        // MOC, so the next commit on its queue covers this request
+        if (completion) {
+            @synchronized (self.pendingPersistCompletions) {
+                [self.pendingPersistCompletions addObject:[completion copy]];
+            }
+        }
+        
+        [self commitWriteMOCAndWait:NO error:NULL];
+    }];
+}
+
+- (BOOL)persistChangesAndWait:(NSError **)error
+{
+    NSManagedObjectContext *mainMOC = [self waitForStartup] ? self.mainMOC : nil;
+    if (!mainMOC) {
+        if (error) {
+            *error = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorStoreUnavailable userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"The persistent store isn't open", @"")}];
+        }
+        
+        return NO;
+    }
+    
+    [mainMOC performBlockAndWait:^{
+        [self saveMOC:mainMOC];
+    }];
+    
+    NSError *commitError = nil;
+    [self commitWriteMOCAndWait:YES error:&commitError];
+    
+    if (error) {
+        *error = commitError;
+    }
+    
+    return (commitError == nil);
+}
+
+- (BCCDataStoreControllerSaveStatistics *)saveStatistics
+{
+    @synchronized (self.currentSaveStatistics) {
+        return [self.currentSaveStatistics copy];
+    }
+}
+
+- (void)resetSaveStatistics
+{
+    @synchronized (self.currentSaveStatistics) {
+        self.currentSaveStatistics = [[BCCDataStoreControllerSaveStatistics alloc] init];
+    }
+}
+
+- (void)applicationWillTerminate:(NSNotification *)notification
+{
+    [self persistChangesAndWait:NULL];
+}
+
+#pragma mark - Save Notifications
+
 - (void)backgroundMOCDidSave:(NSNotification *)notification
 {
     NSManagedObjectContext *changedMOC = notification.object;
@@ -553,7 +1355,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return;
     }
     
-    [self saveMainMOC];
+    [self scheduleMainMOCSave];
 }
 
 - (void)mainMOCDidSave:(NSNotification *)notification
@@ -563,7 +1365,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return;
     }
 
-    [self saveWriteMOC];
+    [self scheduleWriteCommit];
     
     [self.mainMOC performBlockAndWait:^{
         [self notifyObserversForChangeNotification:notification];
@@ -573,6 +1375,46 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 #pragma mark - Queue Management
 
 - (void)performWorkWithParameters:(BCCDataStoreControllerWorkParameters *)workParameters
+{
+    if (!workParameters.workBlock) {
+        return;
+    }
+    
+    BCCDataStoreControllerWorkExecutionStyle workExecutionStyle = workParameters.workExecutionStyle;
+    BOOL wait = (workExecutionStyle == BCCDataStoreControllerWorkExecutionStyleMainMOCAndWait || workExecutionStyle == BCCDataStoreControllerWorkExecutionStyleBackgroundMOCAndWait || workExecutionStyle == BCCDataStoreControllerWorkExecutionStyleThreadMOCAndWait);
+    
+    // While the store is still opening, work is queued and run in order
+    // once it's done. Waiting callers wait for startup instead, on any
+    // thread, so their blocks have always run by the time they return.
+    BOOL waitForStartup = NO;
+    BOOL onStartupQueue = [self isOnStartupQueue];
+    
+    @synchronized (self.pendingWorkParameters) {
+        if (self.startingUp && !onStartupQueue) {
+            if (!wait) {
+                [self.pendingWorkParameters addObject:workParameters];
+                return;
+            }
+            
+            waitForStartup = YES;
+        }
+    }
+    
+    if (waitForStartup) {
+        dispatch_group_wait(self.startupGroup, DISPATCH_TIME_FOREVER);
+    }
+    
+    // Queued work runs on the startup queue just before the controller is
+    // marked ready, and work it submits runs right along with it
+    if (!self.ready && !onStartupQueue) {
+        NSLog(@"Dropping work; the data store controller isn't ready: %@", self.startupError);
+        return;
+    }
+    
+    [self runWorkWithParameters:workParameters];
+}
+
+- (void)runWorkWithParameters:(BCCDataStoreControllerWorkParameters *)workParameters
 {
     BCCDataStoreControllerWorkBlock workBlock = workParameters.workBlock;
     BCCDataStoreControllerWorkBlock postSaveBlock = workParameters.postSaveBlock;
@@ -602,12 +1444,19 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }
     
     void (^metaBlock)(void) = ^(void) {
-        workBlock(self, managedObjectContext, workParameters);
+        id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+        NSString *contextLabel = (managedObjectContext == self.mainMOC) ? @"main" : @"background";
         
-        NSMutableDictionary *contextObjectCache = [self objectCacheForMOC:managedObjectContext];
-        if (contextObjectCache) {
-            [contextObjectCache removeAllObjects];
-        }
+        CFAbsoluteTime workStartTime = metricsRecorder ? CFAbsoluteTimeGetCurrent() : 0.0;
+        uint64_t traceSpan = self.tracesWorkBlocks ? [BCCDataStoreControllerMetrics beginTraceSpanWithLabel:contextLabel] : 0;
+        
+        // Waiting variants run on the caller's thread, so make sure the
+        // convenience fetch methods use the context we were asked for
+        [self performWithCurrentMOC:managedObjectContext block:^{
+            workBlock(self, managedObjectContext, workParameters);
+        }];
+        
+        [self clearObjectCacheForMOC:managedObjectContext];
         
         if (save) {
             [self saveMOC:managedObjectContext];
@@ -616,6 +1465,12 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
                 postSaveBlock(self, managedObjectContext, workParameters);
             }
         }
+        
+        [BCCDataStoreControllerMetrics endTraceSpan:traceSpan];
+        
+        if (metricsRecorder) {
+            [metricsRecorder recordDuration:(CFAbsoluteTimeGetCurrent() - workStartTime) forHistogram:BCCDataStoreControllerMetricWorkBlockDuration dimension:contextLabel];
+        }
     };
     
     void (^executionBlock)(void) = ^(void) {
@@ -674,7 +1529,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 - (void)performBlockOnBackgroundMOCAndWait:(BCCDataStoreControllerWorkBlock)block
 {
     BCCDataStoreControllerWorkParameters *workParameters = [[BCCDataStoreControllerWorkParameters alloc] init];
-    workParameters.workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleMainMOCAndWait;
+    workParameters.workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleBackgroundMOCAndWait;
     workParameters.workBlock = block;
     
     [self performWorkWithParameters:workParameters];
@@ -712,7 +1567,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (void)clearObjectCacheForMOC:(NSManagedObjectContext *)managedObjectContext
 {
-    NSMutableDictionary *objectCache = [self objectCacheForMOC:managedObjectContext];
+    BCCDataStoreControllerObjectCache *objectCache = [self objectCacheForMOC:managedObjectContext];
     if (!objectCache) {
         return;
     }
@@ -720,7 +1575,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     [objectCache removeAllObjects];
 }
 
-- (NSMutableDictionary *)objectCacheForMOC:(NSManagedObjectContext *)managedObjectContext
+- (BCCDataStoreControllerObjectCache *)objectCacheForMOC:(NSManagedObjectContext *)managedObjectContext
 {
     if (!managedObjectContext) {
         return nil;
@@ -735,11 +1590,11 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     NSString *identityPropertyName = identityParameters.identityPropertyName;
     NSString *groupPropertyName = identityParameters.groupPropertyName;
     
-    if (!managedObjectContext || !cacheObject || !identityPropertyName) {
+    if (!managedObjectContext || !cacheObject || !entityName || !identityPropertyName) {
         return;
     }
     
-    id identityValue = [cacheObject valueForKey:identityPropertyName];
+    id identityValue = [self normalizedIdentityValueForValue:[cacheObject valueForKey:identityPropertyName]];
     if (!identityValue) {
         return;
     }
@@ -749,23 +1604,8 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         groupIdentifier = [cacheObject valueForKey:groupPropertyName];
     }
 
-    NSMutableDictionary *objectCache = [self objectCacheForMOC:managedObjectContext];
-    if (!objectCache) {
-        return;
-    }
-    
-    NSMutableDictionary *dictionaryForEntity = [objectCache objectForKey:entityName];
-    if (!dictionaryForEntity) {
-        dictionaryForEntity = [[NSMutableDictionary alloc] init];
-        [objectCache setObject:dictionaryForEntity forKey:entityName];
-    }
-    
-    NSString *cacheKey = [self cacheKeyForEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
-    if (!cacheKey) {
-        return;
-    }
-    
-    [dictionaryForEntity setObject:cacheObject forKey:cacheKey];
+    BCCDataStoreControllerObjectCache *objectCache = [self objectCacheForMOC:managedObjectContext];
+    [objectCache setObject:cacheObject forEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
 }
 
 - (NSManagedObject *)cacheObjectForMOC:(NSManagedObjectContext *)managedObjectContext identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
@@ -776,23 +1616,21 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return nil;
     }
     
-    NSDictionary *objectCache = [self objectCacheForMOC:managedObjectContext];
-    if (!objectCache) {
-        return nil;
+    // Objects are only cached under their group when the entity
+    // actually has a group property
+    if (!identityParameters.groupPropertyName) {
+        groupIdentifier = nil;
     }
     
-    NSDictionary *dictionaryForEntity = [objectCache objectForKey:entityName];
-    if (!dictionaryForEntity) {
-        return nil;
-    }
+    BCCDataStoreControllerObjectCache *objectCache = [self objectCacheForMOC:managedObjectContext];
+    NSManagedObject *cacheObject = [objectCache objectForEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
     
-    NSString *cacheKey = [self cacheKeyForEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
-    if (!cacheKey) {
-        return nil;
+    id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+    if (metricsRecorder && objectCache) {
+        [metricsRecorder incrementCounter:(cacheObject ? BCCDataStoreControllerMetricObjectCacheHits : BCCDataStoreControllerMetricObjectCacheMisses) dimension:entityName by:1];
     }
     
-    NSManagedObject *object = [dictionaryForEntity objectForKey:cacheKey];
-    return object;
+    return cacheObject;
 }
 
 - (void)removeCacheObjectForMOC:(NSManagedObjectContext *)managedObjectContext identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
@@ -803,61 +1641,27 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return;
     }
     
-    NSDictionary *objectCache = [self objectCacheForMOC:managedObjectContext];
+    BCCDataStoreControllerObjectCache *objectCache = [self objectCacheForMOC:managedObjectContext];
     if (!objectCache) {
         return;
     }
     
-    NSMutableDictionary *dictionaryForEntity = [objectCache objectForKey:entityName];
-    if (!dictionaryForEntity) {
-        return;
-    }
-    
     if (!identityValue) {
-        [self setValue:[[NSMutableDictionary alloc] init] forKey:entityName];
+        [objectCache removeAllObjectsForEntityName:entityName];
         return;
     }
     
-    NSString *cacheKey = [self cacheKeyForEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
-    if (!cacheKey) {
-        return;
+    if (!identityParameters.groupPropertyName) {
+        groupIdentifier = nil;
     }
     
-    [dictionaryForEntity removeObjectForKey:cacheKey];
+    [objectCache removeObjectForEntityName:entityName identityValue:identityValue groupIdentifier:groupIdentifier];
 }
 
 - (void)removeCacheObject:(NSManagedObject *)affectedObject
 {
-    NSManagedObjectContext *managedObjectContext = affectedObject.managedObjectContext;
-    
-    NSDictionary *objectCache = [self objectCacheForMOC:managedObjectContext];
-    if (!objectCache) {
-        return;
-    }
-    
-    NSString *entityName = affectedObject.entity.name;
-    
-    NSMutableDictionary *dictionaryForEntity = [objectCache objectForKey:entityName];
-    if (!dictionaryForEntity) {
-        return;
-    }
-    
-    NSMutableArray *keysToRemove = [[NSMutableArray alloc] init];
-    
-    [dictionaryForEntity enumerateKeysAndObjectsUsingBlock:^(id  _Nonnull key, id  _Nonnull obj, BOOL * _Nonnull stop) {
-        NSManagedObject *currentCacheObject = (NSManagedObject *)obj;
-        
-        if (currentCacheObject != affectedObject) {
-            return;
-        }
-        
-        [keysToRemove addObject:key];
-    }];
-    
-    if (keysToRemove.count > 1) {
-        [dictionaryForEntity removeObjectsForKeys:keysToRemove];
-        [objectCache setValue:dictionaryForEntity forKey:entityName];
-    }
+    BCCDataStoreControllerObjectCache *objectCache = [self objectCacheForMOC:affectedObject.managedObjectContext];
+    [objectCache removeObject:affectedObject];
 }
 
 #pragma mark - Entity CRUD
@@ -956,6 +1760,57 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return object;
 }
 
+- (NSDictionary *)existingObjectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValueList:(NSArray *)identityValues groupIdentifier:(NSString *)groupIdentifier batchSize:(NSUInteger)batchSize
+{
+    NSString *identityPropertyName = identityParameters.identityPropertyName;
+    
+    if (!identityParameters.entityName || !identityPropertyName || identityValues.count < 1) {
+        return nil;
+    }
+    
+    if (batchSize < 1) {
+        batchSize = BCCDataStoreControllerDefaultFindExistingBatchSize;
+    }
+    
+    // Normalize and de-duplicate up front so each value
+    // is only ever sent to the store once
+    NSMutableOrderedSet *normalizedValueSet = [[NSMutableOrderedSet alloc] initWithCapacity:identityValues.count];
+    for (id currentValue in identityValues) {
+        id currentNormalizedValue = [self normalizedIdentityValueForValue:currentValue];
+        if (!currentNormalizedValue) {
+            continue;
+        }
+        
+        [normalizedValueSet addObject:currentNormalizedValue];
+    }
+    
+    NSArray *normalizedValueList = normalizedValueSet.array;
+    NSMutableDictionary *existingObjects = [[NSMutableDictionary alloc] initWithCapacity:normalizedValueList.count];
+    
+    NSManagedObjectContext *moc = [self currentMOC];
+    
+    for (NSUInteger batchStart = 0; batchStart < normalizedValueList.count; batchStart += batchSize) {
+        NSUInteger currentBatchSize = MIN(batchSize, normalizedValueList.count - batchStart);
+        NSArray *batchValues = [normalizedValueList subarrayWithRange:NSMakeRange(batchStart, currentBatchSize)];
+        
+        NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters identityValueList:batchValues groupIdentifier:groupIdentifier sortDescriptors:nil];
+        fetchRequest.returnsObjectsAsFaults = NO;
+        
+        NSArray *results = [self performFetchRequest:fetchRequest error:NULL];
+        for (NSManagedObject *currentObject in results) {
+            id currentIdentityValue = [self normalizedIdentityValueForValue:[currentObject valueForKey:identityPropertyName]];
+            if (!currentIdentityValue || [existingObjects objectForKey:currentIdentityValue]) {
+                continue;
+            }
+            
+            [existingObjects setObject:currentObject forKey:currentIdentityValue];
+            [self setCacheObject:currentObject forMOC:moc identityParameters:identityParameters];
+        }
+    }
+    
+    return existingObjects;
+}
+
 - (void)deleteObjectWithIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
 {
     if (!identityParameters) {
@@ -989,14 +1844,17 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return;
     }
     
+    if (self.usesBatchDeleteRequests) {
+        [self batchDeleteObjectsWithEntityName:entityName predicate:[NSPredicate predicateWithFormat:@"%K == %@", groupPropertyName, groupIdentifer]];
+        return;
+    }
+    
     NSArray *affectedObjects = [self performFetchOfEntityWithName:entityName byProperty:groupPropertyName valueList:@[groupIdentifer] sortDescriptors:nil error:NULL];
     
     for (NSManagedObject *currentObject in affectedObjects) {
         NSManagedObjectContext *context = currentObject.managedObjectContext;
         
-        id currentIDValue = [currentObject valueForKey:identityPropertyName];
-        id normalizedIDValue = [self normalizedIdentityValueForValue:currentIDValue];
-        [self removeCacheObjectForMOC:currentObject.managedObjectContext identityParameters:identityParameters identityValue:normalizedIDValue groupIdentifier:nil];
+        [self removeCacheObject:currentObject];
         
         [context deleteObject:currentObject];
     }
@@ -1004,24 +1862,26 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (void)deleteObjectsWithEntityName:(NSString *)entityName identityProperty:(NSString *)identityPropertyName valueList:(NSArray *)valueList
  {
-     if (!entityName || identityPropertyName || valueList.count < 1) {
+     if (!entityName || !identityPropertyName || valueList.count < 1) {
          return;
      }
      
      NSArray *normalizedValueList = [self normalizedIdentityValueListForList:valueList];
+     
+     if (self.usesBatchDeleteRequests) {
+         [self batchDeleteObjectsWithEntityName:entityName predicate:[NSPredicate predicateWithFormat:@"%K IN %@", identityPropertyName, normalizedValueList]];
+         return;
+     }
+     
      NSArray *objectList = [self performFetchOfEntityWithName:entityName byProperty:identityPropertyName valueList:normalizedValueList sortDescriptors:nil error:NULL];
      if (objectList.count < 1) {
          return;
      }
      
-     BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
-     
      for (NSManagedObject *currentObject in objectList) {
          NSManagedObjectContext *context = currentObject.managedObjectContext;
          
-         id currentIDValue = [currentObject valueForKey:identityPropertyName];
-         id normalizedIDValue = [self normalizedIdentityValueForValue:currentIDValue];
-         [self removeCacheObjectForMOC:currentObject.managedObjectContext identityParameters:identityParameters identityValue:normalizedIDValue groupIdentifier:nil];
+         [self removeCacheObject:currentObject];
          
          [context deleteObject:currentObject];
      }
@@ -1033,6 +1893,11 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         return;
     }
     
+    if (self.usesBatchDeleteRequests) {
+        [self batchDeleteObjectsWithEntityName:entityName predicate:nil];
+        return;
+    }
+    
     NSManagedObjectContext *context = [self currentMOC];
     
     BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
@@ -1045,6 +1910,25 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }];
 }
 
+- (void)deleteObjectsWithEntityName:(NSString *)entityName matchingPredicate:(NSPredicate *)predicate
+{
+    if (!entityName) {
+        return;
+    }
+    
+    if (self.usesBatchDeleteRequests) {
+        [self batchDeleteObjectsWithEntityName:entityName predicate:predicate];
+        return;
+    }
+    
+    NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:nil];
+    fetchRequest.predicate = predicate;
+    fetchRequest.includesPropertyValues = NO;
+    
+    NSArray *affectedObjects = [self performFetchRequest:fetchRequest error:NULL];
+    [self deleteObjects:affectedObjects];
+}
+
 - (void)deleteObjects:(NSArray *)affectedObjects
 {
     for (NSManagedObject *currentObject in affectedObjects) {
@@ -1053,36 +1937,107 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     }
 }
 
-#pragma mark - Query by Entity
-
-- (NSArray *)objectsForEntityWithName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors
-{
-    NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:sortDescriptors];
-    return [self performFetchRequest:fetchRequest error:NULL];
-}
-
-- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors
-{
-    return [self objectsForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:nil valueSet:nil sortDescriptors:sortDescriptors];
-}
+#pragma mark - Batch Deletion
 
-- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors
+- (void)batchDeleteObjectsWithEntityName:(NSString *)entityName predicate:(NSPredicate *)predicate
 {
-    if (!identityParameters.entityName) {
-        return nil;
-    }
-    
-    NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters identityValue:nil groupIdentifier:groupIdentifier sortDescriptors:sortDescriptors];
-
-    NSArray *fullObjectList = [self performFetchRequest:fetchRequest error:NULL];
+    NSManagedObjectContext *context = [self currentMOC];
     
-    if (!propertyName || valueSet.count < 1) {
-        return fullObjectList;
+    NSEntityDescription *entity = [NSEntityDescription entityForName:entityName inManagedObjectContext:context];
+    if (!entity) {
+        return;
     }
     
-    NSSet *normalizedValueSet = [self normalizedIdentityValueSetForSet:valueSet];
-    if (!normalizedValueSet) {
-        return nil;
+    // Unsaved inserts aren't in the store for the batch request to find,
+    // so they're deleted the ordinary way
+    for (NSManagedObject *currentObject in [context.insertedObjects copy]) {
+        if (![currentObject.entity isKindOfEntity:entity] || (predicate && ![predicate evaluateWithObject:currentObject])) {
+            continue;
+        }
+        
+        [self removeCacheObject:currentObject];
+        [context deleteObject:currentObject];
+    }
+    
+    NSFetchRequest *fetchRequest = [NSFetchRequest fetchRequestWithEntityName:entityName];
+    fetchRequest.predicate = predicate;
+    
+    NSBatchDeleteRequest *deleteRequest = [[NSBatchDeleteRequest alloc] initWithFetchRequest:fetchRequest];
+    deleteRequest.resultType = NSBatchDeleteResultTypeObjectIDs;
+    
+    NSManagedObjectContext *deleteMOC = [self newImportShardMOC];
+    __block NSArray *deletedObjectIDs = nil;
+    
+    [deleteMOC performBlockAndWait:^{
+        NSError *error = nil;
+        NSBatchDeleteResult *deleteResult = (NSBatchDeleteResult *)[deleteMOC executeRequest:deleteRequest error:&error];
+        if (!deleteResult) {
+            NSLog(@"BCCDataStoreController Batch Delete Exception: %@", error);
+            return;
+        }
+        
+        deletedObjectIDs = deleteResult.result;
+    }];
+    
+    if (deletedObjectIDs.count < 1) {
+        return;
+    }
+    
+    // We don't know which identity values went away without fetching
+    // them, so drop the entity from the worker caches wholesale
+    [[self objectCacheForMOC:context] removeAllObjectsForEntityName:entityName];
+    
+    for (NSManagedObjectContext *currentContext in @[self.mainMOC, self.backgroundMOC]) {
+        if (currentContext == context) {
+            continue;
+        }
+        
+        [currentContext performBlock:^{
+            [[self objectCacheForMOC:currentContext] removeAllObjectsForEntityName:entityName];
+        }];
+    }
+    
+    // Fold the deletions into every context that might be holding on to
+    // the objects, then let observers know
+    NSSet *deletedObjectIDSet = [NSSet setWithArray:deletedObjectIDs];
+    
+    if (context != self.writeMOC && context != self.mainMOC && context != self.backgroundMOC) {
+        [NSManagedObjectContext mergeChangesFromRemoteContextSave:@{NSDeletedObjectsKey: deletedObjectIDs} intoContexts:@[context]];
+    }
+    
+    [self mergeStoreChangesWithInsertedObjectIDs:[NSSet set] updatedObjectIDs:[NSSet set] deletedObjectIDs:deletedObjectIDSet changedKeyMasks:@{}];
+}
+
+#pragma mark - Query by Entity
+
+- (NSArray *)objectsForEntityWithName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:sortDescriptors];
+    return [self performFetchRequest:fetchRequest error:NULL];
+}
+
+- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors
+{
+    return [self objectsForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:nil valueSet:nil sortDescriptors:sortDescriptors];
+}
+
+- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors
+{
+    if (!identityParameters.entityName) {
+        return nil;
+    }
+    
+    NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters identityValue:nil groupIdentifier:groupIdentifier sortDescriptors:sortDescriptors];
+
+    NSArray *fullObjectList = [self performFetchRequest:fetchRequest error:NULL];
+    
+    if (!propertyName || valueSet.count < 1) {
+        return fullObjectList;
+    }
+    
+    NSSet *normalizedValueSet = [self normalizedIdentityValueSetForSet:valueSet];
+    if (!normalizedValueSet) {
+        return nil;
     }
     
     NSMutableArray *affectedObjects = [[NSMutableArray alloc] init];
@@ -1101,6 +2056,36 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return affectedObjects;
 }
 
+- (NSArray *)objectsForEntityWithName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:sortDescriptors];
+    return [self performFetchRequest:fetchRequest queryParameters:queryParameters error:NULL];
+}
+
+- (NSArray *)objectsForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:propertyName valueSet:valueSet sortDescriptors:sortDescriptors];
+    return [self performFetchRequest:fetchRequest queryParameters:queryParameters error:NULL];
+}
+
+- (NSUInteger)countForEntityWithName:(NSString *)entityName
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:nil];
+    return [self countForFetchRequest:fetchRequest error:NULL];
+}
+
+- (NSUInteger)countForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:propertyName valueSet:valueSet sortDescriptors:nil];
+    return [self countForFetchRequest:fetchRequest error:NULL];
+}
+
+- (BCCDataStoreControllerQueryCursor *)queryCursorForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors pageSize:(NSUInteger)pageSize queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters
+{
+    NSFetchRequest *fetchRequest = [self fetchRequestForIdentityParameters:identityParameters identityValue:nil groupIdentifier:groupIdentifier sortDescriptors:sortDescriptors];
+    return [self queryCursorForFetchRequest:fetchRequest pageSize:pageSize queryParameters:queryParameters];
+}
+
 #pragma mark - Fetching
 
 - (NSManagedObject *)performSingleResultFetchForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier error:(NSError **)error
@@ -1129,7 +2114,7 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     fetchRequest.fetchBatchSize = 1;
     
     NSArray *results = [self performFetchRequest:fetchRequest error:error];
-    if (error) {
+    if (error && *error) {
         NSLog(@"Error for single result fetch request %@: %@", fetchRequest, *error);
     }
     
@@ -1177,22 +2162,107 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return [self performFetchRequest:fetchRequest error:error];
 }
 
+- (NSArray *)performFetchWithPreparedQuery:(BCCDataStoreControllerPreparedQuery *)preparedQuery valueList:(NSArray *)valueList error:(NSError **)error
+{
+    NSFetchRequest *fetchRequest = [preparedQuery fetchRequestWithValueList:valueList];
+    if (!fetchRequest) {
+        return nil;
+    }
+    
+    return [self performFetchRequest:fetchRequest error:error];
+}
+
+- (NSManagedObject *)performSingleResultFetchWithPreparedQuery:(BCCDataStoreControllerPreparedQuery *)preparedQuery valueList:(NSArray *)valueList error:(NSError **)error
+{
+    NSFetchRequest *fetchRequest = [preparedQuery fetchRequestWithValueList:valueList];
+    if (!fetchRequest) {
+        return nil;
+    }
+    
+    return [self performSingleResultFetchRequest:fetchRequest error:error];
+}
+
 - (NSArray *)performFetchRequest:(NSFetchRequest *)fetchRequest error:(NSError **)error
 {
     if (!fetchRequest) {
         return nil;
     }
     
-    error = NULL;
+    NSError *fetchError = nil;
+    
+    id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+    CFAbsoluteTime fetchStartTime = metricsRecorder ? CFAbsoluteTimeGetCurrent() : 0.0;
+    
+    NSArray *results = [[self currentMOC] executeFetchRequest:fetchRequest error:&fetchError];
+    
+    if (metricsRecorder) {
+        [metricsRecorder recordDuration:(CFAbsoluteTimeGetCurrent() - fetchStartTime) forHistogram:BCCDataStoreControllerMetricFetchDuration dimension:fetchRequest.entityName];
+    }
+    
+    if (!results) {
+        NSLog(@"Error for fetch request %@: %@", fetchRequest, fetchError);
+    }
     
-    NSArray *results = [[self currentMOC] executeFetchRequest:fetchRequest error:error];
     if (error) {
-        NSLog(@"Error for fetch request %@: %@", fetchRequest, *error);
+        *error = fetchError;
     }
     
     return results;
 }
 
+- (NSArray *)performFetchRequest:(NSFetchRequest *)fetchRequest queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters error:(NSError **)error
+{
+    if (!fetchRequest) {
+        return nil;
+    }
+    
+    if (queryParameters) {
+        fetchRequest = [fetchRequest copy];
+        [queryParameters applyToFetchRequest:fetchRequest];
+    }
+    
+    return [self performFetchRequest:fetchRequest error:error];
+}
+
+- (NSUInteger)countForFetchRequest:(NSFetchRequest *)fetchRequest error:(NSError **)error
+{
+    if (!fetchRequest) {
+        return NSNotFound;
+    }
+    
+    NSError *fetchError = nil;
+    
+    id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+    CFAbsoluteTime fetchStartTime = metricsRecorder ? CFAbsoluteTimeGetCurrent() : 0.0;
+    
+    NSUInteger count = [[self currentMOC] countForFetchRequest:fetchRequest error:&fetchError];
+    
+    if (metricsRecorder) {
+        [metricsRecorder recordDuration:(CFAbsoluteTimeGetCurrent() - fetchStartTime) forHistogram:BCCDataStoreControllerMetricCountFetchDuration dimension:fetchRequest.entityName];
+    }
+    if (count == NSNotFound) {
+        NSLog(@"Error for count fetch request %@: %@", fetchRequest, fetchError);
+    }
+    
+    if (error) {
+        *error = fetchError;
+    }
+    
+    return count;
+}
+
+- (BCCDataStoreControllerQueryCursor *)queryCursorForFetchRequest:(NSFetchRequest *)fetchRequest pageSize:(NSUInteger)pageSize queryParameters:(BCCDataStoreControllerQueryParameters *)queryParameters
+{
+    if (!fetchRequest || pageSize < 1) {
+        return nil;
+    }
+    
+    fetchRequest = [fetchRequest copy];
+    [queryParameters applyToFetchRequest:fetchRequest];
+    
+    return [[BCCDataStoreControllerQueryCursor alloc] initWithFetchRequest:fetchRequest managedObjectContext:[self currentMOC] pageSize:pageSize];
+}
+
 #pragma mark - Fetch Request Creation
 
 - (NSFetchRequest *)fetchRequestForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier sortDescriptors:(NSArray *)sortDescriptors
@@ -1238,13 +2308,55 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return [self fetchRequestForEntityName:entityName usingPropertyList:propertyList valueList:valueList sortDescriptors:sortDescriptors];
 }
 
+- (NSFetchRequest *)fetchRequestForIdentityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters groupIdentifier:(NSString *)groupIdentifier filteredByProperty:(NSString *)propertyName valueSet:(NSSet *)valueSet sortDescriptors:(NSArray *)sortDescriptors
+{
+    NSString *entityName = identityParameters.entityName;
+    if (!entityName) {
+        return nil;
+    }
+    
+    NSMutableArray *propertyList = [[NSMutableArray alloc] init];
+    NSMutableArray *valueList = [[NSMutableArray alloc] init];
+    
+    NSString *groupPropertyName = identityParameters.groupPropertyName;
+    if (groupPropertyName && groupIdentifier) {
+        [propertyList addObject:groupPropertyName];
+        [valueList addObject:groupIdentifier];
+    }
+    
+    // Filter in the store rather than in memory, so paging and projections
+    // apply to the filtered results
+    if (propertyName && valueSet.count > 0) {
+        NSSet *normalizedValueSet = [self normalizedIdentityValueSetForSet:valueSet];
+        if (!normalizedValueSet) {
+            return nil;
+        }
+        
+        [propertyList addObject:propertyName];
+        [valueList addObject:normalizedValueSet];
+    }
+    
+    return [self fetchRequestForEntityName:entityName usingPropertyList:propertyList valueList:valueList sortDescriptors:sortDescriptors];
+}
+
 - (NSFetchRequest *)fetchRequestForEntityName:(NSString *)entityName sortDescriptors:(NSArray *)sortDescriptors
 {
     if (!entityName) {
         return nil;
     }
     
-    NSFetchRequest *fetchRequest = [[NSFetchRequest alloc] initWithEntityName:entityName];
+    NSFetchRequest *fetchRequest = nil;
+    
+    // Handing the request its entity up front saves a lookup by name
+    // every time it's executed
+    NSEntityDescription *entity = [self entityForName:entityName];
+    if (entity) {
+        fetchRequest = [[NSFetchRequest alloc] init];
+        fetchRequest.entity = entity;
+    } else {
+        fetchRequest = [[NSFetchRequest alloc] initWithEntityName:entityName];
+    }
+    
     fetchRequest.sortDescriptors = sortDescriptors;
     
     return fetchRequest;
@@ -1259,31 +2371,126 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     NSFetchRequest *fetchRequest = [self fetchRequestForEntityName:entityName sortDescriptors:sortDescriptors];
     
     if (propertyList.count > 0 && valueList.count > 0 && propertyList.count == valueList.count) {
-        NSMutableArray *argumentArray = [[NSMutableArray alloc] init];
-        NSMutableString *formatString = [[NSMutableString alloc] init];
+        __block NSMutableSet *listPropertyNames = nil;
         
         [propertyList enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-            [argumentArray addObject:obj];
-            [argumentArray addObject:valueList[idx]];
+            id currentValue = valueList[idx];
             
-            NSString *predicateString = nil;
-            
-            if ([obj isKindOfClass:[NSArray class]]) {
-                predicateString = @"(%K IN %@)";
-            } else {
-                predicateString = @"%K == %@";
+            if ([currentValue isKindOfClass:[NSArray class]] || [currentValue isKindOfClass:[NSSet class]]) {
+                if (!listPropertyNames) {
+                    listPropertyNames = [[NSMutableSet alloc] init];
+                }
+                
+                [listPropertyNames addObject:obj];
             }
-            
-            [formatString BCC_appendPredicateCondition:predicateString];
         }];
         
-        NSPredicate *predicate = [NSPredicate predicateWithFormat:formatString argumentArray:argumentArray];
-        fetchRequest.predicate = predicate;
+        NSPredicate *predicateTemplate = [self predicateTemplateForPropertyList:propertyList listPropertyNames:listPropertyNames];
+        fetchRequest.predicate = [predicateTemplate predicateWithSubstitutionVariables:[[self class] predicateSubstitutionVariablesForValueList:valueList]];
     }
     
     return fetchRequest;
 }
 
+- (BCCDataStoreControllerPreparedQuery *)preparedQueryForEntityName:(NSString *)entityName usingPropertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames sortDescriptors:(NSArray *)sortDescriptors
+{
+    NSFetchRequest *fetchRequestTemplate = [self fetchRequestForEntityName:entityName sortDescriptors:sortDescriptors];
+    if (!fetchRequestTemplate) {
+        return nil;
+    }
+    
+    if (propertyList.count > 0) {
+        fetchRequestTemplate.predicate = [self predicateTemplateForPropertyList:propertyList listPropertyNames:listPropertyNames];
+    }
+    
+    return [[BCCDataStoreControllerPreparedQuery alloc] initWithFetchRequestTemplate:fetchRequestTemplate propertyList:propertyList listPropertyNames:listPropertyNames];
+}
+
++ (NSString *)predicateVariableNameForIndex:(NSUInteger)idx
+{
+    static NSArray *variableNames = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        NSMutableArray *names = [[NSMutableArray alloc] init];
+        for (NSUInteger i = 0; i < 8; i++) {
+            [names addObject:[NSString stringWithFormat:@"BCCValue%lu", (unsigned long)i]];
+        }
+        
+        variableNames = names;
+    });
+    
+    if (idx < variableNames.count) {
+        return variableNames[idx];
+    }
+    
+    return [NSString stringWithFormat:@"BCCValue%lu", (unsigned long)idx];
+}
+
++ (NSDictionary *)predicateSubstitutionVariablesForValueList:(NSArray *)valueList
+{
+    NSMutableDictionary *substitutionVariables = [[NSMutableDictionary alloc] initWithCapacity:valueList.count];
+    
+    [valueList enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        [substitutionVariables setObject:obj forKey:[self predicateVariableNameForIndex:idx]];
+    }];
+    
+    return substitutionVariables;
+}
+
+- (NSEntityDescription *)entityForName:(NSString *)entityName
+{
+    if (!entityName) {
+        return nil;
+    }
+    
+    return [self.entitiesByName objectForKey:entityName];
+}
+
+- (NSPredicate *)predicateTemplateForPropertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames
+{
+    if (propertyList.count < 1) {
+        return nil;
+    }
+    
+    // The predicate only depends on which properties are compared and
+    // how, so requests of the same shape share one parsed template
+    NSMutableString *shape = [[NSMutableString alloc] init];
+    for (NSString *currentPropertyName in propertyList) {
+        [shape appendFormat:@"%@ %@;", currentPropertyName, [listPropertyNames containsObject:currentPropertyName] ? @"IN" : @"=="];
+    }
+    
+    @synchronized (self.predicateTemplatesByShape) {
+        NSPredicate *predicateTemplate = [self.predicateTemplatesByShape objectForKey:shape];
+        if (predicateTemplate) {
+            return predicateTemplate;
+        }
+    }
+    
+    NSMutableString *formatString = [[NSMutableString alloc] init];
+    
+    [propertyList enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        NSString *variableName = [[self class] predicateVariableNameForIndex:idx];
+        
+        NSString *predicateString = nil;
+        
+        if ([listPropertyNames containsObject:obj]) {
+            predicateString = [NSString stringWithFormat:@"(%%K IN $%@)", variableName];
+        } else {
+            predicateString = [NSString stringWithFormat:@"%%K == $%@", variableName];
+        }
+        
+        [formatString BCC_appendPredicateCondition:predicateString];
+    }];
+    
+    NSPredicate *predicateTemplate = [NSPredicate predicateWithFormat:formatString argumentArray:propertyList];
+    
+    @synchronized (self.predicateTemplatesByShape) {
+        [self.predicateTemplatesByShape setObject:predicateTemplate forKey:shape];
+    }
+    
+    return predicateTemplate;
+}
+
 - (NSFetchRequest *)fetchRequestForTemplateName:(NSString *)templateName substitutionDictionary:(NSDictionary *)substitutionDictionary sortDescriptors:(NSArray *)sortDescriptors
 {
     if (!templateName) {
@@ -1313,39 +2520,100 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     NSSet *insertedObjects = [changeNotification.userInfo objectForKey:NSInsertedObjectsKey];
     NSSet *updatedObjects = [changeNotification.userInfo objectForKey:NSUpdatedObjectsKey];
     NSSet *deletedObjects = [changeNotification.userInfo objectForKey:NSDeletedObjectsKey];
+    NSSet *unregisteredDeletedObjectIDs = [changeNotification.userInfo objectForKey:BCCDataStoreControllerUnregisteredDeletedObjectIDsKey];
     
-    if (!context || (insertedObjects.count < 1 && updatedObjects.count < 1 && deletedObjects.count < 1)) {
+    if (!context || (insertedObjects.count < 1 && updatedObjects.count < 1 && deletedObjects.count < 1 && unregisteredDeletedObjectIDs.count < 1)) {
         return;
     }
     
-    NSDictionary *updatedKeysInfo = [context.userInfo objectForKey:BCCDataStoreControllerCurrentUpdatedKeysUserInfoKey];
+    NSMapTable *changedKeyMasks = [context.userInfo objectForKey:BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey];
+    [context.userInfo removeObjectForKey:BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey];
     
-    NSEnumerator *entityKeyEnumerator = [self.observerInfo keyEnumerator];
-    NSMutableArray *safeKeyList = [[NSMutableArray alloc] init];
-    for (NSString *currentKey in entityKeyEnumerator) {
-        [safeKeyList addObject:currentKey];
+    NSMapTable *committedValues = [context.userInfo objectForKey:BCCDataStoreControllerCurrentCommittedValuesUserInfoKey];
+    [context.userInfo removeObjectForKey:BCCDataStoreControllerCurrentCommittedValuesUserInfoKey];
+    
+    NSMutableSet *observedEntityNames = [[NSMutableSet alloc] init];
+    for (NSString *currentKey in [self.observerInfo keyEnumerator]) {
+        [observedEntityNames addObject:currentKey];
     }
     
-    for (NSString *currentEntityKey in safeKeyList) {
-        NSSet *updatedKeysForCurrentEntity = [updatedKeysInfo objectForKey:currentEntityKey];
-        
-        BOOL (^entityTypeMatchTest)(id, BOOL *) = ^(id obj, BOOL *stop) {
-            NSManagedObject *managedObject = (NSManagedObject *)obj;
-            if ([managedObject.entity.name isEqualToString:currentEntityKey]) {
-                return YES;
+    if (observedEntityNames.count < 1) {
+        return;
+    }
+    
+    // Sort the changed objects by entity in one pass, rather than
+    // scanning every change set once per observed entity
+    NSMutableDictionary *changesByEntityName = [[NSMutableDictionary alloc] init];
+    
+    void (^bucketChangedObjects)(NSSet *, NSString *) = ^(NSSet *changedObjects, NSString *changeKey) {
+        for (NSManagedObject *currentObject in changedObjects) {
+            NSString *currentEntityName = currentObject.entity.name;
+            if (![observedEntityNames containsObject:currentEntityName]) {
+                continue;
             }
             
-            return NO;
-        };
+            NSMutableDictionary *entityChanges = [changesByEntityName objectForKey:currentEntityName];
+            if (!entityChanges) {
+                entityChanges = [[NSMutableDictionary alloc] init];
+                [changesByEntityName setObject:entityChanges forKey:currentEntityName];
+            }
+            
+            NSMutableSet *entityChangedObjects = [entityChanges objectForKey:changeKey];
+            if (!entityChangedObjects) {
+                entityChangedObjects = [[NSMutableSet alloc] init];
+                [entityChanges setObject:entityChangedObjects forKey:changeKey];
+            }
+            
+            [entityChangedObjects addObject:currentObject];
+        }
+    };
+    
+    bucketChangedObjects(insertedObjects, NSInsertedObjectsKey);
+    bucketChangedObjects(updatedObjects, NSUpdatedObjectsKey);
+    bucketChangedObjects(deletedObjects, NSDeletedObjectsKey);
+    
+    for (NSManagedObjectID *currentObjectID in unregisteredDeletedObjectIDs) {
+        NSString *currentEntityName = currentObjectID.entity.name;
+        if (![observedEntityNames containsObject:currentEntityName]) {
+            continue;
+        }
         
-        NSSet *entityInsertedObjects = [insertedObjects objectsPassingTest:entityTypeMatchTest];
-        NSSet *entityUpdatedObjects = [updatedObjects objectsPassingTest:entityTypeMatchTest];
-        NSSet *entityDeletedObjects = [deletedObjects objectsPassingTest:entityTypeMatchTest];
+        NSMutableDictionary *entityChanges = [changesByEntityName objectForKey:currentEntityName];
+        if (!entityChanges) {
+            entityChanges = [[NSMutableDictionary alloc] init];
+            [changesByEntityName setObject:entityChanges forKey:currentEntityName];
+        }
         
-        if (!entityInsertedObjects.count && !entityUpdatedObjects.count && !entityDeletedObjects.count) {
-            continue;
+        NSMutableSet *entityDeletedObjectIDs = [entityChanges objectForKey:BCCDataStoreControllerUnregisteredDeletedObjectIDsKey];
+        if (!entityDeletedObjectIDs) {
+            entityDeletedObjectIDs = [[NSMutableSet alloc] init];
+            [entityChanges setObject:entityDeletedObjectIDs forKey:BCCDataStoreControllerUnregisteredDeletedObjectIDsKey];
         }
         
+        [entityDeletedObjectIDs addObject:currentObjectID];
+    }
+    
+    // Work out every notification up front, while we're still on the
+    // context's queue, and hand them all off in one go at the end
+    NSMutableArray *targetActions = [[NSMutableArray alloc] init];
+    NSMutableArray *changeNotifications = [[NSMutableArray alloc] init];
+    
+    for (NSString *currentEntityKey in changesByEntityName) {
+        NSDictionary *entityChanges = [changesByEntityName objectForKey:currentEntityKey];
+        
+        NSSet *entityInsertedObjects = [entityChanges objectForKey:NSInsertedObjectsKey] ? [entityChanges objectForKey:NSInsertedObjectsKey] : [NSSet set];
+        NSSet *entityUpdatedObjects = [entityChanges objectForKey:NSUpdatedObjectsKey] ? [entityChanges objectForKey:NSUpdatedObjectsKey] : [NSSet set];
+        NSSet *entityDeletedObjects = [entityChanges objectForKey:NSDeletedObjectsKey] ? [entityChanges objectForKey:NSDeletedObjectsKey] : [NSSet set];
+        NSSet *entityUnregisteredDeletedObjectIDs = [entityChanges objectForKey:BCCDataStoreControllerUnregisteredDeletedObjectIDsKey] ? [entityChanges objectForKey:BCCDataStoreControllerUnregisteredDeletedObjectIDsKey] : [NSSet set];
+        
+        BCCDataStoreControllerObserverParameters *entityObserverParameters = nil;
+        @synchronized (self.defaultObserverParametersByEntityName) {
+            entityObserverParameters = [self.defaultObserverParametersByEntityName objectForKey:currentEntityKey];
+        }
+        
+        // Observers that share a predicate share its results
+        NSMutableDictionary *filteredChangesByPredicate = [[NSMutableDictionary alloc] init];
+        
         [self.observerInfo enumerateTargetActionsForKey:currentEntityKey usingBlock:^(BCCTargetAction *targetAction) {
             BCCDataStoreTargetAction *currentTargetAction = (BCCDataStoreTargetAction *)targetAction;
             
@@ -1353,56 +2621,83 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
             NSSet *matchingInsertedObjects = entityInsertedObjects;
             NSSet *matchingUpdatedObjects = entityUpdatedObjects;
             NSSet *matchingDeletedObjects = entityDeletedObjects;
+            NSSet *matchingUnregisteredDeletedObjectIDs = entityUnregisteredDeletedObjectIDs;
             
             // If a predicate was specified, filter the changed
-            // objects list using that
+            // objects list using that. Updated objects go through if
+            // they match before or after the change, so observers
+            // hear about ones leaving their predicate, and deleted
+            // ones if they matched before it. Deleted objects we only
+            // have IDs for can't be evaluated, so they all go through.
             NSPredicate *currentPredicate = currentTargetAction.predicate;
             if (currentPredicate) {
-                matchingInsertedObjects = [entityInsertedObjects filteredSetUsingPredicate:currentPredicate];
-                matchingUpdatedObjects = [entityUpdatedObjects filteredSetUsingPredicate:currentPredicate];
-                matchingDeletedObjects = [entityDeletedObjects filteredSetUsingPredicate:currentPredicate];
-            }
-            
-            // If no changed objects are left after any applicable
-            // predicate filtering, this target/action is not a match
-            if (matchingInsertedObjects.count < 1 && matchingUpdatedObjects.count < 1 && matchingDeletedObjects.count < 1) {
-                return;
+                NSArray *filteredChanges = [filteredChangesByPredicate objectForKey:currentPredicate];
+                if (!filteredChanges) {
+                    filteredChanges = @[[entityInsertedObjects filteredSetUsingPredicate:currentPredicate], [self managedObjects:entityUpdatedObjects withCommittedValues:committedValues matchingPredicate:currentPredicate deleted:NO], [self managedObjects:entityDeletedObjects withCommittedValues:committedValues matchingPredicate:currentPredicate deleted:YES]];
+                    [filteredChangesByPredicate setObject:filteredChanges forKey:currentPredicate];
+                }
+                
+                matchingInsertedObjects = filteredChanges[0];
+                matchingUpdatedObjects = filteredChanges[1];
+                matchingDeletedObjects = filteredChanges[2];
             }
             
-            NSArray *currentRequiredChangedKeys = [currentTargetAction.requiredChangedKeys copy];
-            
-            // If this target/action specifies required changed keys
-            // and none of the predicate filtered updated object changes
-            // match those, this is not a match
-            BOOL changedKeysRequired = (currentRequiredChangedKeys.count > 0);
-            if (changedKeysRequired && ((matchingInsertedObjects.count < 1 && matchingUpdatedObjects.count < 1) || updatedKeysForCurrentEntity.count < 1)) {
-                return;
+            // If this target/action specifies required changed keys,
+            // keep only the inserted and updated objects whose own
+            // changes include at least one of them
+            if (currentTargetAction.requiredChangedKeys.count > 0) {
+                if (!currentTargetAction.requiredChangedKeyMaskLoaded) {
+                    currentTargetAction.requiredChangedKeyMask = [self changedKeyMaskForKeys:currentTargetAction.requiredChangedKeys entityName:currentEntityKey];
+                    currentTargetAction.requiredChangedKeyMaskLoaded = YES;
+                }
+                
+                uint64_t requiredChangedKeyMask = currentTargetAction.requiredChangedKeyMask;
+                
+                matchingInsertedObjects = [self managedObjects:matchingInsertedObjects withChangedKeyMasks:changedKeyMasks matchingRequiredChangedKeyMask:requiredChangedKeyMask];
+                matchingUpdatedObjects = [self managedObjects:matchingUpdatedObjects withChangedKeyMasks:changedKeyMasks matchingRequiredChangedKeyMask:requiredChangedKeyMask];
             }
             
-            // If we have required changed keys, examine the
-            // predicate matched updated objects for ones
-            // with changes matching the required keys
-            if (changedKeysRequired) {
-                NSSet *updatedObjectsMatchingChangedKeys = [self managedObjects:matchingUpdatedObjects withUpdatedKeys:updatedKeysForCurrentEntity matchingRequiredChangeKeys:currentRequiredChangedKeys];
-                NSSet *insertedObjectsMatchingChangedKeys = [self managedObjects:matchingInsertedObjects withUpdatedKeys:updatedKeysForCurrentEntity matchingRequiredChangeKeys:currentRequiredChangedKeys];
-                
-                // If required changed keys were specified
-                // but none were found, this target/action
-                // is not a match
-                if (insertedObjectsMatchingChangedKeys.count == 0 && updatedObjectsMatchingChangedKeys.count == 0) {
+            // Coalescing observers get their matches merged into the
+            // pending notification, which goes out once the window
+            // closes or enough saves have been merged
+            BCCDataStoreControllerObserverParameters *currentObserverParameters = currentTargetAction.observerParameters ? currentTargetAction.observerParameters : entityObserverParameters;
+            if (currentObserverParameters.coalescesChanges) {
+                // Every deleted object of the entity is passed along,
+                // so ones inserted or updated earlier in the window
+                // drop out even if they no longer match the predicate
+                BOOL didCoalesceObjects = [currentTargetAction coalesceInsertedObjects:matchingInsertedObjects updatedObjects:matchingUpdatedObjects deletedObjects:matchingDeletedObjects removedObjects:entityDeletedObjects];
+                BOOL didCoalesceObjectIDs = [currentTargetAction coalesceDeletedObjectIDs:matchingUnregisteredDeletedObjectIDs];
+                if (!didCoalesceObjects && !didCoalesceObjectIDs) {
                     return;
                 }
                 
-                if (insertedObjectsMatchingChangedKeys.count > 0) {
-                    matchingInsertedObjects = insertedObjectsMatchingChangedKeys;
+                currentTargetAction.coalescedSaveCount++;
+                
+                NSUInteger maximumSaveCount = currentObserverParameters.maximumCoalescedSaveCount;
+                if (maximumSaveCount > 0 && currentTargetAction.coalescedSaveCount >= maximumSaveCount) {
+                    BCCDataStoreChangeNotification *coalescedNotification = [currentTargetAction takeCoalescedChangeNotification];
+                    if (coalescedNotification) {
+                        [targetActions addObject:currentTargetAction];
+                        [changeNotifications addObject:coalescedNotification];
+                    }
+                    
+                    return;
                 }
                 
-                if (updatedObjectsMatchingChangedKeys.count > 0) {
-                    matchingUpdatedObjects = updatedObjectsMatchingChangedKeys;
+                if (!currentTargetAction.coalescingFlushScheduled && currentObserverParameters.coalescingInterval > 0) {
+                    [self scheduleCoalescedChangesFlushForTargetAction:currentTargetAction entityName:currentEntityKey afterDelay:currentObserverParameters.coalescingInterval];
                 }
+                
+                return;
             }
             
-            NSMutableDictionary *changesets = [[NSMutableDictionary alloc] init];
+            // If no changed objects are left after filtering, this
+            // target/action is not a match
+            if (matchingInsertedObjects.count < 1 && matchingUpdatedObjects.count < 1 && matchingDeletedObjects.count < 1 && matchingUnregisteredDeletedObjectIDs.count < 1) {
+                return;
+            }
+            
+            NSMutableDictionary *changesets = [[NSMutableDictionary alloc] init];
             
             if (matchingInsertedObjects) {
                 [changesets setObject:matchingInsertedObjects forKey:NSInsertedObjectsKey];
@@ -1416,73 +2711,263 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
                 [changesets setObject:matchingDeletedObjects forKey:NSDeletedObjectsKey];
             }
             
-            BCCDataStoreChangeNotification *changeNotification = [[BCCDataStoreChangeNotification alloc] initWithDictionary:changesets];
-            dispatch_sync(self.workerQueue, ^{
-                [self.observerInfo performAction:currentTargetAction withObject:changeNotification];
-            });
+            if (matchingUnregisteredDeletedObjectIDs.count > 0) {
+                NSMutableSet *matchingDeletedObjectIDs = [[matchingDeletedObjects valueForKey:@"objectID"] mutableCopy];
+                [matchingDeletedObjectIDs unionSet:matchingUnregisteredDeletedObjectIDs];
+                [changesets setObject:matchingDeletedObjectIDs forKey:BCCDataStoreChangeNotificationDeletedObjectIDsKey];
+            }
+            
+            [targetActions addObject:currentTargetAction];
+            [changeNotifications addObject:[[BCCDataStoreChangeNotification alloc] initWithDictionary:changesets]];
+        }];
+    }
+    
+    [self performTargetActions:targetActions withChangeNotifications:changeNotifications];
+}
+
+- (void)performTargetActions:(NSArray *)targetActions withChangeNotifications:(NSArray *)changeNotifications
+{
+    if (targetActions.count < 1) {
+        return;
+    }
+    
+    // Queues other than the main MOC's can't touch its objects, so
+    // observers there only get their IDs
+    dispatch_queue_t notificationQueue = self.observerNotificationQueue;
+    NSArray *deliveredNotifications = changeNotifications;
+    if (notificationQueue && notificationQueue != dispatch_get_main_queue()) {
+        deliveredNotifications = [changeNotifications valueForKey:@"objectIDChangeNotification"];
+    }
+    
+    void (^deliveryBlock)(void) = ^{
+        id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+        CFAbsoluteTime dispatchStartTime = metricsRecorder ? CFAbsoluteTimeGetCurrent() : 0.0;
+        
+        [targetActions enumerateObjectsUsingBlock:^(BCCDataStoreTargetAction *currentTargetAction, NSUInteger idx, BOOL *stop) {
+            [self.observerInfo performAction:currentTargetAction withObject:deliveredNotifications[idx]];
+        }];
+        
+        if (metricsRecorder) {
+            [metricsRecorder recordDuration:(CFAbsoluteTimeGetCurrent() - dispatchStartTime) forHistogram:BCCDataStoreControllerMetricObserverDispatchDuration dimension:nil];
+            [metricsRecorder incrementCounter:BCCDataStoreControllerMetricObserverNotifications dimension:nil by:targetActions.count];
+        }
+    };
+    
+    // The objects belong to the main MOC, so by default observers get
+    // them on its queue, which is where we are now
+    if (!notificationQueue) {
+        if (self.waitsForObserverNotifications) {
+            deliveryBlock();
+        } else {
+            [self.mainMOC performBlock:deliveryBlock];
+        }
+        
+        return;
+    }
+    
+    if (self.waitsForObserverNotifications) {
+        // A save made on the notification queue itself (e.g. a main MOC
+        // save with the main queue as the notification queue) would
+        // deadlock waiting on its own queue
+        BOOL onNotificationQueue = (dispatch_get_specific((__bridge const void *)self) == (__bridge void *)notificationQueue) || (notificationQueue == dispatch_get_main_queue() && [NSThread isMainThread]);
+        
+        if (onNotificationQueue) {
+            deliveryBlock();
+        } else {
+            dispatch_sync(notificationQueue, deliveryBlock);
+        }
+    } else {
+        dispatch_async(notificationQueue, deliveryBlock);
+    }
+}
+
+- (void)scheduleCoalescedChangesFlushForTargetAction:(BCCDataStoreTargetAction *)targetAction entityName:(NSString *)entityName afterDelay:(NSTimeInterval)delay
+{
+    targetAction.coalescingFlushScheduled = YES;
+    NSUInteger generation = targetAction.coalescingGeneration;
+    
+    dispatch_time_t popTime = dispatch_time(DISPATCH_TIME_NOW, delay * NSEC_PER_SEC);
+    dispatch_after(popTime, self.workerQueue, ^{
+        [self.mainMOC performBlock:^{
+            [self flushCoalescedChangesForTargetAction:targetAction entityName:entityName generation:generation];
+        }];
+    });
+}
+
+- (void)flushCoalescedChangesForTargetAction:(BCCDataStoreTargetAction *)targetAction entityName:(NSString *)entityName generation:(NSUInteger)generation
+{
+    // The save count limit already flushed this window
+    if (targetAction.coalescingGeneration != generation) {
+        return;
+    }
+    
+    // Drop whatever's pending if the observer went away in the meantime
+    __block BOOL isRegistered = NO;
+    [self.observerInfo enumerateTargetActionsForKey:entityName usingBlock:^(BCCTargetAction *currentTargetAction) {
+        if (currentTargetAction == targetAction) {
+            isRegistered = YES;
+        }
+    }];
+    
+    BCCDataStoreChangeNotification *coalescedNotification = [targetAction takeCoalescedChangeNotification];
+    if (!isRegistered || !coalescedNotification) {
+        return;
+    }
+    
+    [self performTargetActions:@[targetAction] withChangeNotifications:@[coalescedNotification]];
+}
+
+- (NSDictionary *)changedKeyIndexesForModel:(NSManagedObjectModel *)managedObjectModel
+{
+    NSMutableDictionary *changedKeyIndexesByEntityName = [[NSMutableDictionary alloc] init];
+    
+    for (NSEntityDescription *currentEntity in managedObjectModel.entities) {
+        // Sort so an entity's bit assignments don't depend on
+        // dictionary ordering
+        NSArray *propertyNames = [currentEntity.propertiesByName.allKeys sortedArrayUsingSelector:@selector(compare:)];
+        
+        NSMutableDictionary *indexesByPropertyName = [[NSMutableDictionary alloc] initWithCapacity:propertyNames.count];
+        [propertyNames enumerateObjectsUsingBlock:^(NSString *currentPropertyName, NSUInteger idx, BOOL *stop) {
+            NSUInteger changedKeyIndex = MIN(idx, BCCDataStoreControllerMaximumChangedKeyIndex);
+            [indexesByPropertyName setObject:@(changedKeyIndex) forKey:currentPropertyName];
         }];
         
-        [context.userInfo removeObjectForKey:BCCDataStoreControllerCurrentUpdatedKeysUserInfoKey];
+        [changedKeyIndexesByEntityName setObject:indexesByPropertyName forKey:currentEntity.name];
     }
+    
+    return changedKeyIndexesByEntityName;
 }
 
-- (NSSet *)managedObjects:(NSSet *)managedObjects withUpdatedKeys:(NSSet *)updatedKeys matchingRequiredChangeKeys:(NSArray *)requiredChangeKeys
+- (uint64_t)changedKeyMaskForKeys:(id<NSFastEnumeration>)keys entityName:(NSString *)entityName
 {
-    NSMutableSet *managedObjectMatchingChangeKeys = [[NSMutableSet alloc] init];
+    NSDictionary *indexesByPropertyName = [self.changedKeyIndexesByEntityName objectForKey:entityName];
+    if (!indexesByPropertyName) {
+        return 0;
+    }
     
-    for (NSManagedObject *currentUpdatedObject in [managedObjects allObjects]) {
-        for (NSString *currentChangedKey in updatedKeys) {
-            NSUInteger foundIndex = [requiredChangeKeys indexOfObjectPassingTest:^BOOL(id obj, NSUInteger idx, BOOL *stop) {
-                NSString *currentRequiredChangedKey = (NSString *)obj;
-                if ([currentRequiredChangedKey isEqualToString:currentChangedKey]){
-                    *stop = YES;
-                    return YES;
-                }
-                
-                return NO;
-            }];
-            
-            if (foundIndex != NSNotFound) {
-                [managedObjectMatchingChangeKeys addObject:currentUpdatedObject];
-            }
+    uint64_t changedKeyMask = 0;
+    for (NSString *currentKey in keys) {
+        NSNumber *changedKeyIndex = [indexesByPropertyName objectForKey:currentKey];
+        if (!changedKeyIndex) {
+            continue;
         }
+        
+        changedKeyMask |= ((uint64_t)1 << changedKeyIndex.unsignedIntegerValue);
     }
     
-    return managedObjectMatchingChangeKeys;
+    return changedKeyMask;
 }
 
-- (NSDictionary *)updatedEntityKeysForMOC:(NSManagedObjectContext *)context
+- (NSMapTable *)changedKeyMasksForMOC:(NSManagedObjectContext *)context
 {
     if (!context) {
         return nil;
     }
     
-    NSMutableSet *insertedOrUpdateObjects = [NSMutableSet new];
-    [insertedOrUpdateObjects addObjectsFromArray:context.insertedObjects.allObjects];
-    [insertedOrUpdateObjects addObjectsFromArray:context.updatedObjects.allObjects];
+    NSSet *insertedObjects = context.insertedObjects;
+    NSSet *updatedObjects = context.updatedObjects;
     
-    if (!insertedOrUpdateObjects.count) {
+    if (insertedObjects.count < 1 && updatedObjects.count < 1) {
         return nil;
     }
     
-    NSMutableDictionary *changedEntitiesDictionary = [[NSMutableDictionary alloc] init];
-    for (NSManagedObject *currentUpdatedObject in insertedOrUpdateObjects) {
-        NSString *currentEntityName = currentUpdatedObject.entity.name;
-        
-        NSDictionary *currentObjectChangedValues = [currentUpdatedObject changedValues];
-        NSEnumerator *changedKeysEnumerator = [currentObjectChangedValues keyEnumerator];
-        for (NSString *currentChangedKey in changedKeysEnumerator) {
-            NSMutableSet *changedKeysListForEntity = [changedEntitiesDictionary objectForKey:currentEntityName];
-            if (!changedKeysListForEntity) {
-                changedKeysListForEntity = [[NSMutableSet alloc] init];
-                [changedEntitiesDictionary setObject:changedKeysListForEntity forKey:currentEntityName];
+    // Keyed by object pointer, so lookups don't go through
+    // NSManagedObject's hash and isEqual:
+    NSMapTable *changedKeyMasks = [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory capacity:(insertedObjects.count + updatedObjects.count)];
+    
+    void (^captureChangedKeys)(NSSet *) = ^(NSSet *changedObjects) {
+        for (NSManagedObject *currentObject in changedObjects) {
+            NSDictionary *currentObjectChangedValues = [currentObject changedValues];
+            if (currentObjectChangedValues.count < 1) {
+                continue;
             }
             
-            [changedKeysListForEntity addObject:currentChangedKey];
+            uint64_t changedKeyMask = [self changedKeyMaskForKeys:[currentObjectChangedValues keyEnumerator] entityName:currentObject.entity.name];
+            if (changedKeyMask == 0) {
+                continue;
+            }
+            
+            [changedKeyMasks setObject:@(changedKeyMask) forKey:currentObject];
+        }
+    };
+    
+    captureChangedKeys(insertedObjects);
+    captureChangedKeys(updatedObjects);
+    
+    return changedKeyMasks;
+}
+
+- (NSSet *)managedObjects:(NSSet *)managedObjects withChangedKeyMasks:(NSMapTable *)changedKeyMasks matchingRequiredChangedKeyMask:(uint64_t)requiredChangedKeyMask
+{
+    if (managedObjects.count < 1 || requiredChangedKeyMask == 0) {
+        return [NSSet set];
+    }
+    
+    NSMutableSet *managedObjectsMatchingChangedKeys = [[NSMutableSet alloc] init];
+    
+    for (NSManagedObject *currentObject in managedObjects) {
+        uint64_t changedKeyMask = [[changedKeyMasks objectForKey:currentObject] unsignedLongLongValue];
+        if ((changedKeyMask & requiredChangedKeyMask) != 0) {
+            [managedObjectsMatchingChangedKeys addObject:currentObject];
+        }
+    }
+    
+    return managedObjectsMatchingChangedKeys;
+}
+
+- (NSMapTable *)committedValuesForObservedObjects:(NSSet *)managedObjects
+{
+    if (managedObjects.count < 1) {
+        return nil;
+    }
+    
+    NSMutableSet *observedEntityNames = [[NSMutableSet alloc] init];
+    for (NSString *currentKey in [self.observerInfo keyEnumerator]) {
+        [observedEntityNames addObject:currentKey];
+    }
+    
+    if (observedEntityNames.count < 1) {
+        return nil;
+    }
+    
+    NSMapTable *committedValues = [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory capacity:managedObjects.count];
+    
+    // Faults were never loaded, so there's nothing to capture without
+    // going back to the store
+    for (NSManagedObject *currentObject in managedObjects) {
+        if (currentObject.isFault || currentObject.isInserted || ![observedEntityNames containsObject:currentObject.entity.name]) {
+            continue;
+        }
+        
+        [committedValues setObject:[currentObject committedValuesForKeys:nil] forKey:currentObject];
+    }
+    
+    return committedValues;
+}
+
+- (NSSet *)managedObjects:(NSSet *)managedObjects withCommittedValues:(NSMapTable *)committedValues matchingPredicate:(NSPredicate *)predicate deleted:(BOOL)deleted
+{
+    if (managedObjects.count < 1) {
+        return [NSSet set];
+    }
+    
+    NSMutableSet *matchingObjects = [[NSMutableSet alloc] init];
+    
+    for (NSManagedObject *currentObject in managedObjects) {
+        if (!deleted && [predicate evaluateWithObject:currentObject]) {
+            [matchingObjects addObject:currentObject];
+            continue;
+        }
+        
+        // A deleted object whose earlier values weren't captured might
+        // have matched, so it goes through
+        NSDictionary *currentCommittedValues = [committedValues objectForKey:currentObject];
+        if (currentCommittedValues ? [predicate evaluateWithObject:currentCommittedValues] : deleted) {
+            [matchingObjects addObject:currentObject];
         }
     }
     
-    return changedEntitiesDictionary;
+    return matchingObjects;
 }
 
 - (void)addObserver:(id)observer action:(SEL)action forEntityName:(NSString *)entityName
@@ -1497,6 +2982,29 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     [self.observerInfo addTargetAction:targetAction];
 }
 
+- (void)addObserver:(id)observer action:(SEL)action forEntityName:(NSString *)entityName withParameters:(BCCDataStoreControllerObserverParameters *)observerParameters
+{
+    BCCDataStoreTargetAction *targetAction = [BCCDataStoreTargetAction targetActionForKey:entityName withTarget:observer action:action predicate:observerParameters.predicate requiredChangedKeys:observerParameters.requiredChangedKeys];
+    targetAction.observerParameters = [observerParameters copy];
+    
+    [self.observerInfo addTargetAction:targetAction];
+}
+
+- (void)setDefaultObserverParameters:(BCCDataStoreControllerObserverParameters *)observerParameters forEntityName:(NSString *)entityName
+{
+    if (!entityName) {
+        return;
+    }
+    
+    @synchronized (self.defaultObserverParametersByEntityName) {
+        if (observerParameters) {
+            [self.defaultObserverParametersByEntityName setObject:[observerParameters copy] forKey:entityName];
+        } else {
+            [self.defaultObserverParametersByEntityName removeObjectForKey:entityName];
+        }
+    }
+}
+
 - (BOOL)hasObserver:(id)observer
 {
     NSArray *matchingTargetActions = [self.observerInfo targetActionsForTarget:observer];
@@ -1527,26 +3035,51 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 - (NSArray *)createObjectsFromJSONArray:(NSArray *)dictionaryArray usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters
 {
-    NSString *groupPropertyName = identityParameters.groupPropertyName;
-    NSString *listIndexPropertyName = identityParameters.listIndexPropertyName;
-    NSString *groupIdentifier = importParameters.groupIdentifier;
-    NSString *dictionaryIdentityPropertyName = importParameters.dictionaryIdentityPropertyName;
-    BOOL findExisting = importParameters.findExisting;
-    BOOL deleteExisting = importParameters.deleteExisting;
-    
     if (!dictionaryArray || dictionaryArray.count < 1) {
         return nil;
     }
     
-    NSManagedObjectContext *managedObjectContext = [self currentMOC];
+    NSString *groupPropertyName = identityParameters.groupPropertyName;
+    NSString *groupIdentifier = importParameters.groupIdentifier;
     
     if (importParameters.deleteExisting && groupPropertyName && groupIdentifier) {
         [self deleteObjectsWithIdentityParameters:identityParameters groupIdentifier:groupIdentifier];
     }
     
+    NSIndexSet *indexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, dictionaryArray.count)];
+    
+    return [self createObjectsFromJSONArray:dictionaryArray atIndexes:indexes baseIndex:0 usingImportParameters:importParameters identityParameters:identityParameters affectedIndexes:nil];
+}
+
+- (NSArray *)createObjectsFromJSONArray:(NSArray *)dictionaryArray atIndexes:(NSIndexSet *)indexes baseIndex:(NSUInteger)baseIndex usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters affectedIndexes:(NSMutableIndexSet *)affectedIndexes
+{
+    NSString *listIndexPropertyName = identityParameters.listIndexPropertyName;
+    NSString *groupIdentifier = importParameters.groupIdentifier;
+    NSString *dictionaryIdentityPropertyName = importParameters.dictionaryIdentityPropertyName;
+    BOOL findExisting = importParameters.findExisting;
+    BOOL deleteExisting = importParameters.deleteExisting;
+    
+    NSManagedObjectContext *managedObjectContext = [self currentMOC];
+    
     NSMutableArray *affectedObjects = [[NSMutableArray alloc] init];
     
-    [dictionaryArray enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+    // In batched mode, resolve every existing object with a handful
+    // of IN queries before we start walking the array
+    NSMutableDictionary *existingObjects = nil;
+    if (findExisting && !deleteExisting && importParameters.findsExistingInBatches) {
+        NSMutableArray *identityValues = [[NSMutableArray alloc] initWithCapacity:indexes.count];
+        for (NSDictionary *currentDictionary in [dictionaryArray objectsAtIndexes:indexes]) {
+            id identityValue = [currentDictionary valueForKeyPath:dictionaryIdentityPropertyName];
+            if (identityValue) {
+                [identityValues addObject:identityValue];
+            }
+        }
+        
+        NSDictionary *foundObjects = [self existingObjectsForIdentityParameters:identityParameters identityValueList:identityValues groupIdentifier:groupIdentifier batchSize:importParameters.findExistingBatchSize];
+        existingObjects = foundObjects ? [foundObjects mutableCopy] : [[NSMutableDictionary alloc] init];
+    }
+    
+    [dictionaryArray enumerateObjectsAtIndexes:indexes options:0 usingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
         NSDictionary *currentDictionary = (NSDictionary *)obj;
         
         NSManagedObject *affectedObject = nil;
@@ -1555,7 +3088,22 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
             return;
         }
         
-        if (findExisting && !deleteExisting) {
+        if (existingObjects) {
+            id normalizedIdentityValue = [self normalizedIdentityValueForValue:identityValue];
+            if (!normalizedIdentityValue) {
+                return;
+            }
+            
+            affectedObject = [existingObjects objectForKey:normalizedIdentityValue];
+            if (!affectedObject) {
+                affectedObject = [self createAndInsertObjectWithIdentityParameters:identityParameters identityValue:normalizedIdentityValue groupIdentifier:groupIdentifier];
+                if (affectedObject) {
+                    // Later duplicates in the same payload should
+                    // update this object rather than create another
+                    [existingObjects setObject:affectedObject forKey:normalizedIdentityValue];
+                }
+            }
+        } else if (findExisting && !deleteExisting) {
             affectedObject = [self findOrCreateObjectWithIdentityParameters:identityParameters identityValue:identityValue groupIdentifier:groupIdentifier];
         } else if (identityValue) {
             affectedObject = [self createAndInsertObjectWithIdentityParameters:identityParameters identityValue:identityValue groupIdentifier:groupIdentifier];
@@ -1566,81 +3114,572 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
         }
         
         if (listIndexPropertyName) {
-            [affectedObject setValue:@(idx) forKey:listIndexPropertyName];
+            [affectedObject setValue:@(baseIndex + idx) forKey:listIndexPropertyName];
         }
         
         if (importParameters.postCreateBlock) {
-            importParameters.postCreateBlock(affectedObject, currentDictionary, idx, managedObjectContext);
+            importParameters.postCreateBlock(affectedObject, currentDictionary, baseIndex + idx, managedObjectContext);
         }
         
         [affectedObjects addObject:affectedObject];
+        [affectedIndexes addIndex:idx];
         
     }];
     
     return affectedObjects;
 }
 
-@end
-
-#pragma mark -
-
-@implementation BCCDataStoreControllerIdentityParameters
-
-#pragma mark - Class Methods
+#pragma mark - Parallel Import
 
-+ (instancetype)identityParametersWithEntityName:(NSString *)entityName identityPropertyName:(NSString *)identityPropertyName
+- (void)createObjectsInParallelFromJSONArray:(NSArray *)dictionaryArray usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerCreateObjectsCompletionBlock)completion
 {
-    BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
-    identityParameters.identityPropertyName = identityPropertyName;
+    if (dictionaryArray.count < 1) {
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(@[], nil);
+            });
+        }
+        
+        return;
+    }
     
-    return identityParameters;
-}
-
-+ (instancetype)identityParametersWithEntityName:(NSString *)entityName groupPropertyName:(NSString *)groupPropertyName
-{
-    BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
-    identityParameters.groupPropertyName = groupPropertyName;
+    NSString *groupPropertyName = identityParameters.groupPropertyName;
+    NSString *groupIdentifier = importParameters.groupIdentifier;
+    NSString *dictionaryIdentityPropertyName = importParameters.dictionaryIdentityPropertyName;
+    NSUInteger shardCount = MAX(importParameters.parallelShardCount, (NSUInteger)1);
+    
+    // Records with the same identity value always land in the same
+    // shard, so no two shards can create the same object. Records
+    // without one are skipped, just as they are in the serial path.
+    NSMutableArray *shardIndexes = [[NSMutableArray alloc] initWithCapacity:shardCount];
+    for (NSUInteger currentShard = 0; currentShard < shardCount; currentShard++) {
+        [shardIndexes addObject:[[NSMutableIndexSet alloc] init]];
+    }
     
-    return identityParameters;
-}
-
-#pragma mark - Initialization
-
-- (instancetype)initWithEntityName:(NSString *)entityName
-{
-    self = [super init];
-    if (!self) {
-        return nil;
+    [dictionaryArray enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+        id identityValue = [(NSDictionary *)obj valueForKeyPath:dictionaryIdentityPropertyName];
+        id normalizedIdentityValue = [self normalizedIdentityValueForValue:identityValue];
+        if (!normalizedIdentityValue) {
+            return;
+        }
+        
+        NSMutableIndexSet *currentIndexes = [shardIndexes objectAtIndex:([normalizedIdentityValue hash] % shardCount)];
+        [currentIndexes addIndex:idx];
+    }];
+    
+    NSMutableSet *insertedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableSet *updatedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableSet *deletedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableDictionary *changedKeyMasksByObjectID = [[NSMutableDictionary alloc] init];
+    
+    // The first shard save that fails. Guarded by @synchronized on
+    // affectedObjectIDs.
+    __block NSError *shardError = nil;
+    
+    // Object IDs in input order, with NSNull where nothing was created
+    NSMutableArray *affectedObjectIDs = [[NSMutableArray alloc] initWithCapacity:dictionaryArray.count];
+    for (NSUInteger currentIndex = 0; currentIndex < dictionaryArray.count; currentIndex++) {
+        [affectedObjectIDs addObject:[NSNull null]];
     }
     
-    _entityName = entityName;
+    void (^finishImport)(void) = ^{
+        [self mergeStoreChangesWithInsertedObjectIDs:insertedObjectIDs updatedObjectIDs:updatedObjectIDs deletedObjectIDs:deletedObjectIDs changedKeyMasks:changedKeyMasksByObjectID];
+        
+        NSError *importError = nil;
+        @synchronized (affectedObjectIDs) {
+            importError = shardError;
+        }
+        
+        [self.mainMOC performBlock:^{
+            NSMutableArray *affectedObjects = [[NSMutableArray alloc] init];
+            for (id currentObjectID in affectedObjectIDs) {
+                if (currentObjectID == [NSNull null]) {
+                    continue;
+                }
+                
+                [affectedObjects addObject:[self.mainMOC objectWithID:currentObjectID]];
+            }
+            
+            if (completion) {
+                completion(affectedObjects, importError);
+            }
+        }];
+    };
     
-    return self;
+    void (^importShards)(void) = ^{
+        dispatch_group_t shardGroup = dispatch_group_create();
+        
+        for (NSIndexSet *currentIndexes in shardIndexes) {
+            if (currentIndexes.count < 1) {
+                continue;
+            }
+            
+            NSManagedObjectContext *shardMOC = [self newImportShardMOC];
+            
+            dispatch_group_enter(shardGroup);
+            [shardMOC performBlock:^{
+                [self performWithCurrentMOC:shardMOC block:^{
+                    NSMutableIndexSet *shardAffectedIndexes = [[NSMutableIndexSet alloc] init];
+                    NSArray *shardObjects = [self createObjectsFromJSONArray:dictionaryArray atIndexes:currentIndexes baseIndex:0 usingImportParameters:importParameters identityParameters:identityParameters affectedIndexes:shardAffectedIndexes];
+                    
+                    NSError *saveError = nil;
+                    BOOL didSave = [self saveImportShardMOC:shardMOC insertedObjectIDs:insertedObjectIDs updatedObjectIDs:updatedObjectIDs deletedObjectIDs:deletedObjectIDs changedKeyMasks:changedKeyMasksByObjectID error:&saveError];
+                    
+                    // Object IDs are permanent once the shard has saved.
+                    // A shard that didn't save has nothing in the store,
+                    // so its records stay NSNull.
+                    __block NSUInteger shardObjectPosition = 0;
+                    @synchronized (affectedObjectIDs) {
+                        if (didSave) {
+                            [shardAffectedIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+                                NSManagedObject *currentObject = [shardObjects objectAtIndex:shardObjectPosition];
+                                [affectedObjectIDs replaceObjectAtIndex:idx withObject:currentObject.objectID];
+                                shardObjectPosition++;
+                            }];
+                        } else if (!shardError) {
+                            shardError = saveError;
+                        }
+                    }
+                    
+                    [self clearObjectCacheForMOC:shardMOC];
+                }];
+                
+                dispatch_group_leave(shardGroup);
+            }];
+        }
+        
+        // Nothing here waits on the shards, so a caller on any context's
+        // queue can't end up blocking one the shards or the merge need
+        dispatch_group_notify(shardGroup, self.workerQueue, finishImport);
+    };
+    
+    // Group deletes have to land before any shard starts inserting,
+    // or they'd take the other shards' new objects with them
+    if (!importParameters.deleteExisting || !groupPropertyName || !groupIdentifier) {
+        importShards();
+        return;
+    }
+    
+    NSManagedObjectContext *deleteMOC = [self newImportShardMOC];
+    
+    [deleteMOC performBlock:^{
+        [self performWithCurrentMOC:deleteMOC block:^{
+            [self deleteObjectsWithIdentityParameters:identityParameters groupIdentifier:groupIdentifier];
+        }];
+        
+        // Importing on top of a group that wasn't cleared would leave
+        // stale objects mixed in with the new ones
+        NSError *deleteError = nil;
+        if (![self saveImportShardMOC:deleteMOC insertedObjectIDs:insertedObjectIDs updatedObjectIDs:updatedObjectIDs deletedObjectIDs:deletedObjectIDs changedKeyMasks:changedKeyMasksByObjectID error:&deleteError]) {
+            if (completion) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    completion(nil, deleteError);
+                });
+            }
+            
+            return;
+        }
+        
+        importShards();
+    }];
 }
 
-#pragma mark - Accessors
-
-- (BOOL)isValidForQuery
+- (NSManagedObjectContext *)newImportShardMOC
 {
-    return (_entityName != nil && _identityPropertyName != nil);
+    NSManagedObjectContext *shardMOC = [self newMOCWithConcurrencyType:NSPrivateQueueConcurrencyType];
+    
+    [shardMOC performBlockAndWait:^{
+        shardMOC.persistentStoreCoordinator = self.persistentStoreCoordinator;
+        shardMOC.mergePolicy = NSOverwriteMergePolicy;
+    }];
+    
+    return shardMOC;
 }
 
-@end
-
-#pragma mark -
-
-@implementation BCCDataStoreControllerWorkParameters
-
-#pragma mark - Initialization
-
-- (id)init
+- (void)performWithCurrentMOC:(NSManagedObjectContext *)managedObjectContext block:(void (^)(void))block
 {
-    self = [super init];
-    if (!self) {
-        return nil;
-    }
+    NSMutableDictionary *threadDictionary = [NSThread currentThread].threadDictionary;
+    id previousMOC = [threadDictionary objectForKey:BCCDataStoreControllerThreadCurrentMOCKey];
     
-    _workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleMainMOCAndWait;
+    [threadDictionary setObject:managedObjectContext forKey:BCCDataStoreControllerThreadCurrentMOCKey];
+    
+    block();
+    
+    if (previousMOC) {
+        [threadDictionary setObject:previousMOC forKey:BCCDataStoreControllerThreadCurrentMOCKey];
+    } else {
+        [threadDictionary removeObjectForKey:BCCDataStoreControllerThreadCurrentMOCKey];
+    }
+}
+
+- (BOOL)saveImportShardMOC:(NSManagedObjectContext *)shardMOC insertedObjectIDs:(NSMutableSet *)insertedObjectIDs updatedObjectIDs:(NSMutableSet *)updatedObjectIDs deletedObjectIDs:(NSMutableSet *)deletedObjectIDs changedKeyMasks:(NSMutableDictionary *)changedKeyMasksByObjectID error:(NSError **)outError
+{
+    if (!shardMOC.hasChanges) {
+        return YES;
+    }
+    
+    NSError *error = nil;
+    if (![shardMOC obtainPermanentIDsForObjects:shardMOC.insertedObjects.allObjects error:&error]) {
+        NSLog(@"BCCDataStoreController Import Shard Permanent ID Error: %@", error);
+        
+        if (outError) {
+            *outError = error;
+        }
+        
+        return NO;
+    }
+    
+    // Changed values are gone after the save, so record them by object
+    // ID for the observers that will see these changes in the main MOC
+    NSMapTable *changedKeyMasks = [self changedKeyMasksForMOC:shardMOC];
+    
+    NSSet *shardInsertedObjectIDs = [shardMOC.insertedObjects valueForKey:@"objectID"];
+    NSSet *shardUpdatedObjectIDs = [shardMOC.updatedObjects valueForKey:@"objectID"];
+    NSSet *shardDeletedObjectIDs = [shardMOC.deletedObjects valueForKey:@"objectID"];
+    
+    if (![shardMOC save:&error]) {
+        NSLog(@"BCCDataStoreController Import Shard Save Exception: %@", error);
+        
+        if (outError) {
+            *outError = error;
+        }
+        
+        return NO;
+    }
+    
+    @synchronized (insertedObjectIDs) {
+        [insertedObjectIDs unionSet:shardInsertedObjectIDs];
+        [updatedObjectIDs unionSet:shardUpdatedObjectIDs];
+        [deletedObjectIDs unionSet:shardDeletedObjectIDs];
+        
+        for (NSManagedObject *currentObject in changedKeyMasks) {
+            [changedKeyMasksByObjectID setObject:[changedKeyMasks objectForKey:currentObject] forKey:currentObject.objectID];
+        }
+    }
+    
+    return YES;
+}
+
+- (void)mergeStoreChangesWithInsertedObjectIDs:(NSSet *)insertedObjectIDs updatedObjectIDs:(NSSet *)updatedObjectIDs deletedObjectIDs:(NSSet *)deletedObjectIDs changedKeyMasks:(NSDictionary *)changedKeyMasksByObjectID
+{
+    if (insertedObjectIDs.count < 1 && updatedObjectIDs.count < 1 && deletedObjectIDs.count < 1) {
+        return;
+    }
+    
+    NSDictionary *changes = @{NSInsertedObjectsKey: insertedObjectIDs.allObjects, NSUpdatedObjectsKey: updatedObjectIDs.allObjects, NSDeletedObjectsKey: deletedObjectIDs.allObjects};
+    
+    NSMutableArray *mergeContexts = [[NSMutableArray alloc] init];
+    for (NSManagedObjectContext *currentContext in @[self.writeMOC, self.mainMOC, self.backgroundMOC]) {
+        if (currentContext) {
+            [mergeContexts addObject:currentContext];
+        }
+    }
+    
+    // The main MOC's copies of the changed objects still have their old
+    // values until the merge, so capture them for observers' predicates
+    __block NSMapTable *committedValues = nil;
+    [self.mainMOC performBlockAndWait:^{
+        NSMutableSet *registeredObjects = [[NSMutableSet alloc] init];
+        for (NSManagedObjectID *currentObjectID in [updatedObjectIDs setByAddingObjectsFromSet:deletedObjectIDs]) {
+            NSManagedObject *currentObject = [self.mainMOC objectRegisteredForID:currentObjectID];
+            if (currentObject) {
+                [registeredObjects addObject:currentObject];
+            }
+        }
+        
+        committedValues = [self committedValuesForObservedObjects:registeredObjects];
+    }];
+    
+    [NSManagedObjectContext mergeChangesFromRemoteContextSave:changes intoContexts:mergeContexts];
+    
+    // The merge doesn't count as a main MOC save, so hand observers the
+    // same change notification a save would have produced
+    [self.mainMOC performBlockAndWait:^{
+        NSMapTable *changedKeyMasks = [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory capacity:changedKeyMasksByObjectID.count];
+        
+        // Deleted objects are only passed as objects if the main MOC had
+        // them registered, since a fresh fault for a deleted row can't be
+        // fired. The rest go along as object IDs.
+        NSSet *(^mainMOCObjects)(NSSet *, BOOL) = ^(NSSet *objectIDs, BOOL registeredOnly) {
+            NSMutableSet *objects = [[NSMutableSet alloc] initWithCapacity:objectIDs.count];
+            for (NSManagedObjectID *currentObjectID in objectIDs) {
+                NSManagedObject *currentObject = registeredOnly ? [self.mainMOC objectRegisteredForID:currentObjectID] : [self.mainMOC objectWithID:currentObjectID];
+                if (!currentObject) {
+                    continue;
+                }
+                
+                [objects addObject:currentObject];
+                
+                NSNumber *changedKeyMask = [changedKeyMasksByObjectID objectForKey:currentObjectID];
+                if (changedKeyMask) {
+                    [changedKeyMasks setObject:changedKeyMask forKey:currentObject];
+                }
+            }
+            
+            return objects;
+        };
+        
+        NSSet *deletedObjects = mainMOCObjects(deletedObjectIDs, YES);
+        
+        NSMutableSet *unregisteredDeletedObjectIDs = [deletedObjectIDs mutableCopy];
+        [unregisteredDeletedObjectIDs minusSet:[deletedObjects valueForKey:@"objectID"]];
+        
+        NSDictionary *userInfo = @{NSInsertedObjectsKey: mainMOCObjects(insertedObjectIDs, NO), NSUpdatedObjectsKey: mainMOCObjects(updatedObjectIDs, NO), NSDeletedObjectsKey: deletedObjects, BCCDataStoreControllerUnregisteredDeletedObjectIDsKey: unregisteredDeletedObjectIDs};
+        
+        [self.mainMOC.userInfo setObject:changedKeyMasks forKey:BCCDataStoreControllerCurrentChangedKeyMasksUserInfoKey];
+        
+        if (committedValues) {
+            [self.mainMOC.userInfo setObject:committedValues forKey:BCCDataStoreControllerCurrentCommittedValuesUserInfoKey];
+        }
+        
+        NSNotification *changeNotification = [NSNotification notificationWithName:NSManagedObjectContextDidSaveNotification object:self.mainMOC userInfo:userInfo];
+        [self notifyObserversForChangeNotification:changeNotification];
+    }];
+}
+
+#pragma mark - Streaming Import
+
+- (void)importObjectsFromJSONFileAtPath:(NSString *)path usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerImportCompletionBlock)completion
+{
+    NSInputStream *inputStream = path ? [NSInputStream inputStreamWithFileAtPath:path] : nil;
+    [self importObjectsFromJSONInputStream:inputStream usingImportParameters:importParameters identityParameters:identityParameters completion:completion];
+}
+
+- (void)importObjectsFromJSONInputStream:(NSInputStream *)inputStream usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters completion:(BCCDataStoreControllerImportCompletionBlock)completion
+{
+    if (!inputStream) {
+        if (completion) {
+            NSError *error = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorStreamReadFailed userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"No input stream to import from", @"")}];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(0, error);
+            });
+        }
+        
+        return;
+    }
+    
+    NSString *groupPropertyName = identityParameters.groupPropertyName;
+    NSString *groupIdentifier = importParameters.groupIdentifier;
+    NSUInteger chunkSize = importParameters.streamingChunkSize > 0 ? importParameters.streamingChunkSize : BCCDataStoreControllerDefaultStreamingChunkSize;
+    
+    // Chunks save straight to the store from a context of their own, so
+    // it can be reset between chunks without touching anyone else's
+    // objects
+    NSManagedObjectContext *importMOC = [self newImportShardMOC];
+    
+    [importMOC performBlock:^{
+        __block NSUInteger recordCount = 0;
+        __block NSError *importError = nil;
+        
+        [self performWithCurrentMOC:importMOC block:^{
+            // The group's existing objects are only deleted once all of
+            // their replacements have saved, so a failed or truncated
+            // import never leaves the group emptied out. Until then both
+            // sets are in the store.
+            NSArray *replacedObjectIDs = nil;
+            if (importParameters.deleteExisting && groupPropertyName && groupIdentifier) {
+                NSFetchRequest *replacedObjectsRequest = [NSFetchRequest fetchRequestWithEntityName:identityParameters.entityName];
+                replacedObjectsRequest.predicate = [NSPredicate predicateWithFormat:@"%K == %@", groupPropertyName, groupIdentifier];
+                replacedObjectsRequest.resultType = NSManagedObjectIDResultType;
+                
+                NSError *fetchError = nil;
+                replacedObjectIDs = [importMOC executeFetchRequest:replacedObjectsRequest error:&fetchError];
+                if (!replacedObjectIDs) {
+                    importError = fetchError;
+                    return;
+                }
+            }
+            
+            BCCDataStoreControllerJSONRecordReader *recordReader = [[BCCDataStoreControllerJSONRecordReader alloc] initWithInputStream:inputStream];
+            [inputStream open];
+            
+            NSMutableArray *records = [[NSMutableArray alloc] initWithCapacity:chunkSize];
+            NSUInteger chunkBaseIndex = 0;
+            
+            while (YES) {
+                @autoreleasepool {
+                    NSError *readError = nil;
+                    NSDictionary *currentRecord = [recordReader nextRecord:&readError];
+                    if (readError) {
+                        importError = readError;
+                    }
+                    
+                    if (currentRecord) {
+                        [records addObject:currentRecord];
+                        recordCount++;
+                    }
+                    
+                    BOOL isLastChunk = (currentRecord == nil);
+                    if (records.count >= chunkSize || (isLastChunk && records.count > 0)) {
+                        // A chunk that didn't save ends the import, since
+                        // everything after it would be missing records
+                        NSError *chunkError = nil;
+                        NSArray *chunkObjectIDs = [self importJSONRecordChunk:records baseIndex:chunkBaseIndex replacedObjectIDs:nil intoMOC:importMOC usingImportParameters:importParameters identityParameters:identityParameters error:&chunkError];
+                        if (!chunkObjectIDs) {
+                            importError = chunkError;
+                            recordCount = chunkBaseIndex;
+                            break;
+                        }
+                        
+                        if (importParameters.chunkBlock) {
+                            importParameters.chunkBlock(chunkObjectIDs, chunkBaseIndex);
+                        }
+                        
+                        chunkBaseIndex += records.count;
+                        [records removeAllObjects];
+                        
+                        if (importParameters.progressBlock) {
+                            importParameters.progressBlock(recordCount, recordReader.bytesRead);
+                        }
+                    }
+                    
+                    if (isLastChunk) {
+                        break;
+                    }
+                }
+            }
+            
+            [inputStream close];
+            
+            if (importError) {
+                return;
+            }
+            
+            for (NSUInteger deleteOffset = 0; deleteOffset < replacedObjectIDs.count; deleteOffset += chunkSize) {
+                NSArray *deleteObjectIDs = [replacedObjectIDs subarrayWithRange:NSMakeRange(deleteOffset, MIN(chunkSize, replacedObjectIDs.count - deleteOffset))];
+                
+                NSError *deleteError = nil;
+                if (![self importJSONRecordChunk:@[] baseIndex:0 replacedObjectIDs:deleteObjectIDs intoMOC:importMOC usingImportParameters:importParameters identityParameters:identityParameters error:&deleteError]) {
+                    importError = deleteError;
+                    break;
+                }
+            }
+        }];
+        
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(recordCount, importError);
+            });
+        }
+    }];
+}
+
+- (NSArray *)importJSONRecordChunk:(NSArray *)records baseIndex:(NSUInteger)baseIndex replacedObjectIDs:(NSArray *)replacedObjectIDs intoMOC:(NSManagedObjectContext *)importMOC usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters identityParameters:(BCCDataStoreControllerIdentityParameters *)identityParameters error:(NSError **)outError
+{
+    NSMutableSet *insertedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableSet *updatedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableSet *deletedObjectIDs = [[NSMutableSet alloc] init];
+    NSMutableDictionary *changedKeyMasksByObjectID = [[NSMutableDictionary alloc] init];
+    
+    NSArray *chunkObjects = nil;
+    
+    // An empty chunk deletes group objects the import has replaced
+    if (records.count < 1) {
+        if (self.usesBatchDeleteRequests && replacedObjectIDs.count > 0) {
+            [self batchDeleteObjectsWithEntityName:identityParameters.entityName predicate:[NSPredicate predicateWithFormat:@"self IN %@", replacedObjectIDs]];
+        } else {
+            for (NSManagedObjectID *currentObjectID in replacedObjectIDs) {
+                NSManagedObject *currentObject = [importMOC existingObjectWithID:currentObjectID error:NULL];
+                if (!currentObject) {
+                    continue;
+                }
+                
+                [self removeCacheObject:currentObject];
+                [importMOC deleteObject:currentObject];
+            }
+        }
+    } else {
+        NSIndexSet *indexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, records.count)];
+        chunkObjects = [self createObjectsFromJSONArray:records atIndexes:indexes baseIndex:baseIndex usingImportParameters:importParameters identityParameters:identityParameters affectedIndexes:nil];
+    }
+    
+    NSError *saveError = nil;
+    if (![self saveImportShardMOC:importMOC insertedObjectIDs:insertedObjectIDs updatedObjectIDs:updatedObjectIDs deletedObjectIDs:deletedObjectIDs changedKeyMasks:changedKeyMasksByObjectID error:&saveError]) {
+        [self clearObjectCacheForMOC:importMOC];
+        [importMOC reset];
+        
+        if (outError) {
+            *outError = saveError;
+        }
+        
+        return nil;
+    }
+    
+    NSMutableArray *chunkObjectIDs = [[NSMutableArray alloc] initWithCapacity:chunkObjects.count];
+    for (NSManagedObject *currentObject in chunkObjects) {
+        [chunkObjectIDs addObject:currentObject.objectID];
+    }
+    
+    [self mergeStoreChangesWithInsertedObjectIDs:insertedObjectIDs updatedObjectIDs:updatedObjectIDs deletedObjectIDs:deletedObjectIDs changedKeyMasks:changedKeyMasksByObjectID];
+    
+    // Drop everything this chunk touched so memory stays flat
+    [self clearObjectCacheForMOC:importMOC];
+    [importMOC reset];
+    
+    return chunkObjectIDs;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerIdentityParameters
+
+#pragma mark - Class Methods
+
++ (instancetype)identityParametersWithEntityName:(NSString *)entityName identityPropertyName:(NSString *)identityPropertyName
+{
+    BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
+    identityParameters.identityPropertyName = identityPropertyName;
+    
+    return identityParameters;
+}
+
++ (instancetype)identityParametersWithEntityName:(NSString *)entityName groupPropertyName:(NSString *)groupPropertyName
+{
+    BCCDataStoreControllerIdentityParameters *identityParameters = [[BCCDataStoreControllerIdentityParameters alloc] initWithEntityName:entityName];
+    identityParameters.groupPropertyName = groupPropertyName;
+    
+    return identityParameters;
+}
+
+#pragma mark - Initialization
+
+- (instancetype)initWithEntityName:(NSString *)entityName
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _entityName = entityName;
+    
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (BOOL)isValidForQuery
+{
+    return (_entityName != nil && _identityPropertyName != nil);
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerWorkParameters
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleMainMOCAndWait;
     
     _workBlock = NULL;
     _postSaveBlock = NULL;
@@ -1654,7 +3693,508 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
 
 #pragma mark -
 
-@implementation BCCDataStoreControllerImportParameters
+@implementation BCCDataStoreControllerImportParameters
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _findsExistingInBatches = NO;
+    _findExistingBatchSize = BCCDataStoreControllerDefaultFindExistingBatchSize;
+    
+    _streamingChunkSize = BCCDataStoreControllerDefaultStreamingChunkSize;
+    
+    return self;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerObserverParameters
+
+#pragma mark - Accessors
+
+- (BOOL)coalescesChanges
+{
+    return (self.coalescingInterval > 0 || self.maximumCoalescedSaveCount > 0);
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BCCDataStoreControllerObserverParameters *observerParameters = [[[self class] allocWithZone:zone] init];
+    observerParameters.predicate = self.predicate;
+    observerParameters.requiredChangedKeys = self.requiredChangedKeys;
+    observerParameters.coalescingInterval = self.coalescingInterval;
+    observerParameters.maximumCoalescedSaveCount = self.maximumCoalescedSaveCount;
+    
+    return observerParameters;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerQueryParameters
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _resultType = BCCDataStoreControllerQueryResultTypeManagedObjects;
+    _returnsObjectsAsFaults = YES;
+    
+    return self;
+}
+
+#pragma mark - Fetch Requests
+
+- (void)applyToFetchRequest:(NSFetchRequest *)fetchRequest
+{
+    fetchRequest.fetchBatchSize = self.fetchBatchSize;
+    fetchRequest.fetchOffset = self.fetchOffset;
+    fetchRequest.fetchLimit = self.fetchLimit;
+    
+    switch (self.resultType) {
+        case BCCDataStoreControllerQueryResultTypeObjectIDs:
+            fetchRequest.resultType = NSManagedObjectIDResultType;
+            fetchRequest.includesPropertyValues = NO;
+            break;
+        case BCCDataStoreControllerQueryResultTypeDictionaries:
+            fetchRequest.resultType = NSDictionaryResultType;
+            break;
+        default:
+            fetchRequest.resultType = NSManagedObjectResultType;
+            fetchRequest.returnsObjectsAsFaults = self.returnsObjectsAsFaults;
+            break;
+    }
+    
+    if (self.propertiesToFetch.count > 0) {
+        fetchRequest.propertiesToFetch = self.propertiesToFetch;
+    }
+    
+    if (self.relationshipKeyPathsForPrefetching.count > 0) {
+        fetchRequest.relationshipKeyPathsForPrefetching = self.relationshipKeyPathsForPrefetching;
+    }
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BCCDataStoreControllerQueryParameters *queryParameters = [[[self class] allocWithZone:zone] init];
+    queryParameters.fetchBatchSize = self.fetchBatchSize;
+    queryParameters.fetchOffset = self.fetchOffset;
+    queryParameters.fetchLimit = self.fetchLimit;
+    queryParameters.resultType = self.resultType;
+    queryParameters.propertiesToFetch = self.propertiesToFetch;
+    queryParameters.relationshipKeyPathsForPrefetching = self.relationshipKeyPathsForPrefetching;
+    queryParameters.returnsObjectsAsFaults = self.returnsObjectsAsFaults;
+    
+    return queryParameters;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerQueryCursor
+
+#pragma mark - Initialization
+
+- (id)initWithFetchRequest:(NSFetchRequest *)fetchRequest managedObjectContext:(NSManagedObjectContext *)managedObjectContext pageSize:(NSUInteger)pageSize
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _managedObjectContext = managedObjectContext;
+    _pageSize = pageSize;
+    _hasMoreResults = YES;
+    
+    _fetchRequest = fetchRequest;
+    _fetchRequest.fetchBatchSize = 0;
+    
+    return self;
+}
+
+#pragma mark - Paging
+
+- (NSArray *)nextPage:(NSError **)error
+{
+    if (!self.hasMoreResults) {
+        return nil;
+    }
+    
+    // Fetch every matching ID up front (within the request's own offset
+    // and limit) and page through those, rather than having the store
+    // skip over all the earlier rows again for every page
+    if (!self.objectIDs) {
+        NSFetchRequest *objectIDRequest = [self.fetchRequest copy];
+        objectIDRequest.resultType = NSManagedObjectIDResultType;
+        objectIDRequest.propertiesToFetch = nil;
+        objectIDRequest.propertiesToGroupBy = nil;
+        objectIDRequest.havingPredicate = nil;
+        objectIDRequest.returnsDistinctResults = NO;
+        
+        NSArray *objectIDs = [self.managedObjectContext executeFetchRequest:objectIDRequest error:error];
+        if (!objectIDs) {
+            self.hasMoreResults = NO;
+            return nil;
+        }
+        
+        self.objectIDs = objectIDs;
+    }
+    
+    NSRange pageRange = NSMakeRange(self.offset, MIN(self.pageSize, self.objectIDs.count - self.offset));
+    NSArray *pageObjectIDs = [self.objectIDs subarrayWithRange:pageRange];
+    
+    self.offset = NSMaxRange(pageRange);
+    if (self.offset >= self.objectIDs.count) {
+        self.hasMoreResults = NO;
+    }
+    
+    if (pageObjectIDs.count < 1 || self.fetchRequest.resultType == NSManagedObjectIDResultType) {
+        return pageObjectIDs;
+    }
+    
+    NSFetchRequest *pageRequest = [self.fetchRequest copy];
+    pageRequest.predicate = [NSPredicate predicateWithFormat:@"self IN %@", pageObjectIDs];
+    pageRequest.fetchOffset = 0;
+    pageRequest.fetchLimit = 0;
+    
+    NSArray *results = [self.managedObjectContext executeFetchRequest:pageRequest error:error];
+    if (!results) {
+        self.hasMoreResults = NO;
+        return nil;
+    }
+    
+    // Objects that tie on the sort order can come back either way round,
+    // so put them back in the order their IDs were fetched in
+    if (pageRequest.resultType == NSManagedObjectResultType) {
+        NSMutableDictionary *pageIndexesByObjectID = [[NSMutableDictionary alloc] initWithCapacity:pageObjectIDs.count];
+        [pageObjectIDs enumerateObjectsUsingBlock:^(NSManagedObjectID *currentObjectID, NSUInteger idx, BOOL *stop) {
+            [pageIndexesByObjectID setObject:@(idx) forKey:currentObjectID];
+        }];
+        
+        results = [results sortedArrayUsingComparator:^NSComparisonResult(NSManagedObject *firstObject, NSManagedObject *secondObject) {
+            return [[pageIndexesByObjectID objectForKey:firstObject.objectID] compare:[pageIndexesByObjectID objectForKey:secondObject.objectID]];
+        }];
+    }
+    
+    return results;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerPreparedQuery
+
+#pragma mark - Initialization
+
+- (id)initWithFetchRequestTemplate:(NSFetchRequest *)fetchRequestTemplate propertyList:(NSArray *)propertyList listPropertyNames:(NSSet *)listPropertyNames
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _fetchRequestTemplate = fetchRequestTemplate;
+    
+    _entityName = fetchRequestTemplate.entityName;
+    _propertyList = [propertyList copy];
+    _listPropertyNames = listPropertyNames ? [listPropertyNames copy] : [NSSet set];
+    _sortDescriptors = [fetchRequestTemplate.sortDescriptors copy];
+    
+    return self;
+}
+
+#pragma mark - Fetch Request Creation
+
+- (NSFetchRequest *)fetchRequestWithValueList:(NSArray *)valueList
+{
+    if (valueList.count != self.propertyList.count) {
+        return nil;
+    }
+    
+    NSFetchRequest *fetchRequest = [self.fetchRequestTemplate copy];
+    
+    if (valueList.count > 0) {
+        fetchRequest.predicate = [self.fetchRequestTemplate.predicate predicateWithSubstitutionVariables:[BCCDataStoreController predicateSubstitutionVariablesForValueList:valueList]];
+    }
+    
+    return fetchRequest;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerSaveStageStatistics
+
+#pragma mark - Statistics
+
+- (void)recordDuration:(NSTimeInterval)duration
+{
+    _count++;
+    _lastDuration = duration;
+    _totalDuration += duration;
+    _maximumDuration = MAX(_maximumDuration, duration);
+}
+
+- (NSTimeInterval)averageDuration
+{
+    return (self.count > 0) ? (self.totalDuration / self.count) : 0.0;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BCCDataStoreControllerSaveStageStatistics *stageStatistics = [[[self class] allocWithZone:zone] init];
+    stageStatistics->_count = _count;
+    stageStatistics->_lastDuration = _lastDuration;
+    stageStatistics->_totalDuration = _totalDuration;
+    stageStatistics->_maximumDuration = _maximumDuration;
+    
+    return stageStatistics;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerSaveStatistics
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _backgroundSaveStage = [[BCCDataStoreControllerSaveStageStatistics alloc] init];
+    _mainSaveStage = [[BCCDataStoreControllerSaveStageStatistics alloc] init];
+    _writeCommitQueueStage = [[BCCDataStoreControllerSaveStageStatistics alloc] init];
+    _writeCommitStage = [[BCCDataStoreControllerSaveStageStatistics alloc] init];
+    
+    return self;
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BCCDataStoreControllerSaveStatistics *saveStatistics = [[[self class] allocWithZone:zone] init];
+    saveStatistics->_backgroundSaveStage = [_backgroundSaveStage copy];
+    saveStatistics->_mainSaveStage = [_mainSaveStage copy];
+    saveStatistics->_writeCommitQueueStage = [_writeCommitQueueStage copy];
+    saveStatistics->_writeCommitStage = [_writeCommitStage copy];
+    saveStatistics->_lastWriteCommitSaveCount = _lastWriteCommitSaveCount;
+    
+    return saveStatistics;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerObjectCache
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    _entityTables = [[NSMutableDictionary alloc] init];
+    _entriesByObject = [[NSMapTable alloc] initWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory capacity:0];
+    
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (NSUInteger)count
+{
+    return self.entriesByObject.count;
+}
+
+- (NSMutableDictionary *)identityTableForEntityName:(NSString *)entityName groupKey:(id)groupKey create:(BOOL)create
+{
+    NSMutableDictionary *groupTables = [self.entityTables objectForKey:entityName];
+    if (!groupTables) {
+        if (!create) {
+            return nil;
+        }
+        
+        groupTables = [[NSMutableDictionary alloc] init];
+        [self.entityTables setObject:groupTables forKey:entityName];
+    }
+    
+    NSMutableDictionary *identityTable = [groupTables objectForKey:groupKey];
+    if (!identityTable && create) {
+        identityTable = [[NSMutableDictionary alloc] init];
+        [groupTables setObject:identityTable forKey:groupKey];
+    }
+    
+    return identityTable;
+}
+
+#pragma mark - Lookup
+
+- (NSManagedObject *)objectForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
+{
+    if (!entityName || !identityValue) {
+        return nil;
+    }
+    
+    id groupKey = groupIdentifier ? groupIdentifier : [NSNull null];
+    
+    NSMutableDictionary *identityTable = [self identityTableForEntityName:entityName groupKey:groupKey create:NO];
+    NSManagedObject *object = [identityTable objectForKey:identityValue];
+    
+    if (object) {
+        self.hitCount++;
+    } else {
+        self.missCount++;
+    }
+    
+    return object;
+}
+
+#pragma mark - Mutation
+
+- (void)setObject:(NSManagedObject *)object forEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
+{
+    if (!object || !entityName || !identityValue) {
+        return;
+    }
+    
+    id groupKey = groupIdentifier ? groupIdentifier : [NSNull null];
+    
+    // If this object was cached under another identity, drop the stale slot
+    BCCDataStoreControllerObjectCacheEntry *existingEntry = [self.entriesByObject objectForKey:object];
+    if (existingEntry) {
+        [self removeObject:object];
+    }
+    
+    NSMutableDictionary *identityTable = [self identityTableForEntityName:entityName groupKey:groupKey create:YES];
+    
+    // Likewise, if another object held this slot, forget its reverse entry
+    NSManagedObject *displacedObject = [identityTable objectForKey:identityValue];
+    if (displacedObject && displacedObject != object) {
+        [self.entriesByObject removeObjectForKey:displacedObject];
+    }
+    
+    [identityTable setObject:object forKey:identityValue];
+    
+    BCCDataStoreControllerObjectCacheEntry *entry = [[BCCDataStoreControllerObjectCacheEntry alloc] init];
+    entry.entityName = entityName;
+    entry.identityValue = identityValue;
+    entry.groupKey = groupKey;
+    
+    [self.entriesByObject setObject:entry forKey:object];
+}
+
+- (void)removeObjectForEntityName:(NSString *)entityName identityValue:(id)identityValue groupIdentifier:(NSString *)groupIdentifier
+{
+    if (!entityName || !identityValue) {
+        return;
+    }
+    
+    id groupKey = groupIdentifier ? groupIdentifier : [NSNull null];
+    
+    NSMutableDictionary *identityTable = [self identityTableForEntityName:entityName groupKey:groupKey create:NO];
+    NSManagedObject *object = [identityTable objectForKey:identityValue];
+    if (!object) {
+        return;
+    }
+    
+    [identityTable removeObjectForKey:identityValue];
+    [self.entriesByObject removeObjectForKey:object];
+}
+
+- (void)removeObject:(NSManagedObject *)object
+{
+    if (!object) {
+        return;
+    }
+    
+    BCCDataStoreControllerObjectCacheEntry *entry = [self.entriesByObject objectForKey:object];
+    if (!entry) {
+        return;
+    }
+    
+    NSMutableDictionary *identityTable = [self identityTableForEntityName:entry.entityName groupKey:entry.groupKey create:NO];
+    if ([identityTable objectForKey:entry.identityValue] == object) {
+        [identityTable removeObjectForKey:entry.identityValue];
+    }
+    
+    [self.entriesByObject removeObjectForKey:object];
+}
+
+- (void)removeAllObjectsForEntityName:(NSString *)entityName
+{
+    if (!entityName) {
+        return;
+    }
+    
+    NSDictionary *groupTables = [self.entityTables objectForKey:entityName];
+    if (!groupTables) {
+        return;
+    }
+    
+    for (NSDictionary *currentIdentityTable in groupTables.allValues) {
+        for (NSManagedObject *currentObject in currentIdentityTable.allValues) {
+            [self.entriesByObject removeObjectForKey:currentObject];
+        }
+    }
+    
+    [self.entityTables removeObjectForKey:entityName];
+}
+
+- (void)removeAllObjects
+{
+    [self.entityTables removeAllObjects];
+    [self.entriesByObject removeAllObjects];
+}
+
+#pragma mark - Statistics
+
+- (void)resetStatistics
+{
+    self.hitCount = 0;
+    self.missCount = 0;
+}
+
+- (NSString *)description
+{
+    return [[super description] stringByAppendingFormat:@"\nObjects: %lu\nHits: %lu\nMisses: %lu", (unsigned long)self.count, (unsigned long)self.hitCount, (unsigned long)self.missCount];
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerObjectCacheEntry
 
 @end
 
@@ -1674,12 +4214,27 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     _updatedObjects = dictionary[NSUpdatedObjectsKey];
     _insertedObjects = dictionary[NSInsertedObjectsKey];
     _deletedObjects = dictionary[NSDeletedObjectsKey];
+    _deletedObjectIDs = dictionary[BCCDataStoreChangeNotificationDeletedObjectIDsKey] ? dictionary[BCCDataStoreChangeNotificationDeletedObjectIDsKey] : [_deletedObjects valueForKey:@"objectID"];
     
     return self;
 }
 
+- (BCCDataStoreChangeNotification *)objectIDChangeNotification
+{
+    BCCDataStoreChangeNotification *changeNotification = [[BCCDataStoreChangeNotification alloc] init];
+    changeNotification.updatedObjectIDs = [_updatedObjects valueForKey:@"objectID"];
+    changeNotification.insertedObjectIDs = [_insertedObjects valueForKey:@"objectID"];
+    changeNotification.deletedObjectIDs = _deletedObjectIDs;
+    
+    return changeNotification;
+}
+
 - (NSString *)description
 {
+    if (!_updatedObjects && !_insertedObjects && !_deletedObjects) {
+        return [[super description] stringByAppendingFormat:@"\nUpdated Object IDs: %lu\nInserted Object IDs: %lu\nDeleted Object IDs: %lu", (unsigned long)_updatedObjectIDs.count, (unsigned long)_insertedObjectIDs.count, (unsigned long)_deletedObjectIDs.count];
+    }
+    
     return [[super description] stringByAppendingFormat:@"\nUpdated Objects: %lu\nInserted Objects: %lu\nDeleted Objects: %lu", (unsigned long)_updatedObjects.count, (unsigned long)_insertedObjects.count, (unsigned long)_deletedObjects.count];
 }
 
@@ -1700,6 +4255,343 @@ NSString *BCCDataStoreControllerDidClearIncompatibleDatabaseNotification = @"BCC
     return targetAction;
 }
 
+#pragma mark - Coalescing
+
+- (BOOL)coalesceInsertedObjects:(NSSet *)insertedObjects updatedObjects:(NSSet *)updatedObjects deletedObjects:(NSSet *)deletedObjects removedObjects:(NSSet *)removedObjects
+{
+    if (!self.coalescedInsertedObjects) {
+        self.coalescedInsertedObjects = [[NSMutableSet alloc] init];
+        self.coalescedUpdatedObjects = [[NSMutableSet alloc] init];
+        self.coalescedDeletedObjects = [[NSMutableSet alloc] init];
+    }
+    
+    BOOL didChange = NO;
+    
+    for (NSManagedObject *currentObject in insertedObjects) {
+        [self.coalescedDeletedObjects removeObject:currentObject];
+        [self.coalescedInsertedObjects addObject:currentObject];
+        didChange = YES;
+    }
+    
+    // Updates to objects inserted in this window are already
+    // covered by the insert
+    for (NSManagedObject *currentObject in updatedObjects) {
+        if ([self.coalescedInsertedObjects containsObject:currentObject]) {
+            continue;
+        }
+        
+        [self.coalescedUpdatedObjects addObject:currentObject];
+        didChange = YES;
+    }
+    
+    // Objects inserted and deleted in the same window cancel out
+    for (NSManagedObject *currentObject in deletedObjects) {
+        [self.coalescedUpdatedObjects removeObject:currentObject];
+        
+        if ([self.coalescedInsertedObjects containsObject:currentObject]) {
+            [self.coalescedInsertedObjects removeObject:currentObject];
+        } else {
+            [self.coalescedDeletedObjects addObject:currentObject];
+        }
+        
+        didChange = YES;
+    }
+    
+    for (NSManagedObject *currentObject in removedObjects) {
+        if ([self.coalescedInsertedObjects containsObject:currentObject] || [self.coalescedUpdatedObjects containsObject:currentObject]) {
+            [self.coalescedInsertedObjects removeObject:currentObject];
+            [self.coalescedUpdatedObjects removeObject:currentObject];
+            didChange = YES;
+        }
+    }
+    
+    return didChange;
+}
+
+- (BOOL)coalesceDeletedObjectIDs:(NSSet *)deletedObjectIDs
+{
+    if (deletedObjectIDs.count < 1) {
+        return NO;
+    }
+    
+    if (!self.coalescedDeletedObjectIDs) {
+        self.coalescedDeletedObjectIDs = [[NSMutableSet alloc] init];
+    }
+    
+    [self.coalescedDeletedObjectIDs unionSet:deletedObjectIDs];
+    
+    return YES;
+}
+
+- (BCCDataStoreChangeNotification *)takeCoalescedChangeNotification
+{
+    BCCDataStoreChangeNotification *changeNotification = nil;
+    
+    if (self.coalescedInsertedObjects.count > 0 || self.coalescedUpdatedObjects.count > 0 || self.coalescedDeletedObjects.count > 0 || self.coalescedDeletedObjectIDs.count > 0) {
+        NSMutableDictionary *changesets = [[NSMutableDictionary alloc] init];
+        [changesets setObject:(self.coalescedInsertedObjects ? [self.coalescedInsertedObjects copy] : [NSSet set]) forKey:NSInsertedObjectsKey];
+        [changesets setObject:(self.coalescedUpdatedObjects ? [self.coalescedUpdatedObjects copy] : [NSSet set]) forKey:NSUpdatedObjectsKey];
+        [changesets setObject:(self.coalescedDeletedObjects ? [self.coalescedDeletedObjects copy] : [NSSet set]) forKey:NSDeletedObjectsKey];
+        
+        if (self.coalescedDeletedObjectIDs.count > 0) {
+            NSMutableSet *deletedObjectIDs = [[self.coalescedDeletedObjects valueForKey:@"objectID"] mutableCopy];
+            if (!deletedObjectIDs) {
+                deletedObjectIDs = [[NSMutableSet alloc] init];
+            }
+            
+            [deletedObjectIDs unionSet:self.coalescedDeletedObjectIDs];
+            [changesets setObject:deletedObjectIDs forKey:BCCDataStoreChangeNotificationDeletedObjectIDsKey];
+        }
+        
+        changeNotification = [[BCCDataStoreChangeNotification alloc] initWithDictionary:changesets];
+    }
+    
+    [self.coalescedInsertedObjects removeAllObjects];
+    [self.coalescedUpdatedObjects removeAllObjects];
+    [self.coalescedDeletedObjects removeAllObjects];
+    [self.coalescedDeletedObjectIDs removeAllObjects];
+    
+    self.coalescedSaveCount = 0;
+    self.coalescingGeneration++;
+    self.coalescingFlushScheduled = NO;
+    
+    return changeNotification;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerJSONRecordReader
+
+#pragma mark - Initialization
+
+- (id)initWithInputStream:(NSInputStream *)inputStream
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _inputStream = inputStream;
+    _bytesRead = 0;
+    
+    _buffer = [[NSMutableData alloc] init];
+    _scanOffset = 0;
+    _recordStart = NSNotFound;
+    _depth = 0;
+    _format = BCCDataStoreControllerJSONRecordFormatUnknown;
+    
+    return self;
+}
+
+#pragma mark - Records
+
+- (NSDictionary *)nextRecord:(NSError **)outError
+{
+    while (YES) {
+        NSData *recordData = [self scanForRecordData];
+        if (recordData) {
+            NSError *error = nil;
+            // Top-level arrays can hold bare strings or numbers, which
+            // aren't records but shouldn't fail the import either
+            id record = [NSJSONSerialization JSONObjectWithData:recordData options:NSJSONReadingAllowFragments error:&error];
+            if (!record) {
+                if (outError) {
+                    *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorInvalidJSON userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Could not parse JSON record", @""), NSUnderlyingErrorKey: error}];
+                }
+                
+                return nil;
+            }
+            
+            if (![record isKindOfClass:[NSDictionary class]]) {
+                continue;
+            }
+            
+            return record;
+        }
+        
+        if (self.finished) {
+            return nil;
+        }
+        
+        if (self.streamAtEnd) {
+            // A JSON array has to be closed; newline-delimited input
+            // can just stop
+            self.finished = YES;
+            
+            if (self.format == BCCDataStoreControllerJSONRecordFormatArray && outError) {
+                *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorTruncatedJSON userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"JSON array ended early", @"")}];
+            }
+            
+            continue;
+        }
+        
+        if (![self readMoreBytes:outError]) {
+            return nil;
+        }
+    }
+}
+
+- (NSData *)scanForRecordData
+{
+    const uint8_t *bytes = self.buffer.bytes;
+    NSUInteger length = self.buffer.length;
+    
+    while (self.scanOffset < length) {
+        uint8_t currentByte = bytes[self.scanOffset];
+        BOOL isWhitespace = (currentByte == ' ' || currentByte == '\t' || currentByte == '\n' || currentByte == '\r');
+        
+        if (self.format == BCCDataStoreControllerJSONRecordFormatUnknown) {
+            if (isWhitespace) {
+                self.scanOffset++;
+            } else if (currentByte == '[') {
+                self.format = BCCDataStoreControllerJSONRecordFormatArray;
+                self.depth = 1;
+                self.scanOffset++;
+            } else {
+                self.format = BCCDataStoreControllerJSONRecordFormatLines;
+            }
+            
+            continue;
+        }
+        
+        if (self.format == BCCDataStoreControllerJSONRecordFormatLines) {
+            if (self.recordStart == NSNotFound) {
+                if (isWhitespace) {
+                    self.scanOffset++;
+                    continue;
+                }
+                
+                self.recordStart = self.scanOffset;
+            }
+            
+            if (currentByte == '\n') {
+                NSData *recordData = [self.buffer subdataWithRange:NSMakeRange(self.recordStart, self.scanOffset - self.recordStart)];
+                self.recordStart = NSNotFound;
+                self.scanOffset++;
+                
+                return recordData;
+            }
+            
+            self.scanOffset++;
+            continue;
+        }
+        
+        if (self.finished) {
+            return nil;
+        }
+        
+        // Between array elements
+        if (self.recordStart == NSNotFound) {
+            if (isWhitespace || currentByte == ',') {
+                self.scanOffset++;
+                continue;
+            }
+            
+            if (currentByte == ']') {
+                self.finished = YES;
+                self.scanOffset++;
+                return nil;
+            }
+            
+            self.recordStart = self.scanOffset;
+        }
+        
+        if (self.inString) {
+            if (self.escaped) {
+                self.escaped = NO;
+            } else if (currentByte == '\\') {
+                self.escaped = YES;
+            } else if (currentByte == '"') {
+                self.inString = NO;
+            }
+            
+            self.scanOffset++;
+            continue;
+        }
+        
+        // An element ends at the next top level comma, or at the
+        // bracket that closes the array, which is left for the next
+        // scan to find
+        BOOL closesArray = (self.depth == 1 && currentByte == ']');
+        if (closesArray || (self.depth == 1 && currentByte == ',')) {
+            NSData *recordData = [self.buffer subdataWithRange:NSMakeRange(self.recordStart, self.scanOffset - self.recordStart)];
+            self.recordStart = NSNotFound;
+            
+            if (!closesArray) {
+                self.scanOffset++;
+            }
+            
+            return recordData;
+        }
+        
+        if (currentByte == '"') {
+            self.inString = YES;
+        } else if (currentByte == '{' || currentByte == '[') {
+            self.depth++;
+        } else if (currentByte == '}' || currentByte == ']') {
+            self.depth--;
+        }
+        
+        self.scanOffset++;
+    }
+    
+    // Newline-delimited input doesn't need a newline after the last record
+    if (self.streamAtEnd && self.format == BCCDataStoreControllerJSONRecordFormatLines && self.recordStart != NSNotFound) {
+        NSData *recordData = [self.buffer subdataWithRange:NSMakeRange(self.recordStart, length - self.recordStart)];
+        self.recordStart = NSNotFound;
+        self.finished = YES;
+        
+        return recordData;
+    }
+    
+    if (self.streamAtEnd && self.format != BCCDataStoreControllerJSONRecordFormatArray) {
+        self.finished = YES;
+    }
+    
+    return nil;
+}
+
+- (BOOL)readMoreBytes:(NSError **)outError
+{
+    // Throw away everything before the record in progress so the
+    // buffer never grows past one record plus one read
+    NSUInteger consumedLength = (self.recordStart != NSNotFound) ? self.recordStart : self.scanOffset;
+    if (consumedLength > 0) {
+        [self.buffer replaceBytesInRange:NSMakeRange(0, consumedLength) withBytes:NULL length:0];
+        self.scanOffset -= consumedLength;
+        
+        if (self.recordStart != NSNotFound) {
+            self.recordStart -= consumedLength;
+        }
+    }
+    
+    // Read straight into the end of the buffer
+    NSUInteger bufferedLength = self.buffer.length;
+    [self.buffer increaseLengthBy:BCCDataStoreControllerJSONRecordReaderReadLength];
+    
+    NSInteger readLength = [self.inputStream read:((uint8_t *)self.buffer.mutableBytes + bufferedLength) maxLength:BCCDataStoreControllerJSONRecordReaderReadLength];
+    self.buffer.length = bufferedLength + MAX(readLength, 0);
+    
+    if (readLength < 0) {
+        if (outError) {
+            NSDictionary *userInfo = self.inputStream.streamError ? @{NSLocalizedDescriptionKey: NSLocalizedString(@"Could not read from import stream", @""), NSUnderlyingErrorKey: self.inputStream.streamError} : @{NSLocalizedDescriptionKey: NSLocalizedString(@"Could not read from import stream", @"")};
+            *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorStreamReadFailed userInfo:userInfo];
+        }
+        
+        return NO;
+    }
+    
+    if (readLength == 0) {
+        self.streamAtEnd = YES;
+        return YES;
+    }
+    
+    _bytesRead += readLength;
+    
+    return YES;
+}
+
 @end
 
 #pragma mark -
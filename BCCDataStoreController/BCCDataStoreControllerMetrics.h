@@ -0,0 +1,86 @@
+//
+//  BCCDataStoreControllerMetrics.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class BCCDataStoreControllerMetricsSnapshot;
+@class BCCDataStoreControllerMetricsHistogram;
+
+
+// Data store metrics. Those recorded per entity pass the entity name as
+// their dimension.
+extern NSString * const BCCDataStoreControllerMetricFetchDuration;
+extern NSString * const BCCDataStoreControllerMetricCountFetchDuration;
+extern NSString * const BCCDataStoreControllerMetricObjectCacheHits;
+extern NSString * const BCCDataStoreControllerMetricObjectCacheMisses;
+extern NSString * const BCCDataStoreControllerMetricBackgroundSaveDuration;
+extern NSString * const BCCDataStoreControllerMetricMainSaveDuration;
+extern NSString * const BCCDataStoreControllerMetricWriteCommitDuration;
+extern NSString * const BCCDataStoreControllerMetricWriteCommitQueueDuration;
+extern NSString * const BCCDataStoreControllerMetricObserverDispatchDuration;
+extern NSString * const BCCDataStoreControllerMetricObserverNotifications;
+extern NSString * const BCCDataStoreControllerMetricWorkBlockDuration;
+
+// Histograms have one bucket per power of two microseconds. 2^39
+// microseconds is about six days; anything longer shares the last bucket.
+enum {
+    BCCDataStoreControllerMetricsHistogramBucketCount = 40
+};
+
+
+// Receives metrics from a data store controller. Called on whatever queue
+// the measured work ran on, so implementations must be thread safe and
+// should return quickly.
+@protocol BCCDataStoreControllerMetricsRecorder <NSObject>
+
+- (void)incrementCounter:(NSString *)name dimension:(NSString *)dimension by:(uint64_t)amount;
+- (void)recordDuration:(NSTimeInterval)duration forHistogram:(NSString *)name dimension:(NSString *)dimension;
+
+@end
+
+
+// In-memory recorder with counters and log2 latency histograms
+@interface BCCDataStoreControllerMetrics : NSObject <BCCDataStoreControllerMetricsRecorder>
+
+// Signpost intervals around work blocks, on systems that have os_signpost.
+// Returns 0 when tracing isn't available.
++ (uint64_t)beginTraceSpanWithLabel:(NSString *)label;
++ (void)endTraceSpan:(uint64_t)spanIdentifier;
+
+- (BCCDataStoreControllerMetricsSnapshot *)snapshot;
+- (void)reset;
+
+@end
+
+
+// Metric values are keyed by name, or by "name.dimension" for metrics that
+// were recorded with a dimension
+@interface BCCDataStoreControllerMetricsSnapshot : NSObject
+
+@property (strong, nonatomic, readonly) NSDictionary *counters;
+@property (strong, nonatomic, readonly) NSDictionary *histograms;
+
+- (uint64_t)counterValueForName:(NSString *)name dimension:(NSString *)dimension;
+- (BCCDataStoreControllerMetricsHistogram *)histogramForName:(NSString *)name dimension:(NSString *)dimension;
+
+@end
+
+
+@interface BCCDataStoreControllerMetricsHistogram : NSObject <NSCopying>
+
+@property (nonatomic, readonly) uint64_t count;
+@property (nonatomic, readonly) NSTimeInterval totalDuration;
+@property (nonatomic, readonly) NSTimeInterval minimumDuration;
+@property (nonatomic, readonly) NSTimeInterval maximumDuration;
+@property (nonatomic, readonly) NSTimeInterval averageDuration;
+
+// Upper bound of the bucket holding the given percentile (0-100), so
+// accurate to within a factor of two
+- (NSTimeInterval)durationAtPercentile:(double)percentile;
+
+@end
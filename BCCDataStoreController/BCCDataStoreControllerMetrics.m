@@ -0,0 +1,347 @@
+//
+//  BCCDataStoreControllerMetrics.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCDataStoreControllerMetrics.h"
+
+#if __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+#define BCCDataStoreControllerMetricsHasSignposts 1
+#endif
+
+
+// Constants
+NSString * const BCCDataStoreControllerMetricFetchDuration = @"fetchDuration";
+NSString * const BCCDataStoreControllerMetricCountFetchDuration = @"countFetchDuration";
+NSString * const BCCDataStoreControllerMetricObjectCacheHits = @"objectCacheHits";
+NSString * const BCCDataStoreControllerMetricObjectCacheMisses = @"objectCacheMisses";
+NSString * const BCCDataStoreControllerMetricBackgroundSaveDuration = @"backgroundSaveDuration";
+NSString * const BCCDataStoreControllerMetricMainSaveDuration = @"mainSaveDuration";
+NSString * const BCCDataStoreControllerMetricWriteCommitDuration = @"writeCommitDuration";
+NSString * const BCCDataStoreControllerMetricWriteCommitQueueDuration = @"writeCommitQueueDuration";
+NSString * const BCCDataStoreControllerMetricObserverDispatchDuration = @"observerDispatchDuration";
+NSString * const BCCDataStoreControllerMetricObserverNotifications = @"observerNotifications";
+NSString * const BCCDataStoreControllerMetricWorkBlockDuration = @"workBlockDuration";
+
+
+static NSString *BCCDataStoreControllerMetricsKey(NSString *name, id dimension)
+{
+    if (!dimension || dimension == [NSNull null]) {
+        return name;
+    }
+    
+    return [NSString stringWithFormat:@"%@.%@", name, dimension];
+}
+
+#ifdef BCCDataStoreControllerMetricsHasSignposts
+static os_log_t BCCDataStoreControllerMetricsTraceLog(void)
+{
+    static os_log_t traceLog = NULL;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        traceLog = os_log_create("com.brooklyncomputerclub.BCCDataStoreController", "Work");
+    });
+    
+    return traceLog;
+}
+#endif
+
+
+@interface BCCDataStoreControllerMetricsCounter : NSObject
+
+@property (nonatomic) uint64_t value;
+
+@end
+
+
+@interface BCCDataStoreControllerMetricsHistogram () {
+    uint64_t _bucketCounts[BCCDataStoreControllerMetricsHistogramBucketCount];
+}
+
+- (void)recordDuration:(NSTimeInterval)duration;
+
+@end
+
+
+@interface BCCDataStoreControllerMetricsSnapshot ()
+
+- (id)initWithCounters:(NSDictionary *)counters histograms:(NSDictionary *)histograms;
+
+@end
+
+
+@interface BCCDataStoreControllerMetrics ()
+
+// Name -> dimension (or NSNull) -> counter or histogram. Each guarded by
+// @synchronized on the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *countersByName;
+@property (strong, nonatomic) NSMutableDictionary *histogramsByName;
+
+@end
+
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerMetrics
+
+#pragma mark - Class Methods
+
++ (uint64_t)beginTraceSpanWithLabel:(NSString *)label
+{
+#ifdef BCCDataStoreControllerMetricsHasSignposts
+    if (@available(iOS 12.0, macOS 10.14, tvOS 12.0, watchOS 5.0, *)) {
+        os_log_t traceLog = BCCDataStoreControllerMetricsTraceLog();
+        os_signpost_id_t spanIdentifier = os_signpost_id_generate(traceLog);
+        os_signpost_interval_begin(traceLog, spanIdentifier, "Work Block", "%{public}@", label);
+        
+        return spanIdentifier;
+    }
+#endif
+    
+    return 0;
+}
+
++ (void)endTraceSpan:(uint64_t)spanIdentifier
+{
+    if (!spanIdentifier) {
+        return;
+    }
+    
+#ifdef BCCDataStoreControllerMetricsHasSignposts
+    if (@available(iOS 12.0, macOS 10.14, tvOS 12.0, watchOS 5.0, *)) {
+        os_signpost_interval_end(BCCDataStoreControllerMetricsTraceLog(), spanIdentifier, "Work Block");
+    }
+#endif
+}
+
+#pragma mark - Initialization
+
+- (id)init
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _countersByName = [[NSMutableDictionary alloc] init];
+    _histogramsByName = [[NSMutableDictionary alloc] init];
+    
+    return self;
+}
+
+#pragma mark - BCCDataStoreControllerMetricsRecorder
+
+- (void)incrementCounter:(NSString *)name dimension:(NSString *)dimension by:(uint64_t)amount
+{
+    if (!name) {
+        return;
+    }
+    
+    id dimensionKey = dimension ? dimension : [NSNull null];
+    
+    @synchronized (self.countersByName) {
+        NSMutableDictionary *countersByDimension = [self.countersByName objectForKey:name];
+        if (!countersByDimension) {
+            countersByDimension = [[NSMutableDictionary alloc] init];
+            [self.countersByName setObject:countersByDimension forKey:name];
+        }
+        
+        BCCDataStoreControllerMetricsCounter *counter = [countersByDimension objectForKey:dimensionKey];
+        if (!counter) {
+            counter = [[BCCDataStoreControllerMetricsCounter alloc] init];
+            [countersByDimension setObject:counter forKey:dimensionKey];
+        }
+        
+        counter.value += amount;
+    }
+}
+
+- (void)recordDuration:(NSTimeInterval)duration forHistogram:(NSString *)name dimension:(NSString *)dimension
+{
+    if (!name) {
+        return;
+    }
+    
+    id dimensionKey = dimension ? dimension : [NSNull null];
+    
+    @synchronized (self.histogramsByName) {
+        NSMutableDictionary *histogramsByDimension = [self.histogramsByName objectForKey:name];
+        if (!histogramsByDimension) {
+            histogramsByDimension = [[NSMutableDictionary alloc] init];
+            [self.histogramsByName setObject:histogramsByDimension forKey:name];
+        }
+        
+        BCCDataStoreControllerMetricsHistogram *histogram = [histogramsByDimension objectForKey:dimensionKey];
+        if (!histogram) {
+            histogram = [[BCCDataStoreControllerMetricsHistogram alloc] init];
+            [histogramsByDimension setObject:histogram forKey:dimensionKey];
+        }
+        
+        [histogram recordDuration:duration];
+    }
+}
+
+#pragma mark - Snapshots
+
+- (BCCDataStoreControllerMetricsSnapshot *)snapshot
+{
+    NSMutableDictionary *counters = [[NSMutableDictionary alloc] init];
+    @synchronized (self.countersByName) {
+        [self.countersByName enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSDictionary *countersByDimension, BOOL *stop) {
+            [countersByDimension enumerateKeysAndObjectsUsingBlock:^(id dimension, BCCDataStoreControllerMetricsCounter *counter, BOOL *innerStop) {
+                [counters setObject:@(counter.value) forKey:BCCDataStoreControllerMetricsKey(name, dimension)];
+            }];
+        }];
+    }
+    
+    NSMutableDictionary *histograms = [[NSMutableDictionary alloc] init];
+    @synchronized (self.histogramsByName) {
+        [self.histogramsByName enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSDictionary *histogramsByDimension, BOOL *stop) {
+            [histogramsByDimension enumerateKeysAndObjectsUsingBlock:^(id dimension, BCCDataStoreControllerMetricsHistogram *histogram, BOOL *innerStop) {
+                [histograms setObject:[histogram copy] forKey:BCCDataStoreControllerMetricsKey(name, dimension)];
+            }];
+        }];
+    }
+    
+    return [[BCCDataStoreControllerMetricsSnapshot alloc] initWithCounters:counters histograms:histograms];
+}
+
+- (void)reset
+{
+    @synchronized (self.countersByName) {
+        [self.countersByName removeAllObjects];
+    }
+    
+    @synchronized (self.histogramsByName) {
+        [self.histogramsByName removeAllObjects];
+    }
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerMetricsSnapshot
+
+#pragma mark - Initialization
+
+- (id)initWithCounters:(NSDictionary *)counters histograms:(NSDictionary *)histograms
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _counters = [counters copy];
+    _histograms = [histograms copy];
+    
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (uint64_t)counterValueForName:(NSString *)name dimension:(NSString *)dimension
+{
+    if (!name) {
+        return 0;
+    }
+    
+    return [[self.counters objectForKey:BCCDataStoreControllerMetricsKey(name, dimension)] unsignedLongLongValue];
+}
+
+- (BCCDataStoreControllerMetricsHistogram *)histogramForName:(NSString *)name dimension:(NSString *)dimension
+{
+    if (!name) {
+        return nil;
+    }
+    
+    return [self.histograms objectForKey:BCCDataStoreControllerMetricsKey(name, dimension)];
+}
+
+- (NSString *)description
+{
+    return [[super description] stringByAppendingFormat:@"\nCounters: %@\nHistograms: %@", self.counters, self.histograms];
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerMetricsHistogram
+
+#pragma mark - Statistics
+
+- (void)recordDuration:(NSTimeInterval)duration
+{
+    if (duration < 0.0) {
+        duration = 0.0;
+    }
+    
+    _minimumDuration = (_count > 0) ? MIN(_minimumDuration, duration) : duration;
+    _maximumDuration = MAX(_maximumDuration, duration);
+    _totalDuration += duration;
+    _count++;
+    
+    // Bucket i holds durations under 2^i microseconds
+    uint64_t microseconds = (uint64_t)(duration * 1000000.0);
+    NSUInteger bucketIndex = microseconds ? (NSUInteger)(64 - __builtin_clzll(microseconds)) : 0;
+    
+    _bucketCounts[MIN(bucketIndex, BCCDataStoreControllerMetricsHistogramBucketCount - 1)]++;
+}
+
+- (NSTimeInterval)averageDuration
+{
+    return (self.count > 0) ? (self.totalDuration / self.count) : 0.0;
+}
+
+- (NSTimeInterval)durationAtPercentile:(double)percentile
+{
+    if (self.count < 1) {
+        return 0.0;
+    }
+    
+    uint64_t targetCount = (uint64_t)ceil(self.count * MAX(MIN(percentile, 100.0), 0.0) / 100.0);
+    if (targetCount < 1) {
+        return self.minimumDuration;
+    }
+    
+    uint64_t runningCount = 0;
+    for (NSUInteger i = 0; i < BCCDataStoreControllerMetricsHistogramBucketCount; i++) {
+        runningCount += _bucketCounts[i];
+        
+        if (runningCount >= targetCount) {
+            NSTimeInterval bucketLimit = (double)(1ULL << i) / 1000000.0;
+            return MIN(bucketLimit, self.maximumDuration);
+        }
+    }
+    
+    return self.maximumDuration;
+}
+
+- (NSString *)description
+{
+    return [[super description] stringByAppendingFormat:@" count: %llu average: %f p50: %f p99: %f max: %f", self.count, self.averageDuration, [self durationAtPercentile:50.0], [self durationAtPercentile:99.0], self.maximumDuration];
+}
+
+#pragma mark - NSCopying
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    BCCDataStoreControllerMetricsHistogram *histogram = [[[self class] allocWithZone:zone] init];
+    histogram->_count = _count;
+    histogram->_totalDuration = _totalDuration;
+    histogram->_minimumDuration = _minimumDuration;
+    histogram->_maximumDuration = _maximumDuration;
+    memcpy(histogram->_bucketCounts, _bucketCounts, sizeof(_bucketCounts));
+    
+    return histogram;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerMetricsCounter
+
+@end
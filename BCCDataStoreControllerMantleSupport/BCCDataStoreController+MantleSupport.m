@@ -20,6 +20,59 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorUnsupportedRelationshipC
 const NSInteger BCCDataStoreControllerMantleSupportErrorUniqueFetchRequestFailed = 7;
 const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapping = 8;
 
+// How many relationship hops deep mantleObjectsOfClass: prefetches
+const NSUInteger BCCDataStoreControllerMantleMaximumPrefetchDepth = 3;
+
+
+typedef enum {
+    BCCDataStoreControllerMantlePropertyMappingKindAttribute,
+    BCCDataStoreControllerMantlePropertyMappingKindRelationship,
+    BCCDataStoreControllerMantlePropertyMappingKindMissing,
+    BCCDataStoreControllerMantlePropertyMappingKindUnsupported
+} BCCDataStoreControllerMantlePropertyMappingKind;
+
+
+// Everything needed to move one model property to or from its entity
+// property, resolved once up front
+@interface BCCDataStoreControllerMantlePropertyMapping : NSObject
+
+@property (strong, nonatomic) NSString *propertyKey;
+@property (strong, nonatomic) NSString *managedObjectKey;
+@property (nonatomic) BCCDataStoreControllerMantlePropertyMappingKind kind;
+@property (strong, nonatomic) NSString *propertyDescriptionClassName;
+
+// Attributes
+@property (strong, nonatomic) NSValueTransformer *transformer;
+
+// Relationships
+@property (strong, nonatomic) NSString *nestedClassName;
+@property (nonatomic) Class nestedClass;
+@property (strong, nonatomic) NSEntityDescription *destinationEntity;
+@property (strong, nonatomic) NSString *inverseRelationshipName;
+@property (nonatomic) BOOL toMany;
+@property (nonatomic) BOOL ordered;
+
+@end
+
+
+// The property mappings for one model class and entity. Plans are built
+// the first time a pair is converted and shared from then on, so they
+// must not be mutated after they're cached.
+@interface BCCDataStoreControllerMantleMappingPlan : NSObject
+
+@property (strong, nonatomic) NSArray *propertyMappings;
+@property (strong, nonatomic) NSDictionary *propertyMappingsByPropertyKey;
+@property (strong, nonatomic) NSArray *relationshipMappings;
+
++ (instancetype)mappingPlanForModelClass:(Class)modelClass entity:(NSEntityDescription *)entity;
+
+- (id)initWithModelClass:(Class)modelClass entity:(NSEntityDescription *)entity;
+
+- (NSArray *)relationshipKeyPathsForPrefetchingToDepth:(NSUInteger)depth;
+- (NSArray *)relationshipKeyPathsForPrefetchingToDepth:(NSUInteger)depth excludingRelationshipNamed:(NSString *)excludedRelationshipName;
+
+@end
+
 
 @interface BCCDataStoreController (MantleSupportPrivate)
 
@@ -170,7 +223,27 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
         return nil;
     }
     
-    NSArray *affectedObjects = [self objectsForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:propertyName valueSet:valueSet sortDescriptors:sortDescriptors];
+    // Pull in every relationship the conversion will walk with the
+    // results, rather than faulting them in one object at a time
+    BCCDataStoreControllerQueryParameters *queryParameters = nil;
+    
+    NSEntityDescription *entity = identityParameters.entityName ? [NSEntityDescription entityForName:identityParameters.entityName inManagedObjectContext:[self currentMOC]] : nil;
+    if (entity) {
+        BCCDataStoreControllerMantleMappingPlan *mappingPlan = [BCCDataStoreControllerMantleMappingPlan mappingPlanForModelClass:modelClass entity:entity];
+        
+        NSArray *prefetchKeyPaths = [mappingPlan relationshipKeyPathsForPrefetchingToDepth:BCCDataStoreControllerMantleMaximumPrefetchDepth];
+        if (prefetchKeyPaths.count > 0) {
+            queryParameters = [[BCCDataStoreControllerQueryParameters alloc] init];
+            queryParameters.relationshipKeyPathsForPrefetching = prefetchKeyPaths;
+        }
+    }
+    
+    NSArray *affectedObjects = nil;
+    if (queryParameters) {
+        affectedObjects = [self objectsForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:propertyName valueSet:valueSet sortDescriptors:sortDescriptors queryParameters:queryParameters];
+    } else {
+        affectedObjects = [self objectsForIdentityParameters:identityParameters groupIdentifier:groupIdentifier filteredByProperty:propertyName valueSet:valueSet sortDescriptors:sortDescriptors];
+    }
     
     NSMutableArray *mantleObjects = [[NSMutableArray alloc] init];
     
@@ -200,31 +273,28 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
     // See https://github.com/github/Mantle/pull/120 for more context.
     __block NSError *tmpError;
     
-    Class modelClass = [model class];
-    NSDictionary *managedObjectKeysByPropertyKey = [modelClass managedObjectKeysByPropertyKey];
-
     NSDictionary *dictionaryValue = model.dictionaryValue;
-    NSDictionary *managedObjectProperties = managedObject.entity.propertiesByName;
     
     NSEntityDescription *entity = managedObject.entity;
     NSAssert(entity != nil, @"%@ returned a nil +entity", managedObject);
     
+    BCCDataStoreControllerMantleMappingPlan *mappingPlan = [BCCDataStoreControllerMantleMappingPlan mappingPlanForModelClass:[model class] entity:entity];
+    NSDictionary *propertyMappingsByPropertyKey = mappingPlan.propertyMappingsByPropertyKey;
+    
     [dictionaryValue enumerateKeysAndObjectsUsingBlock:^(NSString *propertyKey, id value, BOOL *stop) {
-        NSString *managedObjectKey = managedObjectKeysByPropertyKey[propertyKey];
-        if (managedObjectKey == nil) return;
+        BCCDataStoreControllerMantlePropertyMapping *propertyMapping = propertyMappingsByPropertyKey[propertyKey];
+        if (propertyMapping == nil) return;
         if ([value isEqual:NSNull.null]) value = nil;
         
-        BOOL (^serializeAttribute)(NSAttributeDescription *) = ^(NSAttributeDescription *attributeDescription) {
+        NSString *managedObjectKey = propertyMapping.managedObjectKey;
+        
+        BOOL (^serializeAttribute)(void) = ^(void) {
             // Mark this as being autoreleased, because validateValue may return
             // a new object to be stored in this variable (and we don't want ARC to
             // double-free or leak the old or new values).
             __autoreleasing id transformedValue = value;
             
-            NSValueTransformer *transformer = nil;
-            
-            if ([modelClass instancesRespondToSelector:@selector(entityAttributeTransformerForKey:)]) {
-                transformer = [modelClass entityAttributeTransformerForKey:propertyKey];
-            }
+            NSValueTransformer *transformer = propertyMapping.transformer;
             
             if ([transformer.class allowsReverseTransformation]) {
                 if ([transformer respondsToSelector:@selector(reverseTransformedValue:success:error:)]) {
@@ -275,10 +345,10 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             return managedObject;
         };
         
-        BOOL (^serializeRelationship)(NSRelationshipDescription *) = ^(NSRelationshipDescription *relationshipDescription) {
+        BOOL (^serializeRelationship)(void) = ^(void) {
             if (value == nil) return YES;
             
-            if ([relationshipDescription isToMany]) {
+            if (propertyMapping.toMany) {
                 if (![value conformsToProtocol:@protocol(NSFastEnumeration)]) {
                     NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"Property of class %@ cannot be encoded into a to-many relationship.", @""), [value class]];
                     
@@ -293,7 +363,7 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
                 }
                 
                 id relationshipCollection;
-                if ([relationshipDescription isOrdered]) {
+                if (propertyMapping.ordered) {
                     relationshipCollection = [NSMutableOrderedSet orderedSet];
                 } else {
                     relationshipCollection = [NSMutableSet set];
@@ -317,8 +387,8 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             return YES;
         };
         
-        BOOL (^serializeProperty)(NSPropertyDescription *) = ^(NSPropertyDescription *propertyDescription) {
-            if (propertyDescription == nil) {
+        BOOL (^serializeProperty)(void) = ^(void) {
+            if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindMissing) {
                 NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"No property by name \"%@\" exists on the entity.", @""), managedObjectKey];
                 
                 NSDictionary *userInfo = @{
@@ -331,14 +401,12 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
                 return NO;
             }
             
-            // Jump through some hoops to avoid referencing classes directly.
-            NSString *propertyClassName = NSStringFromClass(propertyDescription.class);
-            if ([propertyClassName isEqual:@"NSAttributeDescription"]) {
-                return serializeAttribute((id)propertyDescription);
-            } else if ([propertyClassName isEqual:@"NSRelationshipDescription"]) {
-                return serializeRelationship((id)propertyDescription);
+            if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindAttribute) {
+                return serializeAttribute();
+            } else if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindRelationship) {
+                return serializeRelationship();
             } else {
-                NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"Property descriptions of class %@ are unsupported.", @""), propertyClassName];
+                NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"Property descriptions of class %@ are unsupported.", @""), propertyMapping.propertyDescriptionClassName];
                 
                 NSDictionary *userInfo = @{
                                            NSLocalizedDescriptionKey: NSLocalizedString(@"Could not serialize managed object", @""),
@@ -351,7 +419,7 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             }
         };
         
-        serializeProperty(managedObjectProperties[managedObjectKey]);
+        serializeProperty();
     }];
     
     if (error != NULL) {
@@ -413,18 +481,10 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
 {
     if (processedObjects == NULL) return;
     
-    Class modelClass = [model class];
-    NSDictionary *managedObjectKeysByPropertyKey = [modelClass managedObjectKeysByPropertyKey];
-    
-    NSDictionary *relationshipModelClassesByPropertyKey = nil;
-    if ([modelClass respondsToSelector:@selector(relationshipModelClassesByPropertyKey)]) {
-        relationshipModelClassesByPropertyKey = [modelClass relationshipModelClassesByPropertyKey];
-    }
-    
     NSEntityDescription *entity = managedObject.entity;
     NSAssert(entity != nil, @"%@ returned a nil +entity", managedObject);
     
-    NSDictionary *managedObjectProperties = entity.propertiesByName;
+    BCCDataStoreControllerMantleMappingPlan *mappingPlan = [BCCDataStoreControllerMantleMappingPlan mappingPlanForModelClass:[model class] entity:entity];
     
     BOOL (^setValueForKey)(NSString *, id) = ^(NSString *key, id value) {
         // Mark this as being autoreleased, because validateValue may return
@@ -438,19 +498,14 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
         return YES;
     };
     
-    for (NSString *propertyKey in [modelClass propertyKeys]) {
-        NSString *managedObjectKey = managedObjectKeysByPropertyKey[propertyKey];
-        if (managedObjectKey == nil) continue;
-        
+    for (BCCDataStoreControllerMantlePropertyMapping *propertyMapping in mappingPlan.propertyMappings) {
+        NSString *propertyKey = propertyMapping.propertyKey;
+        NSString *managedObjectKey = propertyMapping.managedObjectKey;
         
-        BOOL (^deserializeAttribute)(NSAttributeDescription *) = ^(NSAttributeDescription *attributeDescription) {
+        BOOL (^deserializeAttribute)(void) = ^(void) {
             id value = [managedObject valueForKey:managedObjectKey];
             
-            NSValueTransformer *transformer = nil;
-            
-            if ([modelClass instancesRespondToSelector:@selector(entityAttributeTransformerForKey:)]) {
-                transformer = [modelClass entityAttributeTransformerForKey:propertyKey];
-            }
+            NSValueTransformer *transformer = propertyMapping.transformer;
             
             if ([transformer respondsToSelector:@selector(transformedValue:success:error:)]) {
                 id<MTLTransformerErrorHandling> errorHandlingTransformer = (id)transformer;
@@ -466,20 +521,18 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             return setValueForKey(propertyKey, value);
         };
         
-        BOOL (^deserializeRelationship)(NSRelationshipDescription *) = ^(NSRelationshipDescription *relationshipDescription) {
-            
-            NSString *nestedClassName = relationshipModelClassesByPropertyKey[propertyKey];
-            if (!nestedClassName) {
+        BOOL (^deserializeRelationship)(void) = ^(void) {
+            if (!propertyMapping.nestedClassName) {
                 return NO;
             }
             
-            Class nestedClass = NSClassFromString(nestedClassName);
+            Class nestedClass = propertyMapping.nestedClass;
             
             if (nestedClass == nil) {
                 [NSException raise:NSInvalidArgumentException format:@"No class specified for decoding relationship at key \"%@\" in managed object %@", managedObjectKey, managedObject];
             }
 
-            if ([relationshipDescription isToMany]) {
+            if (propertyMapping.toMany) {
                 id relationshipCollection = [managedObject valueForKey:managedObjectKey];
                 id models = [NSMutableArray arrayWithCapacity:[relationshipCollection count]];
 
@@ -490,7 +543,7 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
 
                 if (models == nil) return NO;
                 
-                if (![relationshipDescription isOrdered]) models = [NSSet setWithArray:models];
+                if (!propertyMapping.ordered) models = [NSSet setWithArray:models];
 
                 return setValueForKey(propertyKey, models);
             } else {
@@ -506,8 +559,8 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             }
         };
         
-        BOOL (^deserializeProperty)(NSPropertyDescription *) = ^(NSPropertyDescription *propertyDescription) {
-            if (propertyDescription == nil) {
+        BOOL (^deserializeProperty)(void) = ^(void) {
+            if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindMissing) {
                 if (error != NULL) {
                     NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"No property by name \"%@\" exists on the entity.", @""), managedObjectKey];
 
@@ -522,16 +575,13 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
                 return NO;
             }
 
-            // Jump through some hoops to avoid referencing classes directly.
-            NSString *propertyClassName = NSStringFromClass(propertyDescription.class);
-            
-            if ([propertyClassName isEqual:@"NSAttributeDescription"]) {
-                return deserializeAttribute((id)propertyDescription);
-            } else if ([propertyClassName isEqual:@"NSRelationshipDescription"]) {
-                return deserializeRelationship((id)propertyDescription);
+            if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindAttribute) {
+                return deserializeAttribute();
+            } else if (propertyMapping.kind == BCCDataStoreControllerMantlePropertyMappingKindRelationship) {
+                return deserializeRelationship();
             } else {
                 if (error != NULL) {
-                    NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"Property descriptions of class %@ are unsupported.", @""), propertyClassName];
+                    NSString *failureReason = [NSString stringWithFormat:NSLocalizedString(@"Property descriptions of class %@ are unsupported.", @""), propertyMapping.propertyDescriptionClassName];
                     
                     NSDictionary *userInfo = @{
                                                NSLocalizedDescriptionKey: NSLocalizedString(@"Could not deserialize managed object", @""),
@@ -545,7 +595,7 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
             }
         };
 
-        deserializeProperty(managedObjectProperties[managedObjectKey]);
+        deserializeProperty();
     }
 }
 
@@ -591,4 +641,160 @@ const NSInteger BCCDataStoreControllerMantleSupportErrorInvalidManagedObjectMapp
 
 @end
 
+#pragma mark -
+
+@implementation BCCDataStoreControllerMantlePropertyMapping
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerMantleMappingPlan
+
+#pragma mark - Class Methods
+
++ (instancetype)mappingPlanForModelClass:(Class)modelClass entity:(NSEntityDescription *)entity
+{
+    if (!modelClass || !entity) {
+        return nil;
+    }
+    
+    // Model class -> entity -> plan. Keyed by the entity itself rather
+    // than its name, since controllers with different models can share
+    // entity names. Guarded by @synchronized on the map table.
+    static NSMapTable *mappingPlansByModelClass = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        mappingPlansByModelClass = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory];
+    });
+    
+    @synchronized (mappingPlansByModelClass) {
+        NSMapTable *mappingPlansByEntity = [mappingPlansByModelClass objectForKey:modelClass];
+        if (!mappingPlansByEntity) {
+            mappingPlansByEntity = [NSMapTable mapTableWithKeyOptions:(NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality) valueOptions:NSPointerFunctionsStrongMemory];
+            [mappingPlansByModelClass setObject:mappingPlansByEntity forKey:modelClass];
+        }
+        
+        BCCDataStoreControllerMantleMappingPlan *mappingPlan = [mappingPlansByEntity objectForKey:entity];
+        if (!mappingPlan) {
+            mappingPlan = [[BCCDataStoreControllerMantleMappingPlan alloc] initWithModelClass:modelClass entity:entity];
+            [mappingPlansByEntity setObject:mappingPlan forKey:entity];
+        }
+        
+        return mappingPlan;
+    }
+}
+
+#pragma mark - Initialization
+
+- (id)initWithModelClass:(Class)modelClass entity:(NSEntityDescription *)entity
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    NSDictionary *managedObjectKeysByPropertyKey = [modelClass managedObjectKeysByPropertyKey];
+    
+    NSDictionary *relationshipModelClassesByPropertyKey = nil;
+    if ([modelClass respondsToSelector:@selector(relationshipModelClassesByPropertyKey)]) {
+        relationshipModelClassesByPropertyKey = [modelClass relationshipModelClassesByPropertyKey];
+    }
+    
+    BOOL hasTransformers = [modelClass respondsToSelector:@selector(entityAttributeTransformerForKey:)];
+    
+    NSDictionary *managedObjectProperties = entity.propertiesByName;
+    
+    NSMutableArray *propertyMappings = [[NSMutableArray alloc] init];
+    NSMutableDictionary *propertyMappingsByPropertyKey = [[NSMutableDictionary alloc] init];
+    NSMutableArray *relationshipMappings = [[NSMutableArray alloc] init];
+    
+    for (NSString *propertyKey in [modelClass propertyKeys]) {
+        NSString *managedObjectKey = managedObjectKeysByPropertyKey[propertyKey];
+        if (managedObjectKey == nil) continue;
+        
+        BCCDataStoreControllerMantlePropertyMapping *propertyMapping = [[BCCDataStoreControllerMantlePropertyMapping alloc] init];
+        propertyMapping.propertyKey = propertyKey;
+        propertyMapping.managedObjectKey = managedObjectKey;
+        
+        NSPropertyDescription *propertyDescription = managedObjectProperties[managedObjectKey];
+        
+        // Jump through some hoops to avoid referencing classes directly.
+        NSString *propertyClassName = propertyDescription ? NSStringFromClass(propertyDescription.class) : nil;
+        propertyMapping.propertyDescriptionClassName = propertyClassName;
+        
+        if (!propertyDescription) {
+            propertyMapping.kind = BCCDataStoreControllerMantlePropertyMappingKindMissing;
+        } else if ([propertyClassName isEqual:@"NSAttributeDescription"]) {
+            propertyMapping.kind = BCCDataStoreControllerMantlePropertyMappingKindAttribute;
+            
+            if (hasTransformers) {
+                propertyMapping.transformer = [modelClass entityAttributeTransformerForKey:propertyKey];
+            }
+        } else if ([propertyClassName isEqual:@"NSRelationshipDescription"]) {
+            NSRelationshipDescription *relationshipDescription = (NSRelationshipDescription *)propertyDescription;
+            
+            propertyMapping.kind = BCCDataStoreControllerMantlePropertyMappingKindRelationship;
+            propertyMapping.nestedClassName = relationshipModelClassesByPropertyKey[propertyKey];
+            propertyMapping.nestedClass = propertyMapping.nestedClassName ? NSClassFromString(propertyMapping.nestedClassName) : nil;
+            propertyMapping.destinationEntity = relationshipDescription.destinationEntity;
+            propertyMapping.inverseRelationshipName = relationshipDescription.inverseRelationship.name;
+            propertyMapping.toMany = relationshipDescription.isToMany;
+            propertyMapping.ordered = relationshipDescription.isOrdered;
+            
+            [relationshipMappings addObject:propertyMapping];
+        } else {
+            propertyMapping.kind = BCCDataStoreControllerMantlePropertyMappingKindUnsupported;
+        }
+        
+        [propertyMappings addObject:propertyMapping];
+        [propertyMappingsByPropertyKey setObject:propertyMapping forKey:propertyKey];
+    }
+    
+    _propertyMappings = propertyMappings;
+    _propertyMappingsByPropertyKey = propertyMappingsByPropertyKey;
+    _relationshipMappings = relationshipMappings;
+    
+    return self;
+}
+
+#pragma mark - Prefetching
+
+- (NSArray *)relationshipKeyPathsForPrefetchingToDepth:(NSUInteger)depth
+{
+    return [self relationshipKeyPathsForPrefetchingToDepth:depth excludingRelationshipNamed:nil];
+}
+
+- (NSArray *)relationshipKeyPathsForPrefetchingToDepth:(NSUInteger)depth excludingRelationshipNamed:(NSString *)excludedRelationshipName
+{
+    if (depth < 1) {
+        return nil;
+    }
+    
+    NSMutableArray *keyPaths = [[NSMutableArray alloc] init];
+    
+    for (BCCDataStoreControllerMantlePropertyMapping *currentMapping in self.relationshipMappings) {
+        if (!currentMapping.nestedClass || !currentMapping.destinationEntity) {
+            continue;
+        }
+        
+        // Following the inverse of the relationship we came in on only
+        // leads back to objects that are already being fetched
+        if (excludedRelationshipName && [currentMapping.managedObjectKey isEqualToString:excludedRelationshipName]) {
+            continue;
+        }
+        
+        [keyPaths addObject:currentMapping.managedObjectKey];
+        
+        BCCDataStoreControllerMantleMappingPlan *nestedPlan = [BCCDataStoreControllerMantleMappingPlan mappingPlanForModelClass:currentMapping.nestedClass entity:currentMapping.destinationEntity];
+        
+        for (NSString *nestedKeyPath in [nestedPlan relationshipKeyPathsForPrefetchingToDepth:(depth - 1) excludingRelationshipNamed:currentMapping.inverseRelationshipName]) {
+            [keyPaths addObject:[NSString stringWithFormat:@"%@.%@", currentMapping.managedObjectKey, nestedKeyPath]];
+        }
+    }
+    
+    return keyPaths;
+}
+
+@end
+
 #endif
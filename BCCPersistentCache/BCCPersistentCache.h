@@ -17,18 +17,55 @@ extern NSString *BCCPersistentCacheItemUpdatedNotification;
 extern NSString *BCCPersistentCacheItemUserInfoItemKey;
 extern NSString *BCCPersistentCacheItemUserInfoDataKey;
 
+// Metrics reported to the metricsRecorder inherited from
+// BCCDataStoreController, on top of its own
+extern NSString *BCCPersistentCacheMetricMemoryHits;
+extern NSString *BCCPersistentCacheMetricMappedMemoryHits;
+extern NSString *BCCPersistentCacheMetricMemoryMisses;
+extern NSString *BCCPersistentCacheMetricFileHits;
+extern NSString *BCCPersistentCacheMetricFileMisses;
+extern NSString *BCCPersistentCacheMetricBytesRead;
+extern NSString *BCCPersistentCacheMetricBytesWritten;
+extern NSString *BCCPersistentCacheMetricEvictionRuns;
+extern NSString *BCCPersistentCacheMetricEvictionDuration;
+extern NSString *BCCPersistentCacheMetricBytesEvicted;
+
 
 typedef void (^BCCPersistentCacheBlock)(void);
+typedef void (^BCCPersistentCacheDataBlock)(NSData *data);
+typedef void (^BCCPersistentCacheMultipleDataBlock)(NSDictionary *dataByKey);
+typedef void (^BCCPersistentCacheAttributesBlock)(NSDictionary *attributes);
 
 
 @interface BCCPersistentCache : BCCDataStoreController <NSCacheDelegate> 
 
 @property (strong, nonatomic, readonly) NSString *fileCachePath;
 @property (nonatomic) NSUInteger maximumMemoryCacheSize;
+@property (nonatomic) NSUInteger maximumMappedMemoryCacheSize;
 @property (nonatomic) NSUInteger maximumFileCacheSize;
 @property (nonatomic, readonly) NSUInteger totalFileCacheSize;
+@property (nonatomic) NSUInteger evictionBatchSize;
 @property (nonatomic) BOOL usesMemoryCache;
 
+// When enabled, entries no larger than maximumSegmentedEntrySize are
+// packed into shared segment files instead of getting a file each.
+@property (nonatomic) BOOL usesSegmentedFileStorage;
+@property (nonatomic) NSUInteger maximumSegmentedEntrySize;
+@property (nonatomic) NSUInteger maximumSegmentFileSize;
+
+// Standalone files at least this large are read with mmap rather than
+// copied onto the heap, and are kept in a memory tier of their own. 0
+// (the default) always copies.
+@property (nonatomic) NSUInteger mappedReadThreshold;
+
+// When enabled, background writes are queued and committed in batches of
+// up to writeBatchSize, at most writeBatchLatency seconds after the first
+// write in the batch. Overwrites of a queued key replace the queued data,
+// and didPersistBlocks fire once the whole batch has been saved.
+@property (nonatomic) BOOL usesWriteBatching;
+@property (nonatomic) NSUInteger writeBatchSize;
+@property (nonatomic) NSTimeInterval writeBatchLatency;
+
 // Static Methods
 + (NSString *)metadataModelPath;
 
@@ -47,9 +84,15 @@ typedef void (^BCCPersistentCacheBlock)(void);
 
 - (BOOL)hasCacheDataForKey:(NSString *)inKey;
 - (NSData *)cacheDataForKey:(NSString *)inKey;
+- (NSData *)cacheDataForKey:(NSString *)inKey range:(NSRange)inRange;
 - (NSData *)fileCacheDataForKey:(NSString *)inKey;
 - (NSDictionary *)attributesForKey:(NSString *)inKey;
 
+// Asynchronous Reads (completions are called on the main queue)
+- (void)cacheDataForKey:(NSString *)inKey completion:(BCCPersistentCacheDataBlock)completion;
+- (void)cacheDataForKeys:(NSArray *)inKeys completion:(BCCPersistentCacheMultipleDataBlock)completion;
+- (void)attributesForKey:(NSString *)inKey completion:(BCCPersistentCacheAttributesBlock)completion;
+
 - (void)removeCacheDataForKey:(NSString *)inKey;
 - (void)clearMemoryCache;
 - (void)clearCache;
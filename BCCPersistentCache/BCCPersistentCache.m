@@ -6,28 +6,64 @@
 //
 
 #import "BCCPersistentCache.h"
+#import "BCCPersistentCacheSegmentStore.h"
 #import "NSFileManager+BCCAdditions.h"
 #import "NSManagedObject+BCCAdditions.h"
 #import "NSString+BCCAdditions.h"
 
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+
 
 // Constants
 NSString *BCCPersistentCacheMetadataModelName = @"BCCPersistentCache";
 
 NSString *BCCPersistentCacheFileCacheSubdirectoryName = @"Data";
+NSString *BCCPersistentCacheSegmentSubdirectoryName = @"Segments";
 
 NSString *BCCPersistentCacheItemEntityName = @"PersistentCacheItem";
 NSString *BCCPersistentCacheItemCacheKeyModelKey = @"key";
 NSString *BCCPersistentCacheItemAddedTimestampModelKey = @"addedTimestamp";
+NSString *BCCPersistentCacheItemUpdatedTimestampModelKey = @"updatedTimestamp";
 NSString *BCCPersistentCacheItemFileSizeModelKey = @"fileSize";
+NSString *BCCPersistentCacheItemLastAccessedTimestampModelKey = @"lastAccessedTimestamp";
+NSString *BCCPersistentCacheItemSegmentIdentifierModelKey = @"segmentIdentifier";
+NSString *BCCPersistentCacheItemSegmentOffsetModelKey = @"segmentOffset";
 NSString *BCCPersistentCacheItemDataModelKey = @"data";
 
+NSString *BCCPersistentCacheMetricMemoryHits = @"memoryHits";
+NSString *BCCPersistentCacheMetricMappedMemoryHits = @"mappedMemoryHits";
+NSString *BCCPersistentCacheMetricMemoryMisses = @"memoryMisses";
+NSString *BCCPersistentCacheMetricFileHits = @"fileHits";
+NSString *BCCPersistentCacheMetricFileMisses = @"fileMisses";
+NSString *BCCPersistentCacheMetricBytesRead = @"bytesRead";
+NSString *BCCPersistentCacheMetricBytesWritten = @"bytesWritten";
+NSString *BCCPersistentCacheMetricEvictionRuns = @"evictionRuns";
+NSString *BCCPersistentCacheMetricEvictionDuration = @"evictionDuration";
+NSString *BCCPersistentCacheMetricBytesEvicted = @"bytesEvicted";
+
 NSString *BCCPersistentCacheItemUpdatedNotification = @"BCCPersistentCacheItemUpdatedNotification";
 NSString *BCCPersistentCacheItemUserInfoItemKey = @"item";
 NSString *BCCPersistentCacheItemUserInfoDataKey = @"data";
 
+NSString *BCCPersistentCacheTotalFileSizeMetadataKey = @"BCCPersistentCacheTotalFileSize";
+
 const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520;
 
+const NSUInteger BCCPersistentCacheDefaultEvictionBatchSize = 200;
+const NSUInteger BCCPersistentCacheDefaultMaximumSegmentedEntrySize = 32768;
+
+// Reads are batched into a single metadata update once this many keys
+// are pending, or after the flush delay, whichever comes first.
+const NSUInteger BCCPersistentCacheAccessFlushThreshold = 100;
+const NSTimeInterval BCCPersistentCacheAccessFlushDelay = 5.0;
+const NSUInteger BCCPersistentCacheAccessFlushFetchBatchSize = 500;
+const NSUInteger BCCPersistentCacheReadLocationFetchBatchSize = 500;
+
+const NSUInteger BCCPersistentCacheDefaultWriteBatchSize = 64;
+const NSTimeInterval BCCPersistentCacheDefaultWriteBatchLatency = 0.25;
+
 // 2MB      2097152
 // 10 MB    10485760
 // 20 MB    20971520;
@@ -39,8 +75,12 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
 @property (strong, nonatomic) NSString *fileName;
 @property (strong, nonatomic) NSDate *addedTimestamp;
 @property (strong, nonatomic) NSDate *updatedTimestamp;
+@property (strong, nonatomic) NSDate *lastAccessedTimestamp;
 @property (strong, nonatomic) NSDictionary *attributes;
 @property (nonatomic) NSUInteger fileSize;
+@property (nonatomic) NSUInteger segmentIdentifier;
+@property (nonatomic) NSUInteger segmentOffset;
+@property (nonatomic, readonly, getter=isStoredInSegment) BOOL storedInSegment;
 
 // Public Methods
 - (void)initializeForKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes;
@@ -50,13 +90,82 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
 @end
 
 
+// A background write waiting to be committed with the rest of its batch.
+// Either data or sourcePath is set, never both.
+@interface BCCPersistentCachePendingWrite : NSObject
+
+@property (strong, nonatomic) NSString *key;
+@property (strong, nonatomic) NSData *data;
+@property (strong, nonatomic) NSString *sourcePath;
+@property (strong, nonatomic) NSDictionary *attributes;
+@property (strong, nonatomic) NSMutableArray *didPersistBlocks;
+
+@end
+
+
+// What the in-memory index knows about a cache item. Attributes can be
+// arbitrarily large, so they're only filled in once somebody asks.
+@interface BCCPersistentCacheIndexEntry : NSObject
+
+@property (nonatomic) NSUInteger fileSize;
+@property (nonatomic) NSUInteger segmentIdentifier;
+@property (nonatomic) NSUInteger segmentOffset;
+@property (strong, nonatomic) NSDate *addedTimestamp;
+@property (strong, nonatomic) NSDate *updatedTimestamp;
+@property (strong, nonatomic) NSDictionary *attributes;
+@property (nonatomic) BOOL attributesLoaded;
+
++ (BCCPersistentCacheIndexEntry *)indexEntryForCacheItem:(BCCPersistentCacheItem *)inItem;
++ (BCCPersistentCacheIndexEntry *)indexEntryForDictionary:(NSDictionary *)inDictionary;
+
+@end
+
+
 @interface BCCPersistentCache ()
 
 @property (strong, nonatomic) NSString *cacheName;
 @property (strong, nonatomic) NSCache *memoryCache;
+
+// Memory mapped entries cost address space and page cache rather than
+// heap, so they're limited separately from heap copies
+@property (strong, nonatomic) NSCache *mappedMemoryCache;
 @property (strong, nonatomic) NSString *fileCachePath;
 @property (nonatomic) BOOL needsCacheTruncation;
 
+// Running total of file tier bytes, mirrored into the store metadata.
+// Guarded by @synchronized(self).
+@property (nonatomic) unsigned long long fileCacheSize;
+
+// Key -> last read date, waiting to be written to the metadata store.
+// Guarded by @synchronized on the dictionary itself.
+@property (strong, nonatomic) NSMutableDictionary *pendingAccessTimestamps;
+@property (nonatomic) BOOL accessFlushScheduled;
+
+@property (strong, nonatomic) BCCPersistentCacheSegmentStore *segmentStore;
+
+// Key -> BCCPersistentCacheIndexEntry for every item in the metadata store.
+// Only authoritative once cacheIndexLoaded is set; until then lookups fall
+// through to Core Data and the file system. Guarded by @synchronized on
+// the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *cacheIndex;
+@property (strong, nonatomic) NSMutableSet *keysRemovedDuringIndexLoad;
+@property (nonatomic) BOOL cacheIndexLoaded;
+@property (nonatomic) NSUInteger cacheIndexGeneration;
+
+// Reads issued through the asynchronous API run here, and callers asking
+// for a key that's already being read wait on that read instead of
+// starting their own. Key -> array of BCCPersistentCacheDataBlock,
+// guarded by @synchronized on the dictionary.
+@property (strong, nonatomic) dispatch_queue_t ioQueue;
+@property (strong, nonatomic) NSMutableDictionary *pendingReadCompletions;
+
+// Key -> BCCPersistentCachePendingWrite, for writes that haven't been
+// handed to a batch yet and for those in a batch that hasn't saved yet.
+// Both guarded by @synchronized on pendingWrites.
+@property (strong, nonatomic) NSMutableDictionary *pendingWrites;
+@property (strong, nonatomic) NSMutableDictionary *committingWrites;
+@property (nonatomic) BOOL writeFlushScheduled;
+
 + (NSString *)defaultRootDirectoryForIdentifier:(NSString *)inIdentifier rootPath:(NSString *)rootPath;
 
 // Cache Items
@@ -64,17 +173,63 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
 - (void)removeCacheItem:(BCCPersistentCacheItem *)inCacheItem;
 
 // Private Methods
+- (NSData *)_memoryCacheDataForKey:(NSString *)inKey;
+- (NSData *)_memoryCacheDataForKey:(NSString *)inKey recordingMetrics:(BOOL)inRecordsMetrics;
+- (NSData *)_fileCacheDataForKey:(NSString *)inKey wasMapped:(BOOL *)outWasMapped;
+- (NSData *)_fileCacheDataForKey:(NSString *)inKey indexEntry:(BCCPersistentCacheIndexEntry *)inIndexEntry wasMapped:(BOOL *)outWasMapped;
+- (void)_addFileData:(NSData *)inData toMemoryCacheForKey:(NSString *)inKey wasMapped:(BOOL)wasMapped;
+- (NSData *)_contentsOfFileAtPath:(NSString *)inPath fileSize:(unsigned long long)inFileSize wasMapped:(BOOL *)outWasMapped;
+- (void)_recordFileCacheReadOfData:(NSData *)inData;
 - (void)setFileCacheData:(NSData *)inData forKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes didPersistBlock:(BCCPersistentCacheBlock)didPersistBlock;
+- (void)_storeData:(NSData *)inData forKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes inItem:(BCCPersistentCacheItem *)inItem;
+- (BOOL)_storeFileAtPath:(NSString *)inPath forKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes inItem:(BCCPersistentCacheItem *)inItem;
 - (void)_updateFileCachePath;
 - (NSString *)_fileCachePathForKey:(NSString *)inKey;
 - (NSString *)_fileCachePathForName:(NSString *)inFileName;
 - (void)_clearFileCache;
 - (void)_clearCacheItemsToFitMaxFileCacheSize;
 - (void)_clearCacheItemsOfSize:(unsigned long long)inSize;
+- (NSPredicate *)_evictionCursorPredicateAfterItem:(BCCPersistentCacheItem *)inItem;
+- (NSPredicate *)_evictionCursorPredicateForDateKey:(NSString *)inDateKey date:(NSDate *)inDate tieBreakPredicate:(NSPredicate *)inTieBreakPredicate;
 - (void)_sendCacheItemUpdatedNotificationForItem:(BCCPersistentCacheItem *)updatedItem data:(NSData *)inData;
 
+// Segmented Storage
+- (void)_loadSegmentStatistics;
+- (BOOL)_appendData:(NSData *)inData toSegmentForItem:(BCCPersistentCacheItem *)inItem;
+- (void)_releaseFileCacheStorageForItem:(BCCPersistentCacheItem *)inItem;
+- (NSData *)_segmentedFileCacheDataForKey:(NSString *)inKey;
+- (void)_compactSegmentsIfNeeded;
+
+// Write Batching
+- (void)_enqueuePendingWrite:(BCCPersistentCachePendingWrite *)inWrite;
+- (void)_flushPendingWrites;
+- (BCCPersistentCachePendingWrite *)_pendingWriteForKey:(NSString *)inKey;
+
+// Asynchronous Reads
+- (BOOL)_addReadCompletion:(BCCPersistentCacheDataBlock)inCompletion forKey:(NSString *)inKey;
+- (void)_finishReadForKey:(NSString *)inKey data:(NSData *)inData;
+- (void)_readFileCacheDataForKeys:(NSArray *)inKeys;
+- (NSDictionary *)_indexEntriesForKeys:(NSArray *)inKeys;
+
+// Key Index
+- (void)_loadCacheIndex;
+- (BOOL)_cacheIndexLookupForKey:(NSString *)inKey entry:(BCCPersistentCacheIndexEntry **)outEntry;
+- (void)_updateCacheIndexForItem:(BCCPersistentCacheItem *)inItem;
+- (void)_removeCacheIndexEntryForKey:(NSString *)inKey;
+- (void)_resetCacheIndex;
+
+// Size Accounting
+- (void)_loadFileCacheSize;
+- (void)_adjustFileCacheSizeBy:(long long)inDelta;
+- (void)_resetFileCacheSize;
+
+// Access Tracking
+- (void)_noteAccessForKey:(NSString *)inKey;
+- (void)_flushPendingAccessTimestamps;
+
 // Private Core Data Methods
 - (BCCPersistentCacheItem *)_findOrCreateCacheItemForKey:(NSString *)inKey;
+- (void)_performLookupAndWait:(BCCDataStoreControllerWorkBlock)inBlock;
 
 @end
 
@@ -133,10 +288,35 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     _usesMemoryCache = YES;
     
     _maximumFileCacheSize = STPersistentCacheDefaultMaximumFileCacheSize;
+    _evictionBatchSize = BCCPersistentCacheDefaultEvictionBatchSize;
     
     _memoryCache = [[NSCache alloc] init];
     _memoryCache.delegate = self;
     
+    _mappedMemoryCache = [[NSCache alloc] init];
+    _mappedMemoryCache.delegate = self;
+    
+    _pendingAccessTimestamps = [[NSMutableDictionary alloc] init];
+    
+    _maximumSegmentedEntrySize = BCCPersistentCacheDefaultMaximumSegmentedEntrySize;
+    _segmentStore = [[BCCPersistentCacheSegmentStore alloc] initWithDirectoryPath:[self.rootDirectory stringByAppendingPathComponent:BCCPersistentCacheSegmentSubdirectoryName]];
+    
+    NSString *ioQueueName = [NSString stringWithFormat:@"com.brooklyncomputerclub.%@.IOQueue", NSStringFromClass([self class])];
+    _ioQueue = dispatch_queue_create([ioQueueName UTF8String], DISPATCH_QUEUE_CONCURRENT);
+    _pendingReadCompletions = [[NSMutableDictionary alloc] init];
+    
+    _writeBatchSize = BCCPersistentCacheDefaultWriteBatchSize;
+    _writeBatchLatency = BCCPersistentCacheDefaultWriteBatchLatency;
+    _pendingWrites = [[NSMutableDictionary alloc] init];
+    _committingWrites = [[NSMutableDictionary alloc] init];
+    
+    _cacheIndex = [[NSMutableDictionary alloc] init];
+    _keysRemovedDuringIndexLoad = [[NSMutableSet alloc] init];
+    
+    [self _loadFileCacheSize];
+    [self _loadSegmentStatistics];
+    [self _loadCacheIndex];
+    
     return self;
 }
 
@@ -157,19 +337,37 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     return self.memoryCache.totalCostLimit;
 }
 
+- (void)setMaximumMappedMemoryCacheSize:(NSUInteger)maximumMappedMemoryCacheSize;
+{
+    self.mappedMemoryCache.totalCostLimit = maximumMappedMemoryCacheSize;
+}
+
+- (NSUInteger)maximumMappedMemoryCacheSize;
+{
+    return self.mappedMemoryCache.totalCostLimit;
+}
+
 - (void)setMaximumFileCacheSize:(NSUInteger)maximumFileCacheSize;
 {
     _maximumFileCacheSize = maximumFileCacheSize;
     self.needsCacheTruncation = YES;
 }
 
+- (void)setMaximumSegmentFileSize:(NSUInteger)maximumSegmentFileSize;
+{
+    self.segmentStore.maximumSegmentFileSize = maximumSegmentFileSize;
+}
+
+- (NSUInteger)maximumSegmentFileSize;
+{
+    return (NSUInteger)self.segmentStore.maximumSegmentFileSize;
+}
+
 - (NSUInteger)totalFileCacheSize;
 {
-    if (!self.fileCachePath.length) {
-        return 0;
+    @synchronized (self) {
+        return (NSUInteger)_fileCacheSize;
     }
-    
-    return (NSUInteger)[[NSFileManager defaultManager] BCC_fileSizeAtPath:self.fileCachePath];
 }
 
 - (void)setNeedsCacheTruncation:(BOOL)inNeedsCacheTruncation;
@@ -192,7 +390,9 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
                 return;
             }
             
+            // We're already on the background context, so evict in place
             [self _clearCacheItemsToFitMaxFileCacheSize];
+            [self _compactSegmentsIfNeeded];
             
             _needsCacheTruncation = NO;
         };
@@ -207,6 +407,7 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     
     if (self.memoryCache && !usesMemoryCache) {
         _memoryCache = nil;
+        _mappedMemoryCache = nil;
     }
 }
 
@@ -235,6 +436,24 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
         return;
     }
     
+    if (inBackground && self.usesWriteBatching) {
+        if (self.usesMemoryCache) {
+            [self.memoryCache setObject:inData forKey:inKey cost:[inData length]];
+        }
+        
+        BCCPersistentCachePendingWrite *pendingWrite = [[BCCPersistentCachePendingWrite alloc] init];
+        pendingWrite.key = inKey;
+        pendingWrite.data = inData;
+        pendingWrite.attributes = attributes;
+        
+        if (didPersistBlock) {
+            [pendingWrite.didPersistBlocks addObject:[didPersistBlock copy]];
+        }
+        
+        [self _enqueuePendingWrite:pendingWrite];
+        return;
+    }
+    
     BCCDataStoreControllerWorkBlock setDataBlock = ^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
         // Add the data to the memory cache
         if (self.usesMemoryCache) {
@@ -257,17 +476,9 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
         return;
     }
     
-    // Add the data to the file cache (should overwrite)
-    NSString *filePath = [self _fileCachePathForKey:inKey];
-    if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
-        [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
-    }
-    
-    [inData writeToFile:filePath atomically:NO];
-    
     // Create a cache item or update the existing one
     BCCPersistentCacheItem *item = [self _findOrCreateCacheItemForKey:inKey];
-    [item initializeWithData:inData forKey:inKey withAttributes:attributes];
+    [self _storeData:inData forKey:inKey withAttributes:attributes inItem:item];
     
     if (didPersistBlock) {
         didPersistBlock();
@@ -276,6 +487,41 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     self.needsCacheTruncation = YES;
 }
 
+- (void)_storeData:(NSData *)inData forKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes inItem:(BCCPersistentCacheItem *)item;
+{
+    NSUInteger previousFileSize = item.fileSize;
+    
+    // Small entries get packed into a segment; anything else, or anything
+    // the segment store couldn't take, gets a file of its own
+    BOOL storedInSegment = NO;
+    if (self.usesSegmentedFileStorage && inData.length <= self.maximumSegmentedEntrySize) {
+        storedInSegment = [self _appendData:inData toSegmentForItem:item];
+    }
+    
+    if (!storedInSegment) {
+        if (item.storedInSegment) {
+            [self _releaseFileCacheStorageForItem:item];
+        }
+        
+        // Add the data to the file cache (should overwrite)
+        NSString *filePath = [self _fileCachePathForKey:inKey];
+        if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
+            [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
+        }
+        
+        // Replace rather than rewrite in place when reads may be mapped, so
+        // existing mappings keep the old file instead of faulting
+        [inData writeToFile:filePath atomically:(self.mappedReadThreshold > 0)];
+    }
+    
+    [item initializeWithData:inData forKey:inKey withAttributes:attributes];
+    [self _updateCacheIndexForItem:item];
+    
+    [self _adjustFileCacheSizeBy:(long long)item.fileSize - (long long)previousFileSize];
+    
+    [self.metricsRecorder incrementCounter:BCCPersistentCacheMetricBytesWritten dimension:nil by:inData.length];
+}
+
 - (void)addCacheDataFromFileAtPath:(NSString *)inPath forKey:(NSString *)inKey;
 {
     [self addCacheDataFromFileAtPath:inPath forKey:inKey inBackground:NO didPersistBlock:NULL];
@@ -292,29 +538,37 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
         return;
     }
     
+    if (inBackground && self.usesWriteBatching) {
+        BCCPersistentCachePendingWrite *pendingWrite = [[BCCPersistentCachePendingWrite alloc] init];
+        pendingWrite.key = inKey;
+        pendingWrite.sourcePath = inPath;
+        pendingWrite.attributes = attributes;
+        
+        if (didPersistBlock) {
+            [pendingWrite.didPersistBlocks addObject:[didPersistBlock copy]];
+        }
+        
+        [self _enqueuePendingWrite:pendingWrite];
+        return;
+    }
+    
     BCCDataStoreControllerWorkBlock setDataBlock = ^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
         if (![[NSFileManager defaultManager] fileExistsAtPath:inPath]) {
             return;
         }
         
-        if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
-            [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
-        }
-
-        NSString *filePath = [self _fileCachePathForKey:inKey];
-        NSError *moveError;
-        BOOL success = [[NSFileManager defaultManager] moveItemAtPath:inPath toPath:filePath error:&moveError];
-        if (!success) {
-            NSLog(@"Unable to add file at path %@ to cache due to error: %@", inPath, moveError);
+        // Create a cache item or update the existing one. The work block
+        // saves when we return, so there's no need to save here.
+        BCCPersistentCacheItem *item = [self _findOrCreateCacheItemForKey:inKey];
+        if (![self _storeFileAtPath:inPath forKey:inKey withAttributes:attributes inItem:item]) {
+            // An existing item still points at its old, intact file
+            if (item.isInserted) {
+                [context deleteObject:item];
+            }
+            
             return;
         }
         
-        // Create a cache item or update the existing one
-        BCCPersistentCacheItem *item = [self _findOrCreateCacheItemForKey:inKey];
-        [item initializeWithPath:inPath forKey:inKey withAttributes:nil];
-        
-        [self saveCurrentMOC];
-        
         if (didPersistBlock) {
             dispatch_async(dispatch_get_main_queue(), didPersistBlock);
         }
@@ -329,12 +583,58 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     }
 }
 
+- (BOOL)_storeFileAtPath:(NSString *)inPath forKey:(NSString *)inKey withAttributes:(NSDictionary *)attributes inItem:(BCCPersistentCacheItem *)item;
+{
+    if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
+        [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
+    }
+    
+    // Moving onto an existing file fails, so replacing one for a key
+    // that's already cached swaps it in place instead
+    NSString *filePath = [self _fileCachePathForKey:inKey];
+    NSError *moveError;
+    BOOL success = NO;
+    if ([[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
+        success = [[NSFileManager defaultManager] replaceItemAtURL:[NSURL fileURLWithPath:filePath] withItemAtURL:[NSURL fileURLWithPath:inPath] backupItemName:nil options:0 resultingItemURL:NULL error:&moveError];
+    } else {
+        success = [[NSFileManager defaultManager] moveItemAtPath:inPath toPath:filePath error:&moveError];
+    }
+    
+    if (!success) {
+        NSLog(@"Unable to add file at path %@ to cache due to error: %@", inPath, moveError);
+        return NO;
+    }
+    
+    // The source file has been moved by now, so size it at its new location
+    NSUInteger previousFileSize = item.fileSize;
+    
+    if (item.storedInSegment) {
+        [self _releaseFileCacheStorageForItem:item];
+    }
+    
+    [item initializeWithPath:filePath forKey:inKey withAttributes:attributes];
+    [self _updateCacheIndexForItem:item];
+    
+    [self _adjustFileCacheSizeBy:(long long)item.fileSize - (long long)previousFileSize];
+    
+    [self.metricsRecorder incrementCounter:BCCPersistentCacheMetricBytesWritten dimension:nil by:item.fileSize];
+    
+    return YES;
+}
+
 - (void)removeCacheDataForKey:(NSString *)inKey;
 {
     if (!inKey.length) {
         return;
     }
     
+    // A write that hasn't gone out yet never will. One in a batch that's
+    // already committing is skipped when the batch gets to it.
+    @synchronized (self.pendingWrites) {
+        [self.pendingWrites removeObjectForKey:inKey];
+        [self.committingWrites removeObjectForKey:inKey];
+    }
+    
     [self performBlockOnMainMOC:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
         BCCPersistentCacheItem *cacheItem = [self cacheItemForKey:inKey];
         if (cacheItem) {
@@ -354,11 +654,15 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     // Remove the data from the memory cache
     if (self.usesMemoryCache) {
         [self.memoryCache removeObjectForKey:key];
+        [self.mappedMemoryCache removeObjectForKey:key];
     }
     
-    // Remove the data from the file cache
-    NSString *filePath = [self _fileCachePathForKey:key];
-    [[NSFileManager defaultManager] removeItemAtPath:filePath error:NULL];
+    // Remove the data from the file cache. For segmented entries this
+    // is only a bookkeeping change; the bytes go away at compaction.
+    [self _releaseFileCacheStorageForItem:inCacheItem];
+    
+    [self _adjustFileCacheSizeBy:-(long long)inCacheItem.fileSize];
+    [self _removeCacheIndexEntryForKey:key];
         
     // Delete the cache item
     [[self currentMOC] deleteObject:inCacheItem];
@@ -366,18 +670,37 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
 
 - (NSDictionary *)attributesForKey:(NSString *)inKey;
 {
-    __block BCCPersistentCacheItem *item = nil;
-    /*[self performBlockOnBackgroundMOC:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext) {
-        item = [self cacheItemForKey:inKey];
-        NSLog(@"Found ITEM: %@", item);
-    }];
-     
-    return nil;*/
+    BCCPersistentCachePendingWrite *pendingWrite = [self _pendingWriteForKey:inKey];
+    if (pendingWrite) {
+        return pendingWrite.attributes;
+    }
+    
+    BCCPersistentCacheIndexEntry *indexEntry = nil;
+    if ([self _cacheIndexLookupForKey:inKey entry:&indexEntry]) {
+        if (!indexEntry) {
+            return nil;
+        }
+        
+        @synchronized (self.cacheIndex) {
+            if (indexEntry.attributesLoaded) {
+                return indexEntry.attributes;
+            }
+        }
+    }
     
-    [self performBlockOnBackgroundMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
-        item = [self cacheItemForKey:inKey];
+    __block NSDictionary *attributes = nil;
+    [self _performLookupAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+        attributes = [self cacheItemForKey:inKey].attributes;
     }];
-    return item.attributes;
+    
+    if (indexEntry) {
+        @synchronized (self.cacheIndex) {
+            indexEntry.attributes = attributes;
+            indexEntry.attributesLoaded = YES;
+        }
+    }
+    
+    return attributes;
 }
 
 - (BCCPersistentCacheItem *)cacheItemForKey:(NSString *)inKey;
@@ -397,23 +720,103 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
         return nil;
     }
     
-    if (self.usesMemoryCache) {
-        NSData *memoryData = [self.memoryCache objectForKey:inKey];
-        if (memoryData) {
-            return memoryData;
-        }
+    NSData *memoryData = [self _memoryCacheDataForKey:inKey];
+    if (memoryData) {
+        [self _noteAccessForKey:inKey];
+        return memoryData;
     }
     
-    NSData *fileData = [self fileCacheDataForKey:inKey];
-    if (fileData.length && self.usesMemoryCache) {
-        [self.memoryCache setObject:fileData forKey:inKey cost:[fileData length]];
-    }
+    BOOL wasMapped = NO;
+    NSData *fileData = [self _fileCacheDataForKey:inKey wasMapped:&wasMapped];
+    [self _recordFileCacheReadOfData:fileData];
+    [self _addFileData:fileData toMemoryCacheForKey:inKey wasMapped:wasMapped];
    
     return fileData;
 }
 
+- (NSData *)cacheDataForKey:(NSString *)inKey range:(NSRange)inRange;
+{
+    if (!inKey.length || !inRange.length) {
+        return nil;
+    }
+    
+    NSData *fullData = [self _memoryCacheDataForKey:inKey];
+    
+    BCCPersistentCacheIndexEntry *indexEntry = nil;
+    if (!fullData && [self _cacheIndexLookupForKey:inKey entry:&indexEntry] && !indexEntry) {
+        return nil;
+    }
+    
+    if (!fullData) {
+        // Read just the requested bytes of a standalone file
+        NSString *cachePath = [self _fileCachePathForKey:inKey];
+        int descriptor = cachePath ? open([cachePath fileSystemRepresentation], O_RDONLY) : -1;
+        
+        if (descriptor >= 0) {
+            NSMutableData *rangeData = nil;
+            
+            struct stat fileStat;
+            if (fstat(descriptor, &fileStat) == 0 && (unsigned long long)fileStat.st_size > inRange.location) {
+                NSUInteger rangeLength = (NSUInteger)MIN((unsigned long long)inRange.length, (unsigned long long)fileStat.st_size - inRange.location);
+                rangeData = [[NSMutableData alloc] initWithLength:rangeLength];
+                
+                ssize_t bytesRead = pread(descriptor, rangeData.mutableBytes, rangeLength, (off_t)inRange.location);
+                if (bytesRead < 0) {
+                    rangeData = nil;
+                } else {
+                    rangeData.length = (NSUInteger)bytesRead;
+                }
+            }
+            
+            close(descriptor);
+            
+            if (rangeData) {
+                [self _noteAccessForKey:inKey];
+            }
+            
+            [self _recordFileCacheReadOfData:rangeData];
+            
+            return rangeData;
+        }
+        
+        // Segmented entries are small enough to read whole
+        if (self.segmentStore.hasSegments) {
+            fullData = [self _segmentedFileCacheDataForKey:inKey];
+        }
+        
+        if (!fullData) {
+            return nil;
+        }
+    }
+    
+    [self _noteAccessForKey:inKey];
+    
+    if (inRange.location >= fullData.length) {
+        return nil;
+    }
+    
+    return [fullData subdataWithRange:NSMakeRange(inRange.location, MIN(inRange.length, fullData.length - inRange.location))];
+}
+
 - (NSData *)fileCacheDataForKey:(NSString *)inKey;
+{
+    return [self _fileCacheDataForKey:inKey wasMapped:NULL];
+}
+
+- (NSData *)_fileCacheDataForKey:(NSString *)inKey wasMapped:(BOOL *)outWasMapped;
 {    
+    // Queued writes are newer than anything on disk. A queued file that's
+    // already been moved into place is read from its new home below.
+    BCCPersistentCachePendingWrite *pendingWrite = [self _pendingWriteForKey:inKey];
+    NSData *pendingData = pendingWrite.data;
+    if (!pendingData && pendingWrite.sourcePath) {
+        pendingData = [NSData dataWithContentsOfFile:pendingWrite.sourcePath];
+    }
+    
+    if (pendingData) {
+        return pendingData;
+    }
+    
     /*STPersistentCacheItem *cacheItem = [self cacheItemForKey:inKey];
     NSString *cachePath = [self _fileCachePathForName:cacheItem.fileName];
     if (!cachePath) {
@@ -422,113 +825,721 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     
     return [NSData dataWithContentsOfFile:cachePath];*/
     
+    BCCPersistentCacheIndexEntry *indexEntry = nil;
+    if ([self _cacheIndexLookupForKey:inKey entry:&indexEntry]) {
+        // A definite miss costs neither a stat nor a fetch
+        return [self _fileCacheDataForKey:inKey indexEntry:indexEntry wasMapped:outWasMapped];
+    }
+    
     NSString *cachePath = [self _fileCachePathForKey:inKey];
     if (!cachePath) {
         return nil;
     }
     
-    return [NSData dataWithContentsOfFile:cachePath];
-}
-
-- (void)clearCache;
-{
-    [self clearMemoryCache];
-
-    [self deletePersistentStore];
-    [self _clearFileCache];    
+    NSData *fileData = [self _contentsOfFileAtPath:cachePath fileSize:0 wasMapped:outWasMapped];
+    if (!fileData && self.segmentStore.hasSegments) {
+        fileData = [self _segmentedFileCacheDataForKey:inKey];
+    }
     
-    if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
-        [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
+    if (fileData) {
+        [self _noteAccessForKey:inKey];
     }
+    
+    return fileData;
 }
 
-- (void)clearMemoryCache
-{
-    [self.memoryCache removeAllObjects];
-}
-
-- (BOOL)hasCacheDataForKey:(NSString *)inKey
-{
-    NSString *filePath = [self _fileCachePathForKey:inKey];
-    return [[NSFileManager defaultManager] fileExistsAtPath:filePath];
-}
-
-#pragma mark Private Methods
-
-- (void)_updateFileCachePath;
-{
-    self.fileCachePath = [self.rootDirectory stringByAppendingPathComponent:BCCPersistentCacheFileCacheSubdirectoryName];
-}
-
-- (NSString *)_fileCachePathForName:(NSString *)inFileName;
+- (NSData *)_fileCacheDataForKey:(NSString *)inKey indexEntry:(BCCPersistentCacheIndexEntry *)inIndexEntry wasMapped:(BOOL *)outWasMapped;
 {
-    if (!inFileName.length || !self.fileCachePath.length) {
+    if (!inIndexEntry) {
         return nil;
     }
     
-    return [self.fileCachePath stringByAppendingPathComponent:inFileName];
+    NSData *fileData = nil;
+    if (inIndexEntry.segmentIdentifier != BCCPersistentCacheSegmentStoreNoSegment) {
+        fileData = [self.segmentStore dataForKey:inKey segmentIdentifier:inIndexEntry.segmentIdentifier offset:inIndexEntry.segmentOffset length:inIndexEntry.fileSize];
+    } else {
+        fileData = [self _contentsOfFileAtPath:[self _fileCachePathForKey:inKey] fileSize:inIndexEntry.fileSize wasMapped:outWasMapped];
+    }
+    
+    if (fileData) {
+        [self _noteAccessForKey:inKey];
+    }
+    
+    return fileData;
 }
 
-- (NSString *)_fileCachePathForKey:(NSString *)inKey;
+- (void)_addFileData:(NSData *)inData toMemoryCacheForKey:(NSString *)inKey wasMapped:(BOOL)wasMapped;
 {
-    if (!inKey.length || !self.fileCachePath.length) {
-        return nil;
+    if (!inData.length || !self.usesMemoryCache) {
+        return;
     }
     
-    return [self.fileCachePath stringByAppendingPathComponent:[inKey BCC_MD5String]];
+    NSCache *memoryCache = wasMapped ? self.mappedMemoryCache : self.memoryCache;
+    [memoryCache setObject:inData forKey:inKey cost:[inData length]];
 }
 
-- (void)_clearFileCache;
-{
-    [[NSFileManager defaultManager] removeItemAtPath:self.fileCachePath error:NULL];
-}
+#pragma mark Write Batching
 
-- (void)_clearCacheItemsToFitMaxFileCacheSize;
+- (void)_enqueuePendingWrite:(BCCPersistentCachePendingWrite *)inWrite;
 {
-    NSUInteger cacheSize = self.totalFileCacheSize;
-    if (cacheSize <= self.maximumFileCacheSize) {
-        return;
+    BOOL shouldFlush = NO;
+    BOOL shouldScheduleFlush = NO;
+    
+    @synchronized (self.pendingWrites) {
+        // Coalesce with a queued write of the same key: the newest data
+        // wins, and everybody waiting on either hears about it
+        BCCPersistentCachePendingWrite *existingWrite = [self.pendingWrites objectForKey:inWrite.key];
+        if (existingWrite) {
+            [inWrite.didPersistBlocks insertObjects:existingWrite.didPersistBlocks atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, existingWrite.didPersistBlocks.count)]];
+        }
+        
+        [self.pendingWrites setObject:inWrite forKey:inWrite.key];
+        
+        if (self.pendingWrites.count >= MAX(self.writeBatchSize, 1)) {
+            shouldFlush = YES;
+        } else if (!self.writeFlushScheduled) {
+            self.writeFlushScheduled = YES;
+            shouldScheduleFlush = YES;
+        }
     }
     
-    NSUInteger spaceToClear = cacheSize - self.maximumFileCacheSize;
-    [self _clearCacheItemsOfSize:spaceToClear];
+    if (shouldFlush) {
+        [self _flushPendingWrites];
+    } else if (shouldScheduleFlush) {
+        dispatch_time_t flushTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.writeBatchLatency * NSEC_PER_SEC));
+        dispatch_after(flushTime, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [self _flushPendingWrites];
+        });
+    }
 }
 
-- (void)_clearCacheItemsOfSize:(unsigned long long)inSize;
+- (void)_flushPendingWrites;
 {
-    NSLog(@"Clearing Persistent Cache");
+    NSDictionary *batchWrites = nil;
     
-    if (!inSize) {
-        return;
-    } else if (inSize >= self.totalFileCacheSize) {
-        [self clearCache];
+    @synchronized (self.pendingWrites) {
+        batchWrites = [self.pendingWrites copy];
+        [self.pendingWrites removeAllObjects];
+        [self.committingWrites addEntriesFromDictionary:batchWrites];
+        self.writeFlushScheduled = NO;
+    }
+    
+    if (batchWrites.count < 1) {
         return;
     }
     
-    [self performBlockOnBackgroundMOC:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
-        NSFetchRequest *cacheItemFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName sortDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:BCCPersistentCacheItemAddedTimestampModelKey ascending:NO]]];
-        NSError *fetchError = nil;
-        NSArray *cacheItems = [self performFetchRequest:cacheItemFetchRequest error:&fetchError];
-        if (fetchError || cacheItems.count < 1) {
-            return;
+    BCCDataStoreControllerWorkParameters *workParameters = [[BCCDataStoreControllerWorkParameters alloc] init];
+    workParameters.workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleBackgroundMOC;
+    workParameters.shouldSave = YES;
+    
+    workParameters.workBlock = ^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        // One round trip for all of the existing items in the batch
+        BCCDataStoreControllerIdentityParameters *identityParameters = [BCCDataStoreControllerIdentityParameters identityParametersWithEntityName:BCCPersistentCacheItemEntityName identityPropertyName:BCCPersistentCacheItemCacheKeyModelKey];
+        NSDictionary *existingItems = [self existingObjectsForIdentityParameters:identityParameters identityValueList:batchWrites.allKeys groupIdentifier:nil batchSize:BCCDataStoreControllerDefaultFindExistingBatchSize];
+        
+        for (BCCPersistentCachePendingWrite *currentWrite in batchWrites.allValues) {
+            @autoreleasepool {
+                // Removed, or superseded by a later batch, since we started
+                BOOL isCurrentWrite = NO;
+                @synchronized (self.pendingWrites) {
+                    isCurrentWrite = ([self.committingWrites objectForKey:currentWrite.key] == currentWrite);
+                }
+                
+                if (!isCurrentWrite) {
+                    continue;
+                }
+                
+                BCCPersistentCacheItem *item = [existingItems objectForKey:currentWrite.key];
+                
+                // Moving the file in can fail, so don't create an item
+                // until we know there's something to point it at
+                if (currentWrite.sourcePath && ![[NSFileManager defaultManager] fileExistsAtPath:currentWrite.sourcePath]) {
+                    continue;
+                }
+                
+                if (!item) {
+                    item = (BCCPersistentCacheItem *)[self createAndInsertObjectWithIdentityParameters:identityParameters identityValue:currentWrite.key groupIdentifier:nil];
+                }
+                
+                if (currentWrite.data) {
+                    [self _storeData:currentWrite.data forKey:currentWrite.key withAttributes:currentWrite.attributes inItem:item];
+                } else if (![self _storeFileAtPath:currentWrite.sourcePath forKey:currentWrite.key withAttributes:currentWrite.attributes inItem:item] && item.isInserted) {
+                    // Only the item this batch made has nothing behind it;
+                    // an existing one still points at its old, intact file
+                    [context deleteObject:item];
+                }
+            }
         }
         
-        unsigned long long totalCleared = 0;
+        self.needsCacheTruncation = YES;
+    };
+    
+    workParameters.postSaveBlock = ^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        NSMutableArray *didPersistBlocks = [[NSMutableArray alloc] init];
         
-        for (BCCPersistentCacheItem *currentItem in cacheItems) {
-            unsigned long long itemSize = currentItem.fileSize;
-            
-            [self removeCacheItem:currentItem];
-            
-            totalCleared += itemSize;
-            
-            if (totalCleared >= inSize) {
-                break;
+        @synchronized (self.pendingWrites) {
+            for (BCCPersistentCachePendingWrite *currentWrite in batchWrites.allValues) {
+                // A later batch may have taken over the key already
+                if ([self.committingWrites objectForKey:currentWrite.key] == currentWrite) {
+                    [self.committingWrites removeObjectForKey:currentWrite.key];
+                }
+                
+                [didPersistBlocks addObjectsFromArray:currentWrite.didPersistBlocks];
             }
         }
-    }];
-}
-
+        
+        if (!didPersistBlocks.count) {
+            return;
+        }
+        
+        // The save only reaches the main MOC; wait for the group
+        // commit that takes it to disk. Completions run on the main
+        // queue.
+        [self persistChangesWithCompletion:^(NSError *error) {
+            for (BCCPersistentCacheBlock currentBlock in didPersistBlocks) {
+                currentBlock();
+            }
+        }];
+    };
+    
+    [self performWorkWithParameters:workParameters];
+}
+
+- (BCCPersistentCachePendingWrite *)_pendingWriteForKey:(NSString *)inKey;
+{
+    if (!inKey.length) {
+        return nil;
+    }
+    
+    @synchronized (self.pendingWrites) {
+        BCCPersistentCachePendingWrite *pendingWrite = [self.pendingWrites objectForKey:inKey];
+        if (!pendingWrite) {
+            pendingWrite = [self.committingWrites objectForKey:inKey];
+        }
+        
+        return pendingWrite;
+    }
+}
+
+#pragma mark Asynchronous Reads
+
+- (void)cacheDataForKey:(NSString *)inKey completion:(BCCPersistentCacheDataBlock)completion;
+{
+    if (!completion) {
+        return;
+    }
+    
+    NSData *memoryData = inKey.length ? [self _memoryCacheDataForKey:inKey] : nil;
+    if (!inKey.length || memoryData) {
+        if (memoryData) {
+            [self _noteAccessForKey:inKey];
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(memoryData);
+        });
+        
+        return;
+    }
+    
+    // Somebody's already reading this key; their result will do
+    if (![self _addReadCompletion:completion forKey:inKey]) {
+        return;
+    }
+    
+    // Go straight to the file tier; the memory tier was just checked
+    dispatch_async(self.ioQueue, ^{
+        [self _readFileCacheDataForKeys:@[inKey]];
+    });
+}
+
+- (void)cacheDataForKeys:(NSArray *)inKeys completion:(BCCPersistentCacheMultipleDataBlock)completion;
+{
+    if (!completion) {
+        return;
+    }
+    
+    NSMutableDictionary *dataByKey = [[NSMutableDictionary alloc] init];
+    NSMutableArray *keysToRead = [[NSMutableArray alloc] init];
+    dispatch_group_t readGroup = dispatch_group_create();
+    
+    for (NSString *currentKey in [NSOrderedSet orderedSetWithArray:inKeys]) {
+        if (![currentKey isKindOfClass:[NSString class]] || !currentKey.length) {
+            continue;
+        }
+        
+        NSData *memoryData = [self _memoryCacheDataForKey:currentKey];
+        if (memoryData) {
+            [self _noteAccessForKey:currentKey];
+            
+            @synchronized (dataByKey) {
+                [dataByKey setObject:memoryData forKey:currentKey];
+            }
+            
+            continue;
+        }
+        
+        dispatch_group_enter(readGroup);
+        
+        BCCPersistentCacheDataBlock keyCompletion = ^(NSData *data) {
+            if (data) {
+                @synchronized (dataByKey) {
+                    [dataByKey setObject:data forKey:currentKey];
+                }
+            }
+            
+            dispatch_group_leave(readGroup);
+        };
+        
+        // Keys already in flight elsewhere just get waited on
+        if ([self _addReadCompletion:keyCompletion forKey:currentKey]) {
+            [keysToRead addObject:currentKey];
+        }
+    }
+    
+    if (keysToRead.count) {
+        dispatch_async(self.ioQueue, ^{
+            [self _readFileCacheDataForKeys:keysToRead];
+        });
+    }
+    
+    dispatch_group_notify(readGroup, dispatch_get_main_queue(), ^{
+        NSDictionary *result = nil;
+        @synchronized (dataByKey) {
+            result = [dataByKey copy];
+        }
+        
+        completion(result);
+    });
+}
+
+- (void)attributesForKey:(NSString *)inKey completion:(BCCPersistentCacheAttributesBlock)completion;
+{
+    if (!completion) {
+        return;
+    }
+    
+    dispatch_async(self.ioQueue, ^{
+        NSDictionary *attributes = [self attributesForKey:inKey];
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(attributes);
+        });
+    });
+}
+
+- (BOOL)_addReadCompletion:(BCCPersistentCacheDataBlock)inCompletion forKey:(NSString *)inKey;
+{
+    @synchronized (self.pendingReadCompletions) {
+        NSMutableArray *completions = [self.pendingReadCompletions objectForKey:inKey];
+        if (completions) {
+            [completions addObject:[inCompletion copy]];
+            return NO;
+        }
+        
+        [self.pendingReadCompletions setObject:[NSMutableArray arrayWithObject:[inCompletion copy]] forKey:inKey];
+        
+        return YES;
+    }
+}
+
+- (void)_finishReadForKey:(NSString *)inKey data:(NSData *)inData;
+{
+    NSArray *completions = nil;
+    
+    @synchronized (self.pendingReadCompletions) {
+        completions = [self.pendingReadCompletions objectForKey:inKey];
+        [self.pendingReadCompletions removeObjectForKey:inKey];
+    }
+    
+    if (!completions.count) {
+        return;
+    }
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (BCCPersistentCacheDataBlock currentCompletion in completions) {
+            currentCompletion(inData);
+        }
+    });
+}
+
+- (void)_readFileCacheDataForKeys:(NSArray *)inKeys;
+{
+    NSDictionary *indexEntries = [self _indexEntriesForKeys:inKeys];
+    
+    // Standalone files are named by digest; work those out once rather
+    // than on every comparison
+    NSMutableDictionary *fileNamesByKey = [[NSMutableDictionary alloc] initWithCapacity:inKeys.count];
+    for (NSString *currentKey in inKeys) {
+        BCCPersistentCacheIndexEntry *indexEntry = [indexEntries objectForKey:currentKey];
+        if (indexEntry.segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+            [fileNamesByKey setObject:[currentKey BCC_MD5String] forKey:currentKey];
+        }
+    }
+    
+    // Read in on-disk order: segmented entries by segment and offset so
+    // they come off sequentially, then standalone files by name
+    NSArray *orderedKeys = [inKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *firstKey, NSString *secondKey) {
+        BCCPersistentCacheIndexEntry *firstEntry = [indexEntries objectForKey:firstKey];
+        BCCPersistentCacheIndexEntry *secondEntry = [indexEntries objectForKey:secondKey];
+        
+        BOOL firstIsSegmented = firstEntry.segmentIdentifier != BCCPersistentCacheSegmentStoreNoSegment;
+        BOOL secondIsSegmented = secondEntry.segmentIdentifier != BCCPersistentCacheSegmentStoreNoSegment;
+        
+        if (firstIsSegmented != secondIsSegmented) {
+            return firstIsSegmented ? NSOrderedAscending : NSOrderedDescending;
+        }
+        
+        if (firstIsSegmented) {
+            if (firstEntry.segmentIdentifier != secondEntry.segmentIdentifier) {
+                return firstEntry.segmentIdentifier < secondEntry.segmentIdentifier ? NSOrderedAscending : NSOrderedDescending;
+            }
+            
+            if (firstEntry.segmentOffset != secondEntry.segmentOffset) {
+                return firstEntry.segmentOffset < secondEntry.segmentOffset ? NSOrderedAscending : NSOrderedDescending;
+            }
+            
+            return NSOrderedSame;
+        }
+        
+        return [[fileNamesByKey objectForKey:firstKey] compare:[fileNamesByKey objectForKey:secondKey]];
+    }];
+    
+    for (NSString *currentKey in orderedKeys) {
+        @autoreleasepool {
+            BOOL wasMapped = NO;
+            NSData *fileData = nil;
+            
+            BCCPersistentCacheIndexEntry *indexEntry = [indexEntries objectForKey:currentKey];
+            if (indexEntry) {
+                fileData = [self _fileCacheDataForKey:currentKey indexEntry:indexEntry wasMapped:&wasMapped];
+            } else {
+                // Either a definite miss the index can answer, or no index
+                // yet and we have to look on disk
+                fileData = [self _fileCacheDataForKey:currentKey wasMapped:&wasMapped];
+            }
+            
+            [self _recordFileCacheReadOfData:fileData];
+            [self _addFileData:fileData toMemoryCacheForKey:currentKey wasMapped:wasMapped];
+            [self _finishReadForKey:currentKey data:fileData];
+        }
+    }
+}
+
+- (NSDictionary *)_indexEntriesForKeys:(NSArray *)inKeys;
+{
+    NSMutableDictionary *indexEntries = [[NSMutableDictionary alloc] initWithCapacity:inKeys.count];
+    
+    @synchronized (self.cacheIndex) {
+        if (self.cacheIndexLoaded) {
+            for (NSString *currentKey in inKeys) {
+                BCCPersistentCacheIndexEntry *indexEntry = [self.cacheIndex objectForKey:currentKey];
+                if (indexEntry) {
+                    [indexEntries setObject:indexEntry forKey:currentKey];
+                }
+            }
+            
+            return indexEntries;
+        }
+    }
+    
+    // The index isn't ready yet, so look up every location with a single
+    // round trip per batch rather than a fetch per key
+    [self _performLookupAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+        for (NSUInteger batchStart = 0; batchStart < inKeys.count; batchStart += BCCPersistentCacheReadLocationFetchBatchSize) {
+            NSUInteger currentBatchSize = MIN(BCCPersistentCacheReadLocationFetchBatchSize, inKeys.count - batchStart);
+            NSArray *batchKeys = [inKeys subarrayWithRange:NSMakeRange(batchStart, currentBatchSize)];
+            
+            NSFetchRequest *locationFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName usingPropertyList:@[BCCPersistentCacheItemCacheKeyModelKey] valueList:@[batchKeys] sortDescriptors:nil];
+            locationFetchRequest.resultType = NSDictionaryResultType;
+            locationFetchRequest.propertiesToFetch = @[BCCPersistentCacheItemCacheKeyModelKey, BCCPersistentCacheItemFileSizeModelKey, BCCPersistentCacheItemSegmentIdentifierModelKey, BCCPersistentCacheItemSegmentOffsetModelKey];
+            
+            NSArray *results = [self performFetchRequest:locationFetchRequest error:NULL];
+            for (NSDictionary *currentResult in results) {
+                NSString *key = [currentResult objectForKey:BCCPersistentCacheItemCacheKeyModelKey];
+                if (key.length) {
+                    [indexEntries setObject:[BCCPersistentCacheIndexEntry indexEntryForDictionary:currentResult] forKey:key];
+                }
+            }
+        }
+    }];
+    
+    return indexEntries;
+}
+
+- (void)clearCache;
+{
+    [self clearMemoryCache];
+    
+    @synchronized (self.pendingWrites) {
+        [self.pendingWrites removeAllObjects];
+    }
+
+    [self deletePersistentStore];
+    [self _clearFileCache];    
+    [self.segmentStore removeAllSegments];
+    
+    [self _resetFileCacheSize];
+    [self _resetCacheIndex];
+    
+    if (![[NSFileManager defaultManager] fileExistsAtPath:self.fileCachePath]) {
+        [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.fileCachePath];
+    }
+}
+
+- (void)clearMemoryCache
+{
+    [self.memoryCache removeAllObjects];
+    [self.mappedMemoryCache removeAllObjects];
+}
+
+- (BOOL)hasCacheDataForKey:(NSString *)inKey
+{
+    // A queued file that's gone missing will be dropped by the flush. One
+    // that's already been moved into place is found below.
+    BCCPersistentCachePendingWrite *pendingWrite = [self _pendingWriteForKey:inKey];
+    if (pendingWrite.data || (pendingWrite.sourcePath && [[NSFileManager defaultManager] fileExistsAtPath:pendingWrite.sourcePath])) {
+        return YES;
+    }
+    
+    if (inKey.length && [self _memoryCacheDataForKey:inKey recordingMetrics:NO]) {
+        return YES;
+    }
+    
+    BCCPersistentCacheIndexEntry *indexEntry = nil;
+    if ([self _cacheIndexLookupForKey:inKey entry:&indexEntry]) {
+        return indexEntry != nil;
+    }
+    
+    NSString *filePath = [self _fileCachePathForKey:inKey];
+    if ([[NSFileManager defaultManager] fileExistsAtPath:filePath]) {
+        return YES;
+    }
+    
+    if (!inKey.length || !self.segmentStore.hasSegments) {
+        return NO;
+    }
+    
+    __block BOOL storedInSegment = NO;
+    [self _performLookupAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+        storedInSegment = [self cacheItemForKey:inKey].storedInSegment;
+    }];
+    
+    return storedInSegment;
+}
+
+#pragma mark Private Methods
+
+- (NSData *)_memoryCacheDataForKey:(NSString *)inKey;
+{
+    return [self _memoryCacheDataForKey:inKey recordingMetrics:YES];
+}
+
+- (NSData *)_memoryCacheDataForKey:(NSString *)inKey recordingMetrics:(BOOL)inRecordsMetrics;
+{
+    if (!self.usesMemoryCache) {
+        return nil;
+    }
+    
+    NSData *memoryData = [self.memoryCache objectForKey:inKey];
+    NSString *metricName = BCCPersistentCacheMetricMemoryHits;
+    
+    if (!memoryData) {
+        memoryData = [self.mappedMemoryCache objectForKey:inKey];
+        metricName = memoryData ? BCCPersistentCacheMetricMappedMemoryHits : BCCPersistentCacheMetricMemoryMisses;
+    }
+    
+    // Existence checks aren't reads, so they stay out of the hit rates
+    if (inRecordsMetrics) {
+        [self.metricsRecorder incrementCounter:metricName dimension:nil by:1];
+    }
+    
+    return memoryData;
+}
+
+- (void)_recordFileCacheReadOfData:(NSData *)inData;
+{
+    id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+    if (!metricsRecorder) {
+        return;
+    }
+    
+    if (!inData) {
+        [metricsRecorder incrementCounter:BCCPersistentCacheMetricFileMisses dimension:nil by:1];
+        return;
+    }
+    
+    [metricsRecorder incrementCounter:BCCPersistentCacheMetricFileHits dimension:nil by:1];
+    [metricsRecorder incrementCounter:BCCPersistentCacheMetricBytesRead dimension:nil by:inData.length];
+}
+
+- (NSData *)_contentsOfFileAtPath:(NSString *)inPath fileSize:(unsigned long long)inFileSize wasMapped:(BOOL *)outWasMapped;
+{
+    NSDataReadingOptions readingOptions = 0;
+    
+    if (self.mappedReadThreshold > 0) {
+        // Callers that know the size (from the index) save us the stat
+        unsigned long long fileSize = inFileSize;
+        if (!fileSize) {
+            struct stat fileStat;
+            if (stat([inPath fileSystemRepresentation], &fileStat) != 0) {
+                return nil;
+            }
+            
+            fileSize = (unsigned long long)fileStat.st_size;
+        }
+        
+        if (fileSize >= self.mappedReadThreshold) {
+            readingOptions = NSDataReadingMappedAlways;
+        }
+    }
+    
+    NSData *fileData = [NSData dataWithContentsOfFile:inPath options:readingOptions error:NULL];
+    
+    if (outWasMapped) {
+        *outWasMapped = fileData && (readingOptions & NSDataReadingMappedAlways);
+    }
+    
+    return fileData;
+}
+
+- (void)_updateFileCachePath;
+{
+    self.fileCachePath = [self.rootDirectory stringByAppendingPathComponent:BCCPersistentCacheFileCacheSubdirectoryName];
+}
+
+- (NSString *)_fileCachePathForName:(NSString *)inFileName;
+{
+    if (!inFileName.length || !self.fileCachePath.length) {
+        return nil;
+    }
+    
+    return [self.fileCachePath stringByAppendingPathComponent:inFileName];
+}
+
+- (NSString *)_fileCachePathForKey:(NSString *)inKey;
+{
+    if (!inKey.length || !self.fileCachePath.length) {
+        return nil;
+    }
+    
+    return [self.fileCachePath stringByAppendingPathComponent:[inKey BCC_MD5String]];
+}
+
+- (void)_clearFileCache;
+{
+    [[NSFileManager defaultManager] removeItemAtPath:self.fileCachePath error:NULL];
+}
+
+- (void)_clearCacheItemsToFitMaxFileCacheSize;
+{
+    NSUInteger cacheSize = self.totalFileCacheSize;
+    if (cacheSize <= self.maximumFileCacheSize) {
+        return;
+    }
+    
+    NSUInteger spaceToClear = cacheSize - self.maximumFileCacheSize;
+    [self _clearCacheItemsOfSize:spaceToClear];
+}
+
+- (void)_clearCacheItemsOfSize:(unsigned long long)inSize;
+{
+    if (!inSize) {
+        return;
+    }
+    
+    id <BCCDataStoreControllerMetricsRecorder> metricsRecorder = self.metricsRecorder;
+    CFAbsoluteTime evictionStartTime = metricsRecorder ? CFAbsoluteTimeGetCurrent() : 0.0;
+    
+    // Reads that haven't been flushed to the store yet still count as
+    // recent, so don't let their stale timestamps make them victims
+    NSSet *recentlyAccessedKeys = nil;
+    @synchronized (self.pendingAccessTimestamps) {
+        recentlyAccessedKeys = [NSSet setWithArray:self.pendingAccessTimestamps.allKeys];
+    }
+    
+    NSUInteger batchSize = self.evictionBatchSize ? self.evictionBatchSize : BCCPersistentCacheDefaultEvictionBatchSize;
+    
+    // Least recently used first. Items that predate access tracking have
+    // no timestamp and sort ahead of everything else.
+    NSArray *sortDescriptors = @[[NSSortDescriptor sortDescriptorWithKey:BCCPersistentCacheItemLastAccessedTimestampModelKey ascending:YES], [NSSortDescriptor sortDescriptorWithKey:BCCPersistentCacheItemAddedTimestampModelKey ascending:YES], [NSSortDescriptor sortDescriptorWithKey:BCCPersistentCacheItemCacheKeyModelKey ascending:YES]];
+    
+    unsigned long long totalCleared = 0;
+    NSPredicate *cursorPredicate = nil;
+    
+    while (totalCleared < inSize) {
+        @autoreleasepool {
+            // Page by the sort keys of the last item looked at rather than
+            // an offset, which rows deleted or touched between pages would
+            // shift
+            NSFetchRequest *cacheItemFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName sortDescriptors:sortDescriptors];
+            cacheItemFetchRequest.predicate = cursorPredicate;
+            cacheItemFetchRequest.fetchLimit = batchSize;
+            cacheItemFetchRequest.returnsObjectsAsFaults = NO;
+            
+            NSArray *cacheItems = [self performFetchRequest:cacheItemFetchRequest error:NULL];
+            if (cacheItems.count < 1) {
+                break;
+            }
+            
+            cursorPredicate = [self _evictionCursorPredicateAfterItem:cacheItems.lastObject];
+            
+            for (BCCPersistentCacheItem *currentItem in cacheItems) {
+                if ([recentlyAccessedKeys containsObject:currentItem.key]) {
+                    continue;
+                }
+                
+                totalCleared += currentItem.fileSize;
+                
+                [self removeCacheItem:currentItem];
+                
+                if (totalCleared >= inSize) {
+                    break;
+                }
+            }
+            
+            // Commit each batch so deleted rows drop out of the next fetch
+            // and the context doesn't accumulate the whole eviction set
+            [self saveCurrentMOC];
+        }
+    }
+    
+    if (metricsRecorder) {
+        [metricsRecorder incrementCounter:BCCPersistentCacheMetricEvictionRuns dimension:nil by:1];
+        [metricsRecorder incrementCounter:BCCPersistentCacheMetricBytesEvicted dimension:nil by:totalCleared];
+        [metricsRecorder recordDuration:(CFAbsoluteTimeGetCurrent() - evictionStartTime) forHistogram:BCCPersistentCacheMetricEvictionDuration dimension:nil];
+    }
+}
+
+- (NSPredicate *)_evictionCursorPredicateAfterItem:(BCCPersistentCacheItem *)inItem;
+{
+    // Everything after the item in last accessed, added, key order
+    NSPredicate *cursorPredicate = [NSPredicate predicateWithFormat:@"%K > %@", BCCPersistentCacheItemCacheKeyModelKey, inItem.key];
+    cursorPredicate = [self _evictionCursorPredicateForDateKey:BCCPersistentCacheItemAddedTimestampModelKey date:inItem.addedTimestamp tieBreakPredicate:cursorPredicate];
+    cursorPredicate = [self _evictionCursorPredicateForDateKey:BCCPersistentCacheItemLastAccessedTimestampModelKey date:inItem.lastAccessedTimestamp tieBreakPredicate:cursorPredicate];
+    
+    return cursorPredicate;
+}
+
+- (NSPredicate *)_evictionCursorPredicateForDateKey:(NSString *)inDateKey date:(NSDate *)inDate tieBreakPredicate:(NSPredicate *)inTieBreakPredicate;
+{
+    // Nil dates sort first, so everything with a date comes after one
+    NSPredicate *laterPredicate = nil;
+    NSPredicate *equalPredicate = nil;
+    
+    if (inDate) {
+        laterPredicate = [NSPredicate predicateWithFormat:@"%K > %@", inDateKey, inDate];
+        equalPredicate = [NSPredicate predicateWithFormat:@"%K == %@", inDateKey, inDate];
+    } else {
+        laterPredicate = [NSPredicate predicateWithFormat:@"%K != nil", inDateKey];
+        equalPredicate = [NSPredicate predicateWithFormat:@"%K == nil", inDateKey];
+    }
+    
+    NSPredicate *tiePredicate = [NSCompoundPredicate andPredicateWithSubpredicates:@[equalPredicate, inTieBreakPredicate]];
+    
+    return [NSCompoundPredicate orPredicateWithSubpredicates:@[laterPredicate, tiePredicate]];
+}
+
 - (void)_sendCacheItemUpdatedNotificationForItem:(BCCPersistentCacheItem *)updatedItem data:(NSData *)inData;
 {
     //dispatch_async(self.workerQueue, ^{   
@@ -539,6 +1550,452 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     //});
 }
 
+#pragma mark Segmented Storage
+
+- (BOOL)prepareToCommitChanges:(NSError **)outError;
+{
+    // Rows about to be committed may point at segment records that are
+    // still only in the page cache
+    if (![self.segmentStore synchronize]) {
+        if (outError) {
+            *outError = [NSError errorWithDomain:BCCDataStoreControllerErrorDomain code:BCCDataStoreControllerErrorCommitDeferred userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Unable to synchronize cache segments", @"")}];
+        }
+        
+        return NO;
+    }
+    
+    return YES;
+}
+
+- (void)_loadSegmentStatistics;
+{
+    if (!self.segmentStore.hasSegments) {
+        return;
+    }
+    
+    // Live bytes per segment are the payloads the metadata still points
+    // at plus a record header for each of them
+    NSMutableDictionary *liveByteCounts = [[NSMutableDictionary alloc] init];
+    NSUInteger recordHeaderSize = [BCCPersistentCacheSegmentStore recordSizeForDataLength:0];
+    
+    [self performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        NSExpressionDescription *sizeDescription = [[NSExpressionDescription alloc] init];
+        sizeDescription.name = BCCPersistentCacheItemFileSizeModelKey;
+        sizeDescription.expression = [NSExpression expressionForFunction:@"sum:" arguments:@[[NSExpression expressionForKeyPath:BCCPersistentCacheItemFileSizeModelKey]]];
+        sizeDescription.expressionResultType = NSInteger64AttributeType;
+        
+        NSExpressionDescription *countDescription = [[NSExpressionDescription alloc] init];
+        countDescription.name = BCCPersistentCacheItemCacheKeyModelKey;
+        countDescription.expression = [NSExpression expressionForFunction:@"count:" arguments:@[[NSExpression expressionForKeyPath:BCCPersistentCacheItemCacheKeyModelKey]]];
+        countDescription.expressionResultType = NSInteger64AttributeType;
+        
+        NSFetchRequest *segmentFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName sortDescriptors:nil];
+        segmentFetchRequest.predicate = [NSPredicate predicateWithFormat:@"%K > 0", BCCPersistentCacheItemSegmentIdentifierModelKey];
+        segmentFetchRequest.resultType = NSDictionaryResultType;
+        segmentFetchRequest.propertiesToFetch = @[BCCPersistentCacheItemSegmentIdentifierModelKey, sizeDescription, countDescription];
+        segmentFetchRequest.propertiesToGroupBy = @[BCCPersistentCacheItemSegmentIdentifierModelKey];
+        
+        NSArray *results = [self performFetchRequest:segmentFetchRequest error:NULL];
+        for (NSDictionary *currentResult in results) {
+            NSNumber *segmentIdentifier = [currentResult objectForKey:BCCPersistentCacheItemSegmentIdentifierModelKey];
+            unsigned long long payloadBytes = [[currentResult objectForKey:BCCPersistentCacheItemFileSizeModelKey] unsignedLongLongValue];
+            unsigned long long recordCount = [[currentResult objectForKey:BCCPersistentCacheItemCacheKeyModelKey] unsignedLongLongValue];
+            
+            [liveByteCounts setObject:@(payloadBytes + (recordCount * recordHeaderSize)) forKey:@(segmentIdentifier.unsignedIntegerValue)];
+        }
+    }];
+    
+    [self.segmentStore resetLiveByteCounts:liveByteCounts];
+}
+
+- (BOOL)_appendData:(NSData *)inData toSegmentForItem:(BCCPersistentCacheItem *)inItem;
+{
+    NSString *key = inItem.key.length ? inItem.key : nil;
+    if (!key) {
+        return NO;
+    }
+    
+    NSUInteger segmentIdentifier = BCCPersistentCacheSegmentStoreNoSegment;
+    NSUInteger segmentOffset = 0;
+    if (![self.segmentStore appendData:inData forKey:key segmentIdentifier:&segmentIdentifier offset:&segmentOffset]) {
+        return NO;
+    }
+    
+    // Whatever the item pointed at before is dead now
+    [self _releaseFileCacheStorageForItem:inItem];
+    
+    inItem.segmentIdentifier = segmentIdentifier;
+    inItem.segmentOffset = segmentOffset;
+    
+    return YES;
+}
+
+- (void)_releaseFileCacheStorageForItem:(BCCPersistentCacheItem *)inItem;
+{
+    if (inItem.storedInSegment) {
+        [self.segmentStore releaseRecordOfLength:inItem.fileSize fromSegmentIdentifier:inItem.segmentIdentifier];
+        
+        inItem.segmentIdentifier = BCCPersistentCacheSegmentStoreNoSegment;
+        inItem.segmentOffset = 0;
+    } else if (inItem.fileSize > 0) {
+        NSString *filePath = [self _fileCachePathForKey:inItem.key];
+        [[NSFileManager defaultManager] removeItemAtPath:filePath error:NULL];
+    }
+}
+
+- (NSData *)_segmentedFileCacheDataForKey:(NSString *)inKey;
+{
+    __block NSUInteger segmentIdentifier = BCCPersistentCacheSegmentStoreNoSegment;
+    __block NSUInteger segmentOffset = 0;
+    __block NSUInteger length = 0;
+    
+    BCCPersistentCacheIndexEntry *indexEntry = nil;
+    if ([self _cacheIndexLookupForKey:inKey entry:&indexEntry]) {
+        if (indexEntry.segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+            return nil;
+        }
+        
+        return [self.segmentStore dataForKey:inKey segmentIdentifier:indexEntry.segmentIdentifier offset:indexEntry.segmentOffset length:indexEntry.fileSize];
+    }
+    
+    [self _performLookupAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+        BCCPersistentCacheItem *item = [self cacheItemForKey:inKey];
+        if (!item.storedInSegment) {
+            return;
+        }
+        
+        segmentIdentifier = item.segmentIdentifier;
+        segmentOffset = item.segmentOffset;
+        length = item.fileSize;
+    }];
+    
+    if (segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+        return nil;
+    }
+    
+    // If compaction moved the record after we looked it up this comes back
+    // nil, which callers already treat as a miss
+    return [self.segmentStore dataForKey:inKey segmentIdentifier:segmentIdentifier offset:segmentOffset length:length];
+}
+
+- (void)_compactSegmentsIfNeeded;
+{
+    NSArray *segmentIdentifiers = [self.segmentStore segmentIdentifiersNeedingCompaction];
+    if (segmentIdentifiers.count < 1) {
+        return;
+    }
+    
+    NSMutableArray *compactedSegmentIdentifiers = [[NSMutableArray alloc] init];
+    
+    for (NSNumber *currentSegmentIdentifier in segmentIdentifiers) {
+        @autoreleasepool {
+            NSUInteger segmentIdentifier = currentSegmentIdentifier.unsignedIntegerValue;
+            BOOL movedAllItems = YES;
+            
+            NSArray *cacheItems = [self performFetchOfEntityWithName:BCCPersistentCacheItemEntityName usingPropertyList:@[BCCPersistentCacheItemSegmentIdentifierModelKey] valueList:@[currentSegmentIdentifier] sortDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:BCCPersistentCacheItemSegmentOffsetModelKey ascending:YES]] error:NULL];
+            
+            // Copy the survivors forward into the active segment
+            for (BCCPersistentCacheItem *currentItem in cacheItems) {
+                NSData *itemData = [self.segmentStore dataForKey:currentItem.key segmentIdentifier:segmentIdentifier offset:currentItem.segmentOffset length:currentItem.fileSize];
+                if (!itemData) {
+                    [self removeCacheItem:currentItem];
+                    continue;
+                }
+                
+                if (![self _appendData:itemData toSegmentForItem:currentItem]) {
+                    movedAllItems = NO;
+                    break;
+                }
+                
+                [self _updateCacheIndexForItem:currentItem];
+            }
+            
+            if (movedAllItems) {
+                [compactedSegmentIdentifiers addObject:currentSegmentIdentifier];
+            }
+        }
+    }
+    
+    [self saveCurrentMOC];
+    
+    if (compactedSegmentIdentifiers.count < 1) {
+        return;
+    }
+    
+    // The old segments can only go once nothing on disk points at them.
+    // Waiting for the commit here would hold up the background MOC, and
+    // with it any lookup from the main thread, behind disk I/O, so they
+    // go once it lands. If it fails they stay for the next pass.
+    [self persistChangesWithCompletion:^(NSError *error) {
+        if (error) {
+            NSLog(@"Unable to persist compacted cache index: %@", error);
+            return;
+        }
+        
+        dispatch_async(self.ioQueue, ^{
+            for (NSNumber *currentSegmentIdentifier in compactedSegmentIdentifiers) {
+                [self.segmentStore removeSegmentWithIdentifier:currentSegmentIdentifier.unsignedIntegerValue];
+            }
+        });
+    }];
+}
+
+#pragma mark Key Index
+
+- (void)_loadCacheIndex;
+{
+    NSUInteger loadGeneration = 0;
+    @synchronized (self.cacheIndex) {
+        loadGeneration = self.cacheIndexGeneration;
+    }
+    
+    // Everything but the attributes, straight out of SQLite without
+    // materializing managed objects
+    [self performBlockOnBackgroundMOC:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        NSFetchRequest *indexFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName sortDescriptors:nil];
+        indexFetchRequest.resultType = NSDictionaryResultType;
+        indexFetchRequest.propertiesToFetch = @[BCCPersistentCacheItemCacheKeyModelKey, BCCPersistentCacheItemFileSizeModelKey, BCCPersistentCacheItemSegmentIdentifierModelKey, BCCPersistentCacheItemSegmentOffsetModelKey, BCCPersistentCacheItemAddedTimestampModelKey, BCCPersistentCacheItemUpdatedTimestampModelKey];
+        
+        NSError *error = nil;
+        NSArray *results = [self performFetchRequest:indexFetchRequest error:&error];
+        if (!results) {
+            NSLog(@"Unable to load persistent cache index: %@", error);
+            return;
+        }
+        
+        NSMutableDictionary *loadedIndex = [[NSMutableDictionary alloc] initWithCapacity:results.count];
+        for (NSDictionary *currentResult in results) {
+            NSString *key = [currentResult objectForKey:BCCPersistentCacheItemCacheKeyModelKey];
+            if (!key.length) {
+                continue;
+            }
+            
+            [loadedIndex setObject:[BCCPersistentCacheIndexEntry indexEntryForDictionary:currentResult] forKey:key];
+        }
+        
+        @synchronized (self.cacheIndex) {
+            // The cache was cleared while we were loading
+            if (self.cacheIndexGeneration != loadGeneration) {
+                return;
+            }
+            
+            // Anything set or removed since startup is newer than what we
+            // just read, so it wins
+            [loadedIndex enumerateKeysAndObjectsUsingBlock:^(NSString *key, BCCPersistentCacheIndexEntry *indexEntry, BOOL *stop) {
+                if ([self.cacheIndex objectForKey:key] || [self.keysRemovedDuringIndexLoad containsObject:key]) {
+                    return;
+                }
+                
+                [self.cacheIndex setObject:indexEntry forKey:key];
+            }];
+            
+            self.keysRemovedDuringIndexLoad = nil;
+            self.cacheIndexLoaded = YES;
+        }
+    }];
+}
+
+- (BOOL)_cacheIndexLookupForKey:(NSString *)inKey entry:(BCCPersistentCacheIndexEntry **)outEntry;
+{
+    if (!inKey.length) {
+        return NO;
+    }
+    
+    @synchronized (self.cacheIndex) {
+        if (!self.cacheIndexLoaded) {
+            return NO;
+        }
+        
+        if (outEntry) {
+            *outEntry = [self.cacheIndex objectForKey:inKey];
+        }
+    }
+    
+    return YES;
+}
+
+- (void)_updateCacheIndexForItem:(BCCPersistentCacheItem *)inItem;
+{
+    NSString *key = inItem.key;
+    if (!key.length) {
+        return;
+    }
+    
+    BCCPersistentCacheIndexEntry *indexEntry = [BCCPersistentCacheIndexEntry indexEntryForCacheItem:inItem];
+    
+    @synchronized (self.cacheIndex) {
+        [self.cacheIndex setObject:indexEntry forKey:key];
+        [self.keysRemovedDuringIndexLoad removeObject:key];
+    }
+}
+
+- (void)_removeCacheIndexEntryForKey:(NSString *)inKey;
+{
+    if (!inKey.length) {
+        return;
+    }
+    
+    @synchronized (self.cacheIndex) {
+        [self.cacheIndex removeObjectForKey:inKey];
+        [self.keysRemovedDuringIndexLoad addObject:inKey];
+    }
+}
+
+- (void)_resetCacheIndex;
+{
+    // The store is gone, so an empty index is the whole truth
+    @synchronized (self.cacheIndex) {
+        [self.cacheIndex removeAllObjects];
+        
+        self.cacheIndexGeneration++;
+        self.keysRemovedDuringIndexLoad = nil;
+        self.cacheIndexLoaded = YES;
+    }
+}
+
+#pragma mark Size Accounting
+
+- (void)_loadFileCacheSize;
+{
+    NSNumber *storedSize = [self persistentStoreMetadataValueForKey:BCCPersistentCacheTotalFileSizeMetadataKey];
+    if (storedSize) {
+        @synchronized (self) {
+            _fileCacheSize = [storedSize unsignedLongLongValue];
+        }
+        
+        return;
+    }
+    
+    // Stores written before the running counter existed get totalled once
+    // with an aggregate query; from then on the counter is maintained.
+    __block unsigned long long totalSize = 0;
+    
+    [self performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        NSExpressionDescription *sizeDescription = [[NSExpressionDescription alloc] init];
+        sizeDescription.name = BCCPersistentCacheItemFileSizeModelKey;
+        sizeDescription.expression = [NSExpression expressionForFunction:@"sum:" arguments:@[[NSExpression expressionForKeyPath:BCCPersistentCacheItemFileSizeModelKey]]];
+        sizeDescription.expressionResultType = NSInteger64AttributeType;
+        
+        NSFetchRequest *sizeFetchRequest = [self fetchRequestForEntityName:BCCPersistentCacheItemEntityName sortDescriptors:nil];
+        sizeFetchRequest.resultType = NSDictionaryResultType;
+        sizeFetchRequest.propertiesToFetch = @[sizeDescription];
+        
+        NSDictionary *result = [[self performFetchRequest:sizeFetchRequest error:NULL] firstObject];
+        totalSize = [[result objectForKey:BCCPersistentCacheItemFileSizeModelKey] unsignedLongLongValue];
+    }];
+    
+    @synchronized (self) {
+        _fileCacheSize = totalSize;
+    }
+    
+    [self setPersistentStoreMetadataValue:@(totalSize) forKey:BCCPersistentCacheTotalFileSizeMetadataKey];
+}
+
+- (void)_adjustFileCacheSizeBy:(long long)inDelta;
+{
+    if (!inDelta) {
+        return;
+    }
+    
+    unsigned long long updatedSize = 0;
+    
+    @synchronized (self) {
+        if (inDelta < 0 && (unsigned long long)(-inDelta) > _fileCacheSize) {
+            _fileCacheSize = 0;
+        } else {
+            _fileCacheSize += inDelta;
+        }
+        
+        updatedSize = _fileCacheSize;
+    }
+    
+    // Goes out to disk in the same transaction as the item changes
+    [self setPersistentStoreMetadataValue:@(updatedSize) forKey:BCCPersistentCacheTotalFileSizeMetadataKey];
+}
+
+- (void)_resetFileCacheSize;
+{
+    @synchronized (self) {
+        _fileCacheSize = 0;
+    }
+    
+    @synchronized (self.pendingAccessTimestamps) {
+        [self.pendingAccessTimestamps removeAllObjects];
+    }
+    
+    [self setPersistentStoreMetadataValue:@(0) forKey:BCCPersistentCacheTotalFileSizeMetadataKey];
+}
+
+#pragma mark Access Tracking
+
+- (void)_noteAccessForKey:(NSString *)inKey;
+{
+    if (!inKey.length) {
+        return;
+    }
+    
+    BOOL shouldFlush = NO;
+    BOOL shouldScheduleFlush = NO;
+    
+    @synchronized (self.pendingAccessTimestamps) {
+        [self.pendingAccessTimestamps setObject:[NSDate date] forKey:inKey];
+        
+        if (self.pendingAccessTimestamps.count >= BCCPersistentCacheAccessFlushThreshold) {
+            shouldFlush = YES;
+        } else if (!self.accessFlushScheduled) {
+            self.accessFlushScheduled = YES;
+            shouldScheduleFlush = YES;
+        }
+    }
+    
+    if (shouldFlush) {
+        [self _flushPendingAccessTimestamps];
+    } else if (shouldScheduleFlush) {
+        dispatch_time_t flushTime = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(BCCPersistentCacheAccessFlushDelay * NSEC_PER_SEC));
+        dispatch_after(flushTime, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
+            [self _flushPendingAccessTimestamps];
+        });
+    }
+}
+
+- (void)_flushPendingAccessTimestamps;
+{
+    NSDictionary *accessTimestamps = nil;
+    
+    @synchronized (self.pendingAccessTimestamps) {
+        accessTimestamps = [self.pendingAccessTimestamps copy];
+        [self.pendingAccessTimestamps removeAllObjects];
+        self.accessFlushScheduled = NO;
+    }
+    
+    if (accessTimestamps.count < 1) {
+        return;
+    }
+    
+    // One background save for the whole set of reads
+    [self performBlockOnBackgroundMOC:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *context, BCCDataStoreControllerWorkParameters *workParameters) {
+        NSArray *keys = accessTimestamps.allKeys;
+        
+        for (NSUInteger batchStart = 0; batchStart < keys.count; batchStart += BCCPersistentCacheAccessFlushFetchBatchSize) {
+            NSUInteger currentBatchSize = MIN(BCCPersistentCacheAccessFlushFetchBatchSize, keys.count - batchStart);
+            NSArray *batchKeys = [keys subarrayWithRange:NSMakeRange(batchStart, currentBatchSize)];
+            
+            NSArray *cacheItems = [self performFetchOfEntityWithName:BCCPersistentCacheItemEntityName usingPropertyList:@[BCCPersistentCacheItemCacheKeyModelKey] valueList:@[batchKeys] sortDescriptors:nil error:NULL];
+            
+            for (BCCPersistentCacheItem *currentItem in cacheItems) {
+                NSDate *accessTimestamp = [accessTimestamps objectForKey:currentItem.key];
+                if (!accessTimestamp) {
+                    continue;
+                }
+                
+                if (!currentItem.lastAccessedTimestamp || [currentItem.lastAccessedTimestamp compare:accessTimestamp] == NSOrderedAscending) {
+                    currentItem.lastAccessedTimestamp = accessTimestamp;
+                }
+            }
+        }
+    }];
+}
+
 #pragma mark Private Core Data Methods
 
 - (BCCPersistentCacheItem *)_findOrCreateCacheItemForKey:(NSString *)inKey;
@@ -549,6 +2006,17 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     return item;
 }
 
+- (void)_performLookupAndWait:(BCCDataStoreControllerWorkBlock)inBlock;
+{
+    // Read-only, so stay off the main queue and skip the save
+    BCCDataStoreControllerWorkParameters *workParameters = [[BCCDataStoreControllerWorkParameters alloc] init];
+    workParameters.workExecutionStyle = BCCDataStoreControllerWorkExecutionStyleBackgroundMOCAndWait;
+    workParameters.shouldSave = NO;
+    workParameters.workBlock = inBlock;
+    
+    [self performWorkWithParameters:workParameters];
+}
+
 @end
 
 
@@ -558,8 +2026,11 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
 @dynamic fileSize;
 @dynamic addedTimestamp;
 @dynamic updatedTimestamp;
+@dynamic lastAccessedTimestamp;
 @dynamic attributes;
 @dynamic fileName;
+@dynamic segmentIdentifier;
+@dynamic segmentOffset;
 
 #pragma mark Public Methods
 
@@ -577,6 +2048,7 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     }
     
     self.updatedTimestamp = [NSDate date];
+    self.lastAccessedTimestamp = self.updatedTimestamp;
     self.attributes = attributes;
 }
 
@@ -612,5 +2084,83 @@ const unsigned long long STPersistentCacheDefaultMaximumFileCacheSize = 20971520
     return [self BCC_unsignedIntegerForKey:BCCPersistentCacheItemFileSizeModelKey];
 }
 
+- (void)setSegmentIdentifier:(NSUInteger)inSegmentIdentifier;
+{
+    [self BCC_setUnsignedInteger:inSegmentIdentifier forKey:BCCPersistentCacheItemSegmentIdentifierModelKey];
+}
+
+- (NSUInteger)segmentIdentifier;
+{
+    return [self BCC_unsignedIntegerForKey:BCCPersistentCacheItemSegmentIdentifierModelKey];
+}
+
+- (void)setSegmentOffset:(NSUInteger)inSegmentOffset;
+{
+    [self BCC_setUnsignedInteger:inSegmentOffset forKey:BCCPersistentCacheItemSegmentOffsetModelKey];
+}
+
+- (NSUInteger)segmentOffset;
+{
+    return [self BCC_unsignedIntegerForKey:BCCPersistentCacheItemSegmentOffsetModelKey];
+}
+
+- (BOOL)isStoredInSegment;
+{
+    return self.segmentIdentifier != BCCPersistentCacheSegmentStoreNoSegment;
+}
+
+@end
+
+
+@implementation BCCPersistentCachePendingWrite
+
+#pragma mark Initialization
+
+- (id)init;
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _didPersistBlocks = [[NSMutableArray alloc] init];
+    
+    return self;
+}
+
 @end
 
+
+@implementation BCCPersistentCacheIndexEntry
+
+#pragma mark Class Methods
+
++ (BCCPersistentCacheIndexEntry *)indexEntryForCacheItem:(BCCPersistentCacheItem *)inItem;
+{
+    BCCPersistentCacheIndexEntry *indexEntry = [[BCCPersistentCacheIndexEntry alloc] init];
+    indexEntry.fileSize = inItem.fileSize;
+    indexEntry.segmentIdentifier = inItem.segmentIdentifier;
+    indexEntry.segmentOffset = inItem.segmentOffset;
+    indexEntry.addedTimestamp = inItem.addedTimestamp;
+    indexEntry.updatedTimestamp = inItem.updatedTimestamp;
+    
+    // We have the attributes in hand, so there's no reason to fault them
+    // back in later
+    indexEntry.attributes = inItem.attributes;
+    indexEntry.attributesLoaded = YES;
+    
+    return indexEntry;
+}
+
++ (BCCPersistentCacheIndexEntry *)indexEntryForDictionary:(NSDictionary *)inDictionary;
+{
+    BCCPersistentCacheIndexEntry *indexEntry = [[BCCPersistentCacheIndexEntry alloc] init];
+    indexEntry.fileSize = [[inDictionary objectForKey:BCCPersistentCacheItemFileSizeModelKey] unsignedIntegerValue];
+    indexEntry.segmentIdentifier = [[inDictionary objectForKey:BCCPersistentCacheItemSegmentIdentifierModelKey] unsignedIntegerValue];
+    indexEntry.segmentOffset = [[inDictionary objectForKey:BCCPersistentCacheItemSegmentOffsetModelKey] unsignedIntegerValue];
+    indexEntry.addedTimestamp = [inDictionary objectForKey:BCCPersistentCacheItemAddedTimestampModelKey];
+    indexEntry.updatedTimestamp = [inDictionary objectForKey:BCCPersistentCacheItemUpdatedTimestampModelKey];
+    
+    return indexEntry;
+}
+
+@end
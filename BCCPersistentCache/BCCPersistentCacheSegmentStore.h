@@ -0,0 +1,56 @@
+//
+//  BCCPersistentCacheSegmentStore.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+extern const unsigned long long BCCPersistentCacheSegmentStoreDefaultMaximumSegmentFileSize;
+extern const double BCCPersistentCacheSegmentStoreDefaultCompactionThreshold;
+
+// Segment identifier 0 is never used, so callers can use it to mean
+// "not stored in a segment".
+extern const NSUInteger BCCPersistentCacheSegmentStoreNoSegment;
+
+
+// Append-only store for small cache entries. Records are packed into
+// numbered segment files; the caller keeps (segment, offset, length) for
+// each record and reports when records die so that sparse segments can be
+// compacted.
+@interface BCCPersistentCacheSegmentStore : NSObject
+
+@property (strong, nonatomic, readonly) NSString *directoryPath;
+@property (nonatomic) unsigned long long maximumSegmentFileSize;
+
+// Fraction of a sealed segment that must be dead before it's compacted
+@property (nonatomic) double compactionThreshold;
+
+@property (nonatomic, readonly) NSUInteger activeSegmentIdentifier;
+@property (nonatomic, readonly) BOOL hasSegments;
+
+// Initialization
+- (id)initWithDirectoryPath:(NSString *)directoryPath;
+
+// Records
++ (NSUInteger)recordSizeForDataLength:(NSUInteger)length;
+
+- (BOOL)appendData:(NSData *)data forKey:(NSString *)key segmentIdentifier:(NSUInteger *)outSegmentIdentifier offset:(NSUInteger *)outOffset;
+- (NSData *)dataForKey:(NSString *)key segmentIdentifier:(NSUInteger)segmentIdentifier offset:(NSUInteger)offset length:(NSUInteger)length;
+
+// Appends aren't durable until this returns YES, so call it before
+// recording a location anywhere that outlives a crash
+- (BOOL)synchronize;
+
+// Live Byte Accounting
+- (void)resetLiveByteCounts:(NSDictionary *)liveByteCountsBySegmentIdentifier;
+- (void)releaseRecordOfLength:(NSUInteger)length fromSegmentIdentifier:(NSUInteger)segmentIdentifier;
+
+// Compaction
+- (NSArray *)segmentIdentifiersNeedingCompaction;
+- (void)removeSegmentWithIdentifier:(NSUInteger)segmentIdentifier;
+- (void)removeAllSegments;
+
+@end
@@ -0,0 +1,655 @@
+//
+//  BCCPersistentCacheSegmentStore.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCPersistentCacheSegmentStore.h"
+
+// The segment store only needs Foundation, so it can also be built
+// without BCCKit (e.g. GNUstep on Linux)
+#if __has_include("NSFileManager+BCCAdditions.h")
+#import "NSFileManager+BCCAdditions.h"
+#define BCCPersistentCacheSegmentStoreHasBCCKit 1
+#endif
+
+#import <pthread.h>
+#import <sys/stat.h>
+#import <sys/uio.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+
+// Constants
+NSString *BCCPersistentCacheSegmentFileExtension = @"segment";
+
+const unsigned long long BCCPersistentCacheSegmentStoreDefaultMaximumSegmentFileSize = 4194304;
+const double BCCPersistentCacheSegmentStoreDefaultCompactionThreshold = 0.5;
+const NSUInteger BCCPersistentCacheSegmentStoreNoSegment = 0;
+
+// Bumped when the record format changes; recovery truncates a segment at
+// the first record without it
+static const uint32_t BCCPersistentCacheSegmentRecordMagic = 0x42434332; // 'BCC2'
+
+// Idle read descriptors kept open between reads
+static const NSUInteger BCCPersistentCacheSegmentStoreMaximumReadDescriptors = 16;
+
+// 128-bit hash of the key
+#define BCCPersistentCacheSegmentKeyDigestLength 16
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t length;
+    uint32_t checksum;
+    uint8_t keyDigest[BCCPersistentCacheSegmentKeyDigestLength];
+} BCCPersistentCacheSegmentRecordHeader;
+
+
+static uint32_t BCCPersistentCacheSegmentChecksum(const void *bytes, size_t length)
+{
+    // FNV-1a; only needs to catch torn or stale writes, not adversaries
+    const uint8_t *currentByte = bytes;
+    uint32_t hash = 2166136261u;
+    
+    for (size_t i = 0; i < length; i++) {
+        hash ^= currentByte[i];
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
+static void BCCPersistentCacheSegmentKeyDigest(NSString *key, uint8_t *outDigest)
+{
+    // Two FNV-1a 64-bit hashes, one over the key forwards and one backwards
+    // from a different basis. Like the checksum, it only has to tell keys
+    // apart, not stand up to adversaries.
+    NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+    const uint8_t *keyBytes = keyData.bytes;
+    NSUInteger keyLength = keyData.length;
+    
+    uint64_t forwardHash = 0xcbf29ce484222325ull;
+    uint64_t backwardHash = 0x6c62272e07bb0142ull;
+    
+    for (NSUInteger i = 0; i < keyLength; i++) {
+        forwardHash ^= keyBytes[i];
+        forwardHash *= 0x100000001b3ull;
+        
+        backwardHash ^= keyBytes[keyLength - 1 - i];
+        backwardHash *= 0x100000001b3ull;
+    }
+    
+    // Little-endian, so segment files mean the same thing everywhere
+    for (NSUInteger i = 0; i < 8; i++) {
+        outDigest[i] = (uint8_t)(forwardHash >> (8 * i));
+        outDigest[8 + i] = (uint8_t)(backwardHash >> (8 * i));
+    }
+}
+
+@interface BCCPersistentCacheSegmentStore () {
+    pthread_rwlock_t _segmentRemovalLock;
+}
+
+@property (strong, nonatomic) NSString *directoryPath;
+@property (nonatomic) NSUInteger activeSegmentIdentifier;
+@property (nonatomic) int activeSegmentDescriptor;
+@property (nonatomic) unsigned long long activeSegmentSize;
+
+// Appends and new segment files not yet flushed to disk. Guarded by
+// @synchronized(self).
+@property (nonatomic) BOOL activeSegmentNeedsSynchronization;
+@property (nonatomic) BOOL directoryNeedsSynchronization;
+
+// Segment identifier -> file size / live record bytes. Guarded by
+// @synchronized(self).
+@property (strong, nonatomic) NSMutableDictionary *segmentSizes;
+@property (strong, nonatomic) NSMutableDictionary *liveByteCounts;
+@property (nonatomic) BOOL liveByteCountsLoaded;
+
+// Segment identifier -> idle read-only descriptor, with the identifiers in
+// least recently used order. Readers check a descriptor out for the length
+// of a read, so one is never closed while in use. Both guarded by
+// @synchronized on the dictionary.
+@property (strong, nonatomic) NSMutableDictionary *readDescriptors;
+@property (strong, nonatomic) NSMutableArray *readDescriptorOrder;
+
+// Private Methods
+- (NSString *)_pathForSegmentIdentifier:(NSUInteger)segmentIdentifier;
+- (void)_loadSegments;
+- (unsigned long long)_recoverSegmentAtPath:(NSString *)segmentPath;
+- (BOOL)_openActiveSegment;
+- (void)_closeActiveSegment;
+- (BOOL)_synchronizeActiveSegment;
+- (int)_checkOutReadDescriptorForSegmentIdentifier:(NSUInteger)segmentIdentifier;
+- (void)_checkInReadDescriptor:(int)descriptor forSegmentIdentifier:(NSUInteger)segmentIdentifier;
+
+@end
+
+
+@implementation BCCPersistentCacheSegmentStore
+
+#pragma mark Initialization
+
+- (id)initWithDirectoryPath:(NSString *)directoryPath;
+{
+    if (!directoryPath.length) {
+        return nil;
+    }
+    
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    pthread_rwlock_init(&_segmentRemovalLock, NULL);
+    
+    _directoryPath = directoryPath;
+    _maximumSegmentFileSize = BCCPersistentCacheSegmentStoreDefaultMaximumSegmentFileSize;
+    _compactionThreshold = BCCPersistentCacheSegmentStoreDefaultCompactionThreshold;
+    
+    _activeSegmentDescriptor = -1;
+    
+    _segmentSizes = [[NSMutableDictionary alloc] init];
+    _liveByteCounts = [[NSMutableDictionary alloc] init];
+    _readDescriptors = [[NSMutableDictionary alloc] init];
+    _readDescriptorOrder = [[NSMutableArray alloc] init];
+    
+    [self _loadSegments];
+    
+    return self;
+}
+
+- (void)dealloc;
+{
+    [self _closeActiveSegment];
+    
+    for (NSNumber *currentDescriptor in self.readDescriptors.allValues) {
+        close(currentDescriptor.intValue);
+    }
+    
+    pthread_rwlock_destroy(&_segmentRemovalLock);
+}
+
+#pragma mark Accessors
+
+- (BOOL)hasSegments;
+{
+    @synchronized (self) {
+        return self.segmentSizes.count > 0;
+    }
+}
+
+#pragma mark Records
+
++ (NSUInteger)recordSizeForDataLength:(NSUInteger)length;
+{
+    return sizeof(BCCPersistentCacheSegmentRecordHeader) + length;
+}
+
+- (BOOL)appendData:(NSData *)data forKey:(NSString *)key segmentIdentifier:(NSUInteger *)outSegmentIdentifier offset:(NSUInteger *)outOffset;
+{
+    if (!data.length || !key.length || data.length > UINT32_MAX) {
+        return NO;
+    }
+    
+    BCCPersistentCacheSegmentRecordHeader header;
+    header.magic = BCCPersistentCacheSegmentRecordMagic;
+    header.length = (uint32_t)data.length;
+    header.checksum = BCCPersistentCacheSegmentChecksum(data.bytes, data.length);
+    BCCPersistentCacheSegmentKeyDigest(key, header.keyDigest);
+    
+    NSUInteger recordSize = [BCCPersistentCacheSegmentStore recordSizeForDataLength:data.length];
+    
+    @synchronized (self) {
+        // Seal the active segment once it's full; a record bigger than the
+        // limit still gets a segment to itself rather than failing.
+        if (self.activeSegmentSize > 0 && self.activeSegmentSize + recordSize > self.maximumSegmentFileSize) {
+            // Nothing writes to a sealed segment again, so this is its
+            // last chance to reach the disk
+            if (![self _synchronizeActiveSegment]) {
+                return NO;
+            }
+            
+            [self _closeActiveSegment];
+            self.activeSegmentIdentifier++;
+            self.activeSegmentSize = 0;
+        }
+    
+        if (![self _openActiveSegment]) {
+            return NO;
+        }
+    
+        unsigned long long recordOffset = self.activeSegmentSize;
+    
+        // Header and payload go out in a single write
+        struct iovec recordVectors[2];
+        recordVectors[0].iov_base = &header;
+        recordVectors[0].iov_len = sizeof(header);
+        recordVectors[1].iov_base = (void *)data.bytes;
+        recordVectors[1].iov_len = data.length;
+    
+        ssize_t bytesWritten = writev(self.activeSegmentDescriptor, recordVectors, 2);
+        if (bytesWritten != (ssize_t)recordSize) {
+            NSLog(@"Unable to append %lu bytes to cache segment %lu: %s", (unsigned long)recordSize, (unsigned long)self.activeSegmentIdentifier, strerror(errno));
+    
+            // Don't leave a torn record for the next one to follow
+            ftruncate(self.activeSegmentDescriptor, (off_t)recordOffset);
+            return NO;
+        }
+    
+        self.activeSegmentSize += recordSize;
+        self.activeSegmentNeedsSynchronization = YES;
+    
+        NSNumber *segmentKey = @(self.activeSegmentIdentifier);
+        [self.segmentSizes setObject:@(self.activeSegmentSize) forKey:segmentKey];
+        [self.liveByteCounts setObject:@([[self.liveByteCounts objectForKey:segmentKey] unsignedLongLongValue] + recordSize) forKey:segmentKey];
+    
+        if (outSegmentIdentifier) {
+            *outSegmentIdentifier = self.activeSegmentIdentifier;
+        }
+    
+        if (outOffset) {
+            *outOffset = (NSUInteger)recordOffset;
+        }
+    }
+    
+    return YES;
+}
+
+- (NSData *)dataForKey:(NSString *)key segmentIdentifier:(NSUInteger)segmentIdentifier offset:(NSUInteger)offset length:(NSUInteger)length;
+{
+    if (!key.length || !length || segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+        return nil;
+    }
+    
+    NSMutableData *data = nil;
+    
+    pthread_rwlock_rdlock(&_segmentRemovalLock);
+    
+    int descriptor = [self _checkOutReadDescriptorForSegmentIdentifier:segmentIdentifier];
+    if (descriptor >= 0) {
+        BCCPersistentCacheSegmentRecordHeader header;
+    
+        if (pread(descriptor, &header, sizeof(header), (off_t)offset) == sizeof(header) && header.magic == BCCPersistentCacheSegmentRecordMagic && header.length == length) {
+            data = [[NSMutableData alloc] initWithLength:length];
+    
+            if (pread(descriptor, data.mutableBytes, length, (off_t)(offset + sizeof(header))) != (ssize_t)length) {
+                data = nil;
+            }
+        }
+    
+        // Reject anything that isn't exactly what the metadata says should
+        // be there, e.g. a record lost to crash recovery
+        if (data) {
+            uint8_t keyDigest[BCCPersistentCacheSegmentKeyDigestLength];
+            BCCPersistentCacheSegmentKeyDigest(key, keyDigest);
+    
+            if (memcmp(keyDigest, header.keyDigest, BCCPersistentCacheSegmentKeyDigestLength) != 0 || BCCPersistentCacheSegmentChecksum(data.bytes, data.length) != header.checksum) {
+                data = nil;
+            }
+        }
+    
+        [self _checkInReadDescriptor:descriptor forSegmentIdentifier:segmentIdentifier];
+    }
+    
+    pthread_rwlock_unlock(&_segmentRemovalLock);
+    
+    return data;
+}
+
+- (BOOL)synchronize;
+{
+    @synchronized (self) {
+        if (![self _synchronizeActiveSegment]) {
+            return NO;
+        }
+        
+        if (!self.directoryNeedsSynchronization) {
+            return YES;
+        }
+        
+        // New segment files aren't durable until their directory entry is
+        int directoryDescriptor = open([self.directoryPath fileSystemRepresentation], O_RDONLY);
+        if (directoryDescriptor < 0 || fsync(directoryDescriptor) != 0) {
+            NSLog(@"Unable to synchronize cache segment directory %@: %s", self.directoryPath, strerror(errno));
+            
+            if (directoryDescriptor >= 0) {
+                close(directoryDescriptor);
+            }
+            
+            return NO;
+        }
+        
+        close(directoryDescriptor);
+        self.directoryNeedsSynchronization = NO;
+        
+        return YES;
+    }
+}
+
+#pragma mark Live Byte Accounting
+
+- (void)resetLiveByteCounts:(NSDictionary *)liveByteCountsBySegmentIdentifier;
+{
+    @synchronized (self) {
+        [self.liveByteCounts removeAllObjects];
+    
+        if (liveByteCountsBySegmentIdentifier) {
+            [self.liveByteCounts addEntriesFromDictionary:liveByteCountsBySegmentIdentifier];
+        }
+    
+        self.liveByteCountsLoaded = YES;
+    }
+}
+
+- (void)releaseRecordOfLength:(NSUInteger)length fromSegmentIdentifier:(NSUInteger)segmentIdentifier;
+{
+    if (segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+        return;
+    }
+    
+    NSUInteger recordSize = [BCCPersistentCacheSegmentStore recordSizeForDataLength:length];
+    
+    @synchronized (self) {
+        NSNumber *segmentKey = @(segmentIdentifier);
+        unsigned long long liveBytes = [[self.liveByteCounts objectForKey:segmentKey] unsignedLongLongValue];
+    
+        [self.liveByteCounts setObject:@(liveBytes > recordSize ? liveBytes - recordSize : 0) forKey:segmentKey];
+    }
+}
+
+#pragma mark Compaction
+
+- (NSArray *)segmentIdentifiersNeedingCompaction;
+{
+    NSMutableArray *segmentIdentifiers = [[NSMutableArray alloc] init];
+    
+    @synchronized (self) {
+        // Until the owner has told us what's live, everything is
+        if (!self.liveByteCountsLoaded) {
+            return segmentIdentifiers;
+        }
+    
+        [self.segmentSizes enumerateKeysAndObjectsUsingBlock:^(NSNumber *segmentKey, NSNumber *segmentSize, BOOL *stop) {
+            if (segmentKey.unsignedIntegerValue == self.activeSegmentIdentifier || !segmentSize.unsignedLongLongValue) {
+                return;
+            }
+    
+            double liveBytes = [[self.liveByteCounts objectForKey:segmentKey] doubleValue];
+            double deadFraction = 1.0 - (liveBytes / segmentSize.doubleValue);
+    
+            if (deadFraction >= self.compactionThreshold) {
+                [segmentIdentifiers addObject:segmentKey];
+            }
+        }];
+    }
+    
+    [segmentIdentifiers sortUsingSelector:@selector(compare:)];
+    
+    return segmentIdentifiers;
+}
+
+- (void)removeSegmentWithIdentifier:(NSUInteger)segmentIdentifier;
+{
+    if (segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+        return;
+    }
+    
+    NSNumber *segmentKey = @(segmentIdentifier);
+    
+    pthread_rwlock_wrlock(&_segmentRemovalLock);
+    
+    @synchronized (self.readDescriptors) {
+        NSNumber *descriptor = [self.readDescriptors objectForKey:segmentKey];
+        if (descriptor) {
+            close(descriptor.intValue);
+            [self.readDescriptors removeObjectForKey:segmentKey];
+            [self.readDescriptorOrder removeObject:segmentKey];
+        }
+    }
+    
+    @synchronized (self) {
+        // Never pull the active segment out from under the writer; start a
+        // fresh one instead.
+        if (segmentIdentifier == self.activeSegmentIdentifier) {
+            [self _closeActiveSegment];
+            self.activeSegmentIdentifier++;
+            self.activeSegmentSize = 0;
+        }
+    
+        [self.segmentSizes removeObjectForKey:segmentKey];
+        [self.liveByteCounts removeObjectForKey:segmentKey];
+    }
+    
+    unlink([[self _pathForSegmentIdentifier:segmentIdentifier] fileSystemRepresentation]);
+    
+    pthread_rwlock_unlock(&_segmentRemovalLock);
+}
+
+- (void)removeAllSegments;
+{
+    pthread_rwlock_wrlock(&_segmentRemovalLock);
+    
+    @synchronized (self.readDescriptors) {
+        for (NSNumber *currentDescriptor in self.readDescriptors.allValues) {
+            close(currentDescriptor.intValue);
+        }
+    
+        [self.readDescriptors removeAllObjects];
+        [self.readDescriptorOrder removeAllObjects];
+    }
+    
+    @synchronized (self) {
+        [self _closeActiveSegment];
+    
+        [self.segmentSizes removeAllObjects];
+        [self.liveByteCounts removeAllObjects];
+    
+        self.activeSegmentIdentifier = 1;
+        self.activeSegmentSize = 0;
+        self.liveByteCountsLoaded = YES;
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtPath:self.directoryPath error:NULL];
+    
+    pthread_rwlock_unlock(&_segmentRemovalLock);
+}
+
+#pragma mark Private Methods
+
+- (NSString *)_pathForSegmentIdentifier:(NSUInteger)segmentIdentifier;
+{
+    NSString *fileName = [NSString stringWithFormat:@"%010lu.%@", (unsigned long)segmentIdentifier, BCCPersistentCacheSegmentFileExtension];
+    return [self.directoryPath stringByAppendingPathComponent:fileName];
+}
+
+- (void)_loadSegments;
+{
+    NSUInteger highestSegmentIdentifier = BCCPersistentCacheSegmentStoreNoSegment;
+    
+    NSArray *fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:self.directoryPath error:NULL];
+    for (NSString *currentFileName in fileNames) {
+        if (![currentFileName.pathExtension isEqualToString:BCCPersistentCacheSegmentFileExtension]) {
+            continue;
+        }
+    
+        NSUInteger segmentIdentifier = (NSUInteger)[[currentFileName stringByDeletingPathExtension] longLongValue];
+        if (segmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+            continue;
+        }
+    
+        struct stat segmentStat;
+        if (stat([[self _pathForSegmentIdentifier:segmentIdentifier] fileSystemRepresentation], &segmentStat) != 0) {
+            continue;
+        }
+    
+        [self.segmentSizes setObject:@((unsigned long long)segmentStat.st_size) forKey:@(segmentIdentifier)];
+        highestSegmentIdentifier = MAX(highestSegmentIdentifier, segmentIdentifier);
+    }
+    
+    if (highestSegmentIdentifier == BCCPersistentCacheSegmentStoreNoSegment) {
+        self.activeSegmentIdentifier = 1;
+        self.activeSegmentSize = 0;
+        self.liveByteCountsLoaded = YES;
+        return;
+    }
+    
+    // Only the newest segment can have been mid-append when we went down;
+    // the older ones were sealed before it was started.
+    self.activeSegmentIdentifier = highestSegmentIdentifier;
+    self.activeSegmentSize = [self _recoverSegmentAtPath:[self _pathForSegmentIdentifier:highestSegmentIdentifier]];
+    [self.segmentSizes setObject:@(self.activeSegmentSize) forKey:@(highestSegmentIdentifier)];
+}
+
+- (unsigned long long)_recoverSegmentAtPath:(NSString *)segmentPath;
+{
+    int descriptor = open([segmentPath fileSystemRepresentation], O_RDWR);
+    if (descriptor < 0) {
+        return 0;
+    }
+    
+    struct stat segmentStat;
+    if (fstat(descriptor, &segmentStat) != 0) {
+        close(descriptor);
+        return 0;
+    }
+    
+    unsigned long long fileSize = (unsigned long long)segmentStat.st_size;
+    unsigned long long validSize = 0;
+    NSMutableData *payloadBuffer = [[NSMutableData alloc] init];
+    
+    // Walk the records and stop at the first one that's short, has a bad
+    // header, or fails its checksum. Everything from there on is garbage.
+    while (validSize + sizeof(BCCPersistentCacheSegmentRecordHeader) <= fileSize) {
+        BCCPersistentCacheSegmentRecordHeader header;
+        if (pread(descriptor, &header, sizeof(header), (off_t)validSize) != sizeof(header) || header.magic != BCCPersistentCacheSegmentRecordMagic) {
+            break;
+        }
+    
+        unsigned long long recordEnd = validSize + sizeof(header) + header.length;
+        if (!header.length || recordEnd > fileSize) {
+            break;
+        }
+    
+        payloadBuffer.length = header.length;
+        if (pread(descriptor, payloadBuffer.mutableBytes, header.length, (off_t)(validSize + sizeof(header))) != (ssize_t)header.length) {
+            break;
+        }
+    
+        if (BCCPersistentCacheSegmentChecksum(payloadBuffer.bytes, header.length) != header.checksum) {
+            break;
+        }
+    
+        validSize = recordEnd;
+    }
+    
+    if (validSize < fileSize) {
+        NSLog(@"Truncating cache segment %@ from %llu to %llu bytes", segmentPath.lastPathComponent, fileSize, validSize);
+        ftruncate(descriptor, (off_t)validSize);
+    }
+    
+    close(descriptor);
+    
+    return validSize;
+}
+
+- (BOOL)_openActiveSegment;
+{
+    if (self.activeSegmentDescriptor >= 0) {
+        return YES;
+    }
+    
+    if (![[NSFileManager defaultManager] fileExistsAtPath:self.directoryPath]) {
+#ifdef BCCPersistentCacheSegmentStoreHasBCCKit
+        [[NSFileManager defaultManager] BCC_recursivelyCreatePath:self.directoryPath];
+#else
+        [[NSFileManager defaultManager] createDirectoryAtPath:self.directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+#endif
+    }
+    
+    NSString *segmentPath = [self _pathForSegmentIdentifier:self.activeSegmentIdentifier];
+    
+    if (![[NSFileManager defaultManager] fileExistsAtPath:segmentPath]) {
+        self.directoryNeedsSynchronization = YES;
+    }
+    
+    int descriptor = open([segmentPath fileSystemRepresentation], O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (descriptor < 0) {
+        NSLog(@"Unable to open cache segment %@: %s", segmentPath, strerror(errno));
+        return NO;
+    }
+    
+    self.activeSegmentDescriptor = descriptor;
+    
+    return YES;
+}
+
+- (void)_closeActiveSegment;
+{
+    if (self.activeSegmentDescriptor < 0) {
+        return;
+    }
+    
+    close(self.activeSegmentDescriptor);
+    self.activeSegmentDescriptor = -1;
+    self.activeSegmentNeedsSynchronization = NO;
+}
+
+- (BOOL)_synchronizeActiveSegment;
+{
+    if (!self.activeSegmentNeedsSynchronization || self.activeSegmentDescriptor < 0) {
+        return YES;
+    }
+    
+    if (fsync(self.activeSegmentDescriptor) != 0) {
+        NSLog(@"Unable to synchronize cache segment %lu: %s", (unsigned long)self.activeSegmentIdentifier, strerror(errno));
+        return NO;
+    }
+    
+    self.activeSegmentNeedsSynchronization = NO;
+    
+    return YES;
+}
+
+- (int)_checkOutReadDescriptorForSegmentIdentifier:(NSUInteger)segmentIdentifier;
+{
+    NSNumber *segmentKey = @(segmentIdentifier);
+    
+    @synchronized (self.readDescriptors) {
+        NSNumber *descriptor = [self.readDescriptors objectForKey:segmentKey];
+        if (descriptor) {
+            [self.readDescriptors removeObjectForKey:segmentKey];
+            [self.readDescriptorOrder removeObject:segmentKey];
+    
+            return descriptor.intValue;
+        }
+    }
+    
+    // Concurrent reads of the same segment each get their own descriptor
+    return open([[self _pathForSegmentIdentifier:segmentIdentifier] fileSystemRepresentation], O_RDONLY);
+}
+
+- (void)_checkInReadDescriptor:(int)descriptor forSegmentIdentifier:(NSUInteger)segmentIdentifier;
+{
+    NSNumber *segmentKey = @(segmentIdentifier);
+    
+    @synchronized (self.readDescriptors) {
+        if ([self.readDescriptors objectForKey:segmentKey]) {
+            close(descriptor);
+            return;
+        }
+    
+        [self.readDescriptors setObject:@(descriptor) forKey:segmentKey];
+        [self.readDescriptorOrder addObject:segmentKey];
+    
+        while (self.readDescriptorOrder.count > BCCPersistentCacheSegmentStoreMaximumReadDescriptors) {
+            NSNumber *evictedKey = self.readDescriptorOrder.firstObject;
+    
+            close([[self.readDescriptors objectForKey:evictedKey] intValue]);
+            [self.readDescriptors removeObjectForKey:evictedKey];
+            [self.readDescriptorOrder removeObjectAtIndex:0];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,100 @@
+//
+//  BCCBenchmarkRunner.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class BCCBenchmarkRandom;
+@class BCCBenchmarkResult;
+
+
+// Runs one sample and returns the time it spent on the measured work, in
+// seconds. Setup that shouldn't count is done around the timed section.
+typedef NSTimeInterval (^BCCBenchmarkSampleBlock)(NSUInteger sampleIndex, BCCBenchmarkRandom *random);
+
+typedef enum {
+    BCCBenchmarkOutputFormatJSON,
+    BCCBenchmarkOutputFormatCSV
+} BCCBenchmarkOutputFormat;
+
+
+// Monotonic clock, in seconds
+extern NSTimeInterval BCCBenchmarkCurrentTime(void);
+
+
+// Deterministic generator (splitmix64) so datasets are the same for a
+// given seed on every platform and every run
+@interface BCCBenchmarkRandom : NSObject
+
+@property (nonatomic, readonly) uint64_t seed;
+
+// Initialization
+- (id)initWithSeed:(uint64_t)seed;
+
+// Values
+- (uint64_t)nextValue;
+- (NSUInteger)nextValueBelow:(NSUInteger)limit;
+- (double)nextFraction;
+
+// Datasets
+- (NSData *)dataOfLength:(NSUInteger)length;
+- (NSString *)stringOfLength:(NSUInteger)length;
+- (NSArray *)shuffledArray:(NSArray *)array;
+
+@end
+
+
+@interface BCCBenchmarkResult : NSObject
+
+@property (strong, nonatomic, readonly) NSString *name;
+@property (strong, nonatomic, readonly) NSDictionary *parameters;
+@property (nonatomic, readonly) NSUInteger operationCount;
+
+// Sample durations in seconds, in the order they were taken
+@property (strong, nonatomic, readonly) NSArray *samples;
+
+@property (nonatomic, readonly) NSTimeInterval minimumDuration;
+@property (nonatomic, readonly) NSTimeInterval maximumDuration;
+@property (nonatomic, readonly) NSTimeInterval averageDuration;
+
+// Operations per second at the median sample
+@property (nonatomic, readonly) double operationsPerSecond;
+
+// Nearest rank over the samples, percentile from 0 to 100
+- (NSTimeInterval)durationAtPercentile:(double)percentile;
+
+@end
+
+
+@interface BCCBenchmarkRunner : NSObject
+
+@property (nonatomic, readonly) uint64_t seed;
+@property (nonatomic) NSUInteger sampleCount;
+@property (nonatomic) NSUInteger warmupSampleCount;
+
+// Only benchmarks whose names contain the filter are run (all when nil)
+@property (strong, nonatomic) NSString *filter;
+
+@property (strong, nonatomic, readonly) NSString *workingDirectory;
+@property (strong, nonatomic, readonly) NSArray *results;
+
+// Initialization
+- (id)initWithSeed:(uint64_t)seed;
+
+// Running
+- (BOOL)shouldRunBenchmarkNamed:(NSString *)name;
+- (BCCBenchmarkResult *)runBenchmarkNamed:(NSString *)name parameters:(NSDictionary *)parameters operationCount:(NSUInteger)operationCount sampleBlock:(BCCBenchmarkSampleBlock)sampleBlock;
+
+// Scratch directories live under the working directory, which is removed
+// by removeWorkingDirectory
+- (NSString *)scratchDirectoryWithName:(NSString *)name;
+- (void)removeWorkingDirectory;
+
+// Output
+- (NSData *)outputDataWithFormat:(BCCBenchmarkOutputFormat)format;
+
+@end
@@ -0,0 +1,413 @@
+//
+//  BCCBenchmarkRunner.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCBenchmarkRunner.h"
+
+#import <time.h>
+#import <unistd.h>
+
+
+static NSString *BCCBenchmarkParameterString(NSDictionary *parameters)
+{
+    // Sorted, so the string (and the seed derived from it) doesn't depend
+    // on dictionary ordering
+    NSMutableArray *pairs = [[NSMutableArray alloc] initWithCapacity:parameters.count];
+    for (NSString *currentKey in [parameters.allKeys sortedArrayUsingSelector:@selector(compare:)]) {
+        [pairs addObject:[NSString stringWithFormat:@"%@=%@", currentKey, [parameters objectForKey:currentKey]]];
+    }
+    
+    return [pairs componentsJoinedByString:@";"];
+}
+
+static uint64_t BCCBenchmarkHashString(NSString *string)
+{
+    // FNV-1a, since -hash isn't stable across platforms or releases
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    
+    const char *bytes = [string UTF8String];
+    for (const char *currentByte = bytes; currentByte && *currentByte; currentByte++) {
+        hash ^= (uint8_t)*currentByte;
+        hash *= 0x100000001b3ULL;
+    }
+    
+    return hash;
+}
+
+static NSString *BCCBenchmarkCSVField(NSString *field)
+{
+    if ([field rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@",\"\n"]].location == NSNotFound) {
+        return field;
+    }
+    
+    return [NSString stringWithFormat:@"\"%@\"", [field stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""]];
+}
+
+NSTimeInterval BCCBenchmarkCurrentTime(void)
+{
+    struct timespec currentTime;
+    clock_gettime(CLOCK_MONOTONIC, &currentTime);
+    
+    return (NSTimeInterval)currentTime.tv_sec + ((NSTimeInterval)currentTime.tv_nsec / 1000000000.0);
+}
+
+
+@interface BCCBenchmarkRandom () {
+    uint64_t _state;
+}
+
+@end
+
+
+@interface BCCBenchmarkResult ()
+
+@property (strong, nonatomic) NSArray *sortedSamples;
+
+- (id)initWithName:(NSString *)name parameters:(NSDictionary *)parameters operationCount:(NSUInteger)operationCount samples:(NSArray *)samples;
+
+- (NSDictionary *)dictionaryRepresentation;
+- (NSString *)CSVRow;
+
+@end
+
+
+@interface BCCBenchmarkRunner ()
+
+@property (strong, nonatomic) NSMutableArray *mutableResults;
+@property (nonatomic) NSUInteger scratchDirectoryCount;
+
+@end
+
+
+#pragma mark -
+
+@implementation BCCBenchmarkRunner
+
+#pragma mark - Initialization
+
+- (id)initWithSeed:(uint64_t)seed
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _seed = seed;
+    _sampleCount = 10;
+    _warmupSampleCount = 1;
+    
+    _mutableResults = [[NSMutableArray alloc] init];
+    
+    NSString *directoryName = [NSString stringWithFormat:@"BCCDataBenchmarks-%d", (int)getpid()];
+    _workingDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:directoryName];
+    
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (NSArray *)results
+{
+    return [self.mutableResults copy];
+}
+
+#pragma mark - Running
+
+- (BOOL)shouldRunBenchmarkNamed:(NSString *)name
+{
+    if (!self.filter.length) {
+        return YES;
+    }
+    
+    return ([name rangeOfString:self.filter].location != NSNotFound);
+}
+
+- (BCCBenchmarkResult *)runBenchmarkNamed:(NSString *)name parameters:(NSDictionary *)parameters operationCount:(NSUInteger)operationCount sampleBlock:(BCCBenchmarkSampleBlock)sampleBlock
+{
+    if (!name || !sampleBlock || ![self shouldRunBenchmarkNamed:name]) {
+        return nil;
+    }
+    
+    NSString *parameterString = BCCBenchmarkParameterString(parameters);
+    NSLog(@"Running %@ %@", name, parameterString);
+    
+    // Each benchmark gets its own seed, so filtering or reordering the
+    // suite doesn't change anybody's dataset
+    uint64_t benchmarkSeed = self.seed ^ BCCBenchmarkHashString([NSString stringWithFormat:@"%@ %@", name, parameterString]);
+    
+    NSUInteger totalSampleCount = self.warmupSampleCount + self.sampleCount;
+    NSMutableArray *samples = [[NSMutableArray alloc] initWithCapacity:self.sampleCount];
+    
+    for (NSUInteger currentSample = 0; currentSample < totalSampleCount; currentSample++) {
+        @autoreleasepool {
+            BCCBenchmarkRandom *random = [[BCCBenchmarkRandom alloc] initWithSeed:benchmarkSeed + currentSample];
+            NSTimeInterval duration = sampleBlock(currentSample, random);
+            
+            if (currentSample >= self.warmupSampleCount) {
+                [samples addObject:@(duration)];
+            }
+        }
+    }
+    
+    BCCBenchmarkResult *result = [[BCCBenchmarkResult alloc] initWithName:name parameters:parameters operationCount:operationCount samples:samples];
+    [self.mutableResults addObject:result];
+    
+    return result;
+}
+
+#pragma mark - Scratch Directories
+
+- (NSString *)scratchDirectoryWithName:(NSString *)name
+{
+    self.scratchDirectoryCount++;
+    
+    NSString *directoryName = [NSString stringWithFormat:@"%04lu-%@", (unsigned long)self.scratchDirectoryCount, name];
+    NSString *directoryPath = [self.workingDirectory stringByAppendingPathComponent:directoryName];
+    
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:&error]) {
+        NSLog(@"Unable to create benchmark directory %@: %@", directoryPath, error);
+        return nil;
+    }
+    
+    return directoryPath;
+}
+
+- (void)removeWorkingDirectory
+{
+    if (![[NSFileManager defaultManager] fileExistsAtPath:self.workingDirectory]) {
+        return;
+    }
+    
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] removeItemAtPath:self.workingDirectory error:&error]) {
+        NSLog(@"Unable to remove benchmark directory %@: %@", self.workingDirectory, error);
+    }
+}
+
+#pragma mark - Output
+
+- (NSData *)outputDataWithFormat:(BCCBenchmarkOutputFormat)format
+{
+    if (format == BCCBenchmarkOutputFormatCSV) {
+        NSMutableString *CSVString = [[NSMutableString alloc] initWithString:@"name,parameters,operations,samples,min_s,mean_s,p50_s,p90_s,p99_s,max_s,ops_per_s\n"];
+        for (BCCBenchmarkResult *currentResult in self.mutableResults) {
+            [CSVString appendString:[currentResult CSVRow]];
+            [CSVString appendString:@"\n"];
+        }
+        
+        return [CSVString dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    
+    NSMutableArray *resultDictionaries = [[NSMutableArray alloc] initWithCapacity:self.mutableResults.count];
+    for (BCCBenchmarkResult *currentResult in self.mutableResults) {
+        [resultDictionaries addObject:[currentResult dictionaryRepresentation]];
+    }
+    
+    NSProcessInfo *processInfo = [NSProcessInfo processInfo];
+    NSDictionary *environment = @{@"os": processInfo.operatingSystemVersionString, @"processors": @(processInfo.activeProcessorCount), @"physicalMemory": @(processInfo.physicalMemory)};
+    
+    NSDictionary *output = @{@"seed": @(self.seed), @"samples": @(self.sampleCount), @"warmupSamples": @(self.warmupSampleCount), @"environment": environment, @"results": resultDictionaries};
+    
+    NSError *error = nil;
+    NSData *outputData = [NSJSONSerialization dataWithJSONObject:output options:NSJSONWritingPrettyPrinted error:&error];
+    if (!outputData) {
+        NSLog(@"Unable to serialize benchmark results: %@", error);
+    }
+    
+    return outputData;
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCBenchmarkResult
+
+#pragma mark - Initialization
+
+- (id)initWithName:(NSString *)name parameters:(NSDictionary *)parameters operationCount:(NSUInteger)operationCount samples:(NSArray *)samples
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _name = name;
+    _parameters = parameters ? [parameters copy] : @{};
+    _operationCount = operationCount;
+    _samples = [samples copy];
+    _sortedSamples = [samples sortedArrayUsingSelector:@selector(compare:)];
+    
+    return self;
+}
+
+#pragma mark - Statistics
+
+- (NSTimeInterval)minimumDuration
+{
+    return [[self.sortedSamples firstObject] doubleValue];
+}
+
+- (NSTimeInterval)maximumDuration
+{
+    return [[self.sortedSamples lastObject] doubleValue];
+}
+
+- (NSTimeInterval)averageDuration
+{
+    if (self.samples.count < 1) {
+        return 0.0;
+    }
+    
+    NSTimeInterval totalDuration = 0.0;
+    for (NSNumber *currentSample in self.samples) {
+        totalDuration += [currentSample doubleValue];
+    }
+    
+    return totalDuration / self.samples.count;
+}
+
+- (NSTimeInterval)durationAtPercentile:(double)percentile
+{
+    NSUInteger sampleCount = self.sortedSamples.count;
+    if (sampleCount < 1) {
+        return 0.0;
+    }
+    
+    NSUInteger rank = (NSUInteger)ceil(sampleCount * MAX(MIN(percentile, 100.0), 0.0) / 100.0);
+    NSUInteger sampleIndex = (rank > 0) ? (rank - 1) : 0;
+    
+    return [[self.sortedSamples objectAtIndex:sampleIndex] doubleValue];
+}
+
+- (double)operationsPerSecond
+{
+    NSTimeInterval medianDuration = [self durationAtPercentile:50.0];
+    
+    return (medianDuration > 0.0) ? (self.operationCount / medianDuration) : 0.0;
+}
+
+#pragma mark - Output
+
+- (NSDictionary *)dictionaryRepresentation
+{
+    NSMutableDictionary *dictionary = [[NSMutableDictionary alloc] init];
+    [dictionary setObject:self.name forKey:@"name"];
+    [dictionary setObject:self.parameters forKey:@"parameters"];
+    [dictionary setObject:@(self.operationCount) forKey:@"operations"];
+    [dictionary setObject:self.samples forKey:@"samples"];
+    [dictionary setObject:@(self.minimumDuration) forKey:@"min"];
+    [dictionary setObject:@(self.averageDuration) forKey:@"mean"];
+    [dictionary setObject:@([self durationAtPercentile:50.0]) forKey:@"p50"];
+    [dictionary setObject:@([self durationAtPercentile:90.0]) forKey:@"p90"];
+    [dictionary setObject:@([self durationAtPercentile:99.0]) forKey:@"p99"];
+    [dictionary setObject:@(self.maximumDuration) forKey:@"max"];
+    [dictionary setObject:@(self.operationsPerSecond) forKey:@"operationsPerSecond"];
+    
+    return dictionary;
+}
+
+- (NSString *)CSVRow
+{
+    NSArray *fields = @[BCCBenchmarkCSVField(self.name),
+                        BCCBenchmarkCSVField(BCCBenchmarkParameterString(self.parameters)),
+                        [NSString stringWithFormat:@"%lu", (unsigned long)self.operationCount],
+                        [NSString stringWithFormat:@"%lu", (unsigned long)self.samples.count],
+                        [NSString stringWithFormat:@"%.9f", self.minimumDuration],
+                        [NSString stringWithFormat:@"%.9f", self.averageDuration],
+                        [NSString stringWithFormat:@"%.9f", [self durationAtPercentile:50.0]],
+                        [NSString stringWithFormat:@"%.9f", [self durationAtPercentile:90.0]],
+                        [NSString stringWithFormat:@"%.9f", [self durationAtPercentile:99.0]],
+                        [NSString stringWithFormat:@"%.9f", self.maximumDuration],
+                        [NSString stringWithFormat:@"%.1f", self.operationsPerSecond]];
+    
+    return [fields componentsJoinedByString:@","];
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCBenchmarkRandom
+
+#pragma mark - Initialization
+
+- (id)initWithSeed:(uint64_t)seed
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _seed = seed;
+    _state = seed;
+    
+    return self;
+}
+
+#pragma mark - Values
+
+- (uint64_t)nextValue
+{
+    uint64_t value = (_state += 0x9e3779b97f4a7c15ULL);
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    
+    return value ^ (value >> 31);
+}
+
+- (NSUInteger)nextValueBelow:(NSUInteger)limit
+{
+    if (limit < 1) {
+        return 0;
+    }
+    
+    // Modulo bias is negligible at the sizes the benchmarks use
+    return (NSUInteger)([self nextValue] % limit);
+}
+
+- (double)nextFraction
+{
+    return (double)([self nextValue] >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#pragma mark - Datasets
+
+- (NSData *)dataOfLength:(NSUInteger)length
+{
+    NSMutableData *data = [[NSMutableData alloc] initWithLength:length];
+    uint8_t *bytes = [data mutableBytes];
+    
+    for (NSUInteger offset = 0; offset < length; offset += sizeof(uint64_t)) {
+        uint64_t value = [self nextValue];
+        memcpy(bytes + offset, &value, MIN(sizeof(uint64_t), length - offset));
+    }
+    
+    return data;
+}
+
+- (NSString *)stringOfLength:(NSUInteger)length
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    
+    NSMutableString *string = [[NSMutableString alloc] initWithCapacity:length];
+    for (NSUInteger i = 0; i < length; i++) {
+        [string appendFormat:@"%c", alphabet[[self nextValueBelow:sizeof(alphabet) - 1]]];
+    }
+    
+    return string;
+}
+
+- (NSArray *)shuffledArray:(NSArray *)array
+{
+    NSMutableArray *shuffledArray = [array mutableCopy];
+    
+    for (NSUInteger i = shuffledArray.count; i > 1; i--) {
+        [shuffledArray exchangeObjectAtIndex:i - 1 withObjectAtIndex:[self nextValueBelow:i]];
+    }
+    
+    return shuffledArray;
+}
+
+@end
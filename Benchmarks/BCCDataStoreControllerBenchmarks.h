@@ -0,0 +1,27 @@
+//
+//  BCCDataStoreControllerBenchmarks.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class BCCBenchmarkRunner;
+
+
+// JSON import, identity lookups, observer fan-out and bulk deletes against
+// a synthetic model, on stores created under the runner's working directory
+@interface BCCDataStoreControllerBenchmarks : NSObject
+
+@property (strong, nonatomic, readonly) BCCBenchmarkRunner *runner;
+@property (nonatomic, readonly) NSUInteger recordCount;
+
+// Initialization
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner recordCount:(NSUInteger)recordCount;
+
+// Running
+- (void)run;
+
+@end
@@ -0,0 +1,463 @@
+//
+//  BCCDataStoreControllerBenchmarks.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCDataStoreControllerBenchmarks.h"
+#import "BCCBenchmarkRunner.h"
+#import "BCCDataStoreController.h"
+
+#import <CoreData/CoreData.h>
+
+
+// Constants
+NSString *BCCDataStoreControllerBenchmarksIdentifier = @"Benchmarks";
+NSString *BCCDataStoreControllerBenchmarksItemEntityName = @"BenchmarkItem";
+NSString *BCCDataStoreControllerBenchmarksModelFileName = @"BenchmarkModel.mom";
+
+// Records spread evenly over this many groups
+const NSUInteger BCCDataStoreControllerBenchmarksGroupCount = 16;
+
+// Item values are uniform below this, so "value < limit / 2" matches about
+// half of the store
+const NSUInteger BCCDataStoreControllerBenchmarksValueLimit = 1000;
+
+const NSUInteger BCCDataStoreControllerBenchmarksMaximumUpdateCount = 500;
+
+
+static NSAttributeDescription *BCCDataStoreControllerBenchmarksAttribute(NSString *name, NSAttributeType attributeType, BOOL indexed)
+{
+    NSAttributeDescription *attribute = [[NSAttributeDescription alloc] init];
+    attribute.name = name;
+    attribute.attributeType = attributeType;
+    attribute.optional = YES;
+    
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    attribute.indexed = indexed;
+#pragma clang diagnostic pop
+    
+    return attribute;
+}
+
+
+@interface BCCDataStoreControllerBenchmarksObserver : NSObject
+
+@property (nonatomic) NSUInteger notificationCount;
+
+- (void)dataStoreDidChange:(BCCDataStoreChangeNotification *)changeNotification;
+
+@end
+
+
+@interface BCCDataStoreControllerBenchmarks ()
+
+@property (strong, nonatomic) NSString *modelPath;
+@property (strong, nonatomic) NSArray *records;
+@property (strong, nonatomic) NSString *seededStoreDirectory;
+
+@property (strong, nonatomic) BCCDataStoreControllerIdentityParameters *identityParameters;
+
+// Benchmarks
+- (void)runImportBenchmarks;
+- (void)runFindOrCreateBenchmarks;
+- (void)runObserverFanOutBenchmarks;
+- (void)runDeleteBenchmarks;
+
+// Datasets
++ (NSManagedObjectModel *)benchmarkModel;
+- (NSArray *)recordsWithCount:(NSUInteger)recordCount random:(BCCBenchmarkRandom *)random;
+- (BCCDataStoreControllerImportParameters *)importParametersFindingExisting:(BOOL)findExisting inBatches:(BOOL)inBatches;
+
+// Stores
+- (BCCDataStoreController *)newControllerWithRootDirectory:(NSString *)rootDirectory;
+- (NSString *)storeDirectorySeededWithRecords:(NSArray *)records name:(NSString *)name;
+- (NSString *)scratchCopyOfStoreDirectory:(NSString *)storeDirectory;
+- (void)importRecords:(NSArray *)records intoController:(BCCDataStoreController *)benchmarkController usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters;
+
+@end
+
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerBenchmarks
+
+#pragma mark - Initialization
+
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner recordCount:(NSUInteger)recordCount
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _runner = runner;
+    _recordCount = recordCount;
+    
+    _identityParameters = [BCCDataStoreControllerIdentityParameters identityParametersWithEntityName:BCCDataStoreControllerBenchmarksItemEntityName identityPropertyName:@"identifier"];
+    
+    return self;
+}
+
+#pragma mark - Running
+
+- (void)run
+{
+    NSString *modelDirectory = [self.runner scratchDirectoryWithName:@"model"];
+    NSString *modelPath = [modelDirectory stringByAppendingPathComponent:BCCDataStoreControllerBenchmarksModelFileName];
+    
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    NSData *modelData = [NSKeyedArchiver archivedDataWithRootObject:[BCCDataStoreControllerBenchmarks benchmarkModel]];
+#pragma clang diagnostic pop
+    
+    if (![modelData writeToFile:modelPath atomically:YES]) {
+        NSLog(@"Unable to write benchmark model to %@", modelPath);
+        return;
+    }
+    
+    self.modelPath = modelPath;
+    
+    // The dataset only depends on the seed, so every benchmark in a run
+    // (and every run with the same seed) works on the same records
+    BCCBenchmarkRandom *datasetRandom = [[BCCBenchmarkRandom alloc] initWithSeed:self.runner.seed];
+    self.records = [self recordsWithCount:self.recordCount random:datasetRandom];
+    
+    [self runImportBenchmarks];
+    [self runFindOrCreateBenchmarks];
+    [self runObserverFanOutBenchmarks];
+    [self runDeleteBenchmarks];
+}
+
+#pragma mark - Benchmarks
+
+- (void)runImportBenchmarks
+{
+    NSString *benchmarkName = @"datastore.import";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    // When finding existing objects, half of the payload is already there
+    NSArray *existingRecords = [self.records subarrayWithRange:NSMakeRange(0, self.records.count / 2)];
+    NSString *partiallySeededDirectory = [self storeDirectorySeededWithRecords:existingRecords name:@"import-seed"];
+    
+    NSArray *variants = @[@{@"findExisting": @NO, @"batched": @NO}, @{@"findExisting": @YES, @"batched": @NO}, @{@"findExisting": @YES, @"batched": @YES}];
+    
+    for (NSDictionary *currentVariant in variants) {
+        BOOL findExisting = [[currentVariant objectForKey:@"findExisting"] boolValue];
+        BOOL batched = [[currentVariant objectForKey:@"batched"] boolValue];
+        
+        BCCDataStoreControllerImportParameters *importParameters = [self importParametersFindingExisting:findExisting inBatches:batched];
+        
+        NSMutableDictionary *parameters = [currentVariant mutableCopy];
+        [parameters setObject:@(self.records.count) forKey:@"records"];
+        [parameters setObject:@(findExisting ? existingRecords.count : 0) forKey:@"existing"];
+        
+        [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:self.records.count sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+            NSString *rootDirectory = findExisting ? [self scratchCopyOfStoreDirectory:partiallySeededDirectory] : [self.runner scratchDirectoryWithName:@"import"];
+            BCCDataStoreController *benchmarkController = [self newControllerWithRootDirectory:rootDirectory];
+            
+            NSArray *payload = [random shuffledArray:self.records];
+            
+            NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+            [self importRecords:payload intoController:benchmarkController usingImportParameters:importParameters];
+            
+            return BCCBenchmarkCurrentTime() - startTime;
+        }];
+    }
+}
+
+- (void)runFindOrCreateBenchmarks
+{
+    NSString *benchmarkName = @"datastore.findOrCreate";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    NSArray *identifiers = [self.records valueForKey:@"identifier"];
+    BCCDataStoreControllerIdentityParameters *identityParameters = self.identityParameters;
+    
+    for (NSNumber *currentHitRatio in @[@0.0, @0.5, @0.9, @1.0]) {
+        NSUInteger cachedCount = (NSUInteger)round(identifiers.count * [currentHitRatio doubleValue]);
+        
+        BCCDataStoreController *benchmarkController = [self newControllerWithRootDirectory:[self scratchCopyOfStoreDirectory:self.seededStoreDirectory]];
+        
+        NSDictionary *parameters = @{@"hitRatio": currentHitRatio, @"records": @(self.records.count)};
+        
+        [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:identifiers.count sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+            NSArray *shuffledIdentifiers = [random shuffledArray:identifiers];
+            NSArray *cachedIdentifiers = [shuffledIdentifiers subarrayWithRange:NSMakeRange(0, cachedCount)];
+            NSArray *lookupIdentifiers = [random shuffledArray:shuffledIdentifiers];
+            
+            __block NSTimeInterval duration = 0.0;
+            
+            [benchmarkController performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+                // The object cache only lives as long as a work block, so
+                // it has to be warmed up in the same one
+                for (NSString *currentIdentifier in cachedIdentifiers) {
+                    [dataStoreController findOrCreateObjectWithIdentityParameters:identityParameters identityValue:currentIdentifier groupIdentifier:nil];
+                }
+                
+                NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+                
+                for (NSString *currentIdentifier in lookupIdentifiers) {
+                    [dataStoreController findOrCreateObjectWithIdentityParameters:identityParameters identityValue:currentIdentifier groupIdentifier:nil];
+                }
+                
+                duration = BCCBenchmarkCurrentTime() - startTime;
+                
+                [managedObjectContext reset];
+            }];
+            
+            return duration;
+        }];
+    }
+}
+
+- (void)runObserverFanOutBenchmarks
+{
+    NSString *benchmarkName = @"datastore.observerFanOut";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    NSArray *identifiers = [self.records valueForKey:@"identifier"];
+    NSUInteger updateCount = MIN(identifiers.count, BCCDataStoreControllerBenchmarksMaximumUpdateCount);
+    
+    for (NSNumber *currentObserverCount in @[@0, @10, @100, @1000]) {
+        for (NSNumber *currentRequiresChangedKeys in @[@NO, @YES]) {
+            NSUInteger observerCount = [currentObserverCount unsignedIntegerValue];
+            BOOL requiresChangedKeys = [currentRequiresChangedKeys boolValue];
+            
+            if (observerCount < 1 && requiresChangedKeys) {
+                continue;
+            }
+            
+            BCCDataStoreController *benchmarkController = [self newControllerWithRootDirectory:[self scratchCopyOfStoreDirectory:self.seededStoreDirectory]];
+            
+            // Deliver synchronously so the save covers the whole fan-out
+            benchmarkController.waitsForObserverNotifications = YES;
+            
+            // Observers each watch a random slice of the value range. With
+            // required changed keys, half of them only care about a key the
+            // updates never touch.
+            BCCBenchmarkRandom *observerRandom = [[BCCBenchmarkRandom alloc] initWithSeed:self.runner.seed + observerCount];
+            NSMutableArray *observers = [[NSMutableArray alloc] initWithCapacity:observerCount];
+            
+            for (NSUInteger i = 0; i < observerCount; i++) {
+                BCCDataStoreControllerBenchmarksObserver *observer = [[BCCDataStoreControllerBenchmarksObserver alloc] init];
+                [observers addObject:observer];
+                
+                NSPredicate *predicate = [NSPredicate predicateWithFormat:@"value >= %lu", (unsigned long)[observerRandom nextValueBelow:BCCDataStoreControllerBenchmarksValueLimit]];
+                NSArray *requiredChangedKeys = requiresChangedKeys ? ((i % 2) ? @[@"value"] : @[@"name"]) : nil;
+                
+                [benchmarkController addObserver:observer action:@selector(dataStoreDidChange:) forEntityName:BCCDataStoreControllerBenchmarksItemEntityName withPredicate:predicate requiredChangedKeys:requiredChangedKeys];
+            }
+            
+            NSDictionary *parameters = @{@"observers": currentObserverCount, @"requiredChangedKeys": currentRequiresChangedKeys, @"updates": @(updateCount)};
+            
+            [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:updateCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+                NSArray *updatedIdentifiers = [[random shuffledArray:identifiers] subarrayWithRange:NSMakeRange(0, updateCount)];
+                
+                __block NSTimeInterval duration = 0.0;
+                
+                [benchmarkController performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+                    NSFetchRequest *fetchRequest = [dataStoreController fetchRequestForEntityName:BCCDataStoreControllerBenchmarksItemEntityName sortDescriptors:nil];
+                    fetchRequest.predicate = [NSPredicate predicateWithFormat:@"identifier IN %@", updatedIdentifiers];
+                    fetchRequest.returnsObjectsAsFaults = NO;
+                    
+                    NSArray *updatedObjects = [dataStoreController performFetchRequest:fetchRequest error:NULL];
+                    
+                    NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+                    
+                    for (NSManagedObject *currentObject in updatedObjects) {
+                        [currentObject setValue:@([random nextValueBelow:BCCDataStoreControllerBenchmarksValueLimit]) forKey:@"value"];
+                    }
+                    
+                    [dataStoreController saveCurrentMOC];
+                    
+                    duration = BCCBenchmarkCurrentTime() - startTime;
+                }];
+                
+                return duration;
+            }];
+            
+            for (BCCDataStoreControllerBenchmarksObserver *currentObserver in observers) {
+                [benchmarkController removeObserver:currentObserver];
+            }
+        }
+    }
+}
+
+- (void)runDeleteBenchmarks
+{
+    NSString *benchmarkName = @"datastore.delete";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    NSPredicate *halfPredicate = [NSPredicate predicateWithFormat:@"value < %lu", (unsigned long)(BCCDataStoreControllerBenchmarksValueLimit / 2)];
+    
+    for (NSString *currentScope in @[@"entity", @"predicate"]) {
+        for (NSNumber *currentUsesBatchDeletes in @[@NO, @YES]) {
+            BOOL usesBatchDeletes = [currentUsesBatchDeletes boolValue];
+            NSPredicate *predicate = [currentScope isEqualToString:@"predicate"] ? halfPredicate : nil;
+            
+            NSUInteger deletedCount = predicate ? [[self.records filteredArrayUsingPredicate:predicate] count] : self.records.count;
+            NSDictionary *parameters = @{@"scope": currentScope, @"batchDeleteRequests": currentUsesBatchDeletes, @"records": @(self.records.count)};
+            
+            [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:deletedCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+                BCCDataStoreController *benchmarkController = [self newControllerWithRootDirectory:[self scratchCopyOfStoreDirectory:self.seededStoreDirectory]];
+                benchmarkController.usesBatchDeleteRequests = usesBatchDeletes;
+                
+                NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+                
+                [benchmarkController performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+                    if (predicate) {
+                        [dataStoreController deleteObjectsWithEntityName:BCCDataStoreControllerBenchmarksItemEntityName matchingPredicate:predicate];
+                    } else {
+                        [dataStoreController deleteObjectsWithEntityName:BCCDataStoreControllerBenchmarksItemEntityName];
+                    }
+                }];
+                
+                NSError *error = nil;
+                if (![benchmarkController persistChangesAndWait:&error]) {
+                    NSLog(@"Unable to persist benchmark deletes: %@", error);
+                }
+                
+                return BCCBenchmarkCurrentTime() - startTime;
+            }];
+        }
+    }
+}
+
+#pragma mark - Datasets
+
++ (NSManagedObjectModel *)benchmarkModel
+{
+    NSEntityDescription *itemEntity = [[NSEntityDescription alloc] init];
+    itemEntity.name = BCCDataStoreControllerBenchmarksItemEntityName;
+    itemEntity.managedObjectClassName = NSStringFromClass([NSManagedObject class]);
+    itemEntity.properties = @[BCCDataStoreControllerBenchmarksAttribute(@"identifier", NSStringAttributeType, YES),
+                              BCCDataStoreControllerBenchmarksAttribute(@"group", NSStringAttributeType, YES),
+                              BCCDataStoreControllerBenchmarksAttribute(@"name", NSStringAttributeType, NO),
+                              BCCDataStoreControllerBenchmarksAttribute(@"value", NSInteger64AttributeType, NO),
+                              BCCDataStoreControllerBenchmarksAttribute(@"score", NSDoubleAttributeType, NO),
+                              BCCDataStoreControllerBenchmarksAttribute(@"updatedAt", NSDateAttributeType, NO)];
+    
+    NSManagedObjectModel *model = [[NSManagedObjectModel alloc] init];
+    model.entities = @[itemEntity];
+    
+    return model;
+}
+
+- (NSArray *)recordsWithCount:(NSUInteger)recordCount random:(BCCBenchmarkRandom *)random
+{
+    NSMutableArray *records = [[NSMutableArray alloc] initWithCapacity:recordCount];
+    
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        NSDictionary *record = @{@"identifier": [NSString stringWithFormat:@"item-%08lu", (unsigned long)i],
+                                 @"group": [NSString stringWithFormat:@"group-%02lu", (unsigned long)(i % BCCDataStoreControllerBenchmarksGroupCount)],
+                                 @"name": [random stringOfLength:16],
+                                 @"value": @([random nextValueBelow:BCCDataStoreControllerBenchmarksValueLimit]),
+                                 @"score": @([random nextFraction]),
+                                 @"updatedAt": @([random nextValueBelow:86400 * 365])};
+        
+        [records addObject:record];
+    }
+    
+    return records;
+}
+
+- (BCCDataStoreControllerImportParameters *)importParametersFindingExisting:(BOOL)findExisting inBatches:(BOOL)inBatches
+{
+    BCCDataStoreControllerImportParameters *importParameters = [[BCCDataStoreControllerImportParameters alloc] init];
+    importParameters.findExisting = findExisting;
+    importParameters.findsExistingInBatches = inBatches;
+    importParameters.dictionaryIdentityPropertyName = @"identifier";
+    
+    importParameters.postCreateBlock = ^(NSManagedObject *createdObject, id sourceObject, NSUInteger idx, NSManagedObjectContext *managedObjectContext) {
+        NSDictionary *record = (NSDictionary *)sourceObject;
+        
+        [createdObject setValue:[record objectForKey:@"group"] forKey:@"group"];
+        [createdObject setValue:[record objectForKey:@"name"] forKey:@"name"];
+        [createdObject setValue:[record objectForKey:@"value"] forKey:@"value"];
+        [createdObject setValue:[record objectForKey:@"score"] forKey:@"score"];
+        [createdObject setValue:[NSDate dateWithTimeIntervalSinceReferenceDate:[[record objectForKey:@"updatedAt"] doubleValue]] forKey:@"updatedAt"];
+    };
+    
+    return importParameters;
+}
+
+#pragma mark - Stores
+
+- (BCCDataStoreController *)newControllerWithRootDirectory:(NSString *)rootDirectory
+{
+    return [[BCCDataStoreController alloc] initWithIdentifier:BCCDataStoreControllerBenchmarksIdentifier modelPath:self.modelPath rootDirectory:rootDirectory];
+}
+
+- (NSString *)seededStoreDirectory
+{
+    // Fully seeded store shared (by copy) between the lookup, fan-out and
+    // delete benchmarks
+    if (!_seededStoreDirectory) {
+        _seededStoreDirectory = [self storeDirectorySeededWithRecords:self.records name:@"seed"];
+    }
+    
+    return _seededStoreDirectory;
+}
+
+- (NSString *)storeDirectorySeededWithRecords:(NSArray *)records name:(NSString *)name
+{
+    NSString *storeDirectory = [self.runner scratchDirectoryWithName:name];
+    
+    // Let the controller go before anything copies its store
+    @autoreleasepool {
+        BCCDataStoreController *benchmarkController = [self newControllerWithRootDirectory:storeDirectory];
+        [self importRecords:records intoController:benchmarkController usingImportParameters:[self importParametersFindingExisting:NO inBatches:NO]];
+    }
+    
+    return storeDirectory;
+}
+
+- (NSString *)scratchCopyOfStoreDirectory:(NSString *)storeDirectory
+{
+    NSString *scratchDirectory = [self.runner scratchDirectoryWithName:[storeDirectory lastPathComponent]];
+    NSString *copiedStoreDirectory = [scratchDirectory stringByAppendingPathComponent:@"store"];
+    
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] copyItemAtPath:storeDirectory toPath:copiedStoreDirectory error:&error]) {
+        NSLog(@"Unable to copy benchmark store %@: %@", storeDirectory, error);
+    }
+    
+    return copiedStoreDirectory;
+}
+
+- (void)importRecords:(NSArray *)records intoController:(BCCDataStoreController *)benchmarkController usingImportParameters:(BCCDataStoreControllerImportParameters *)importParameters
+{
+    BCCDataStoreControllerIdentityParameters *identityParameters = self.identityParameters;
+    
+    [benchmarkController performBlockOnMainMOCAndWait:^(BCCDataStoreController *dataStoreController, NSManagedObjectContext *managedObjectContext, BCCDataStoreControllerWorkParameters *workParameters) {
+        [dataStoreController createObjectsFromJSONArray:records usingImportParameters:importParameters identityParameters:identityParameters];
+    }];
+    
+    NSError *error = nil;
+    if (![benchmarkController persistChangesAndWait:&error]) {
+        NSLog(@"Unable to persist benchmark import: %@", error);
+    }
+}
+
+@end
+
+#pragma mark -
+
+@implementation BCCDataStoreControllerBenchmarksObserver
+
+- (void)dataStoreDidChange:(BCCDataStoreChangeNotification *)changeNotification
+{
+    self.notificationCount++;
+}
+
+@end
@@ -0,0 +1,30 @@
+//
+//  BCCPersistentCacheBenchmarks.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class BCCBenchmarkRunner;
+
+
+// BCCPersistentCache set, get, miss and eviction throughput at several
+// entry sizes, with and without segmented storage
+@interface BCCPersistentCacheBenchmarks : NSObject
+
+@property (strong, nonatomic, readonly) BCCBenchmarkRunner *runner;
+
+// Upper bound on entries per sample; large entries use fewer so a sample
+// stays around BCCPersistentCacheBenchmarksMaximumSampleBytes
+@property (nonatomic, readonly) NSUInteger entryCount;
+
+// Initialization
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner entryCount:(NSUInteger)entryCount;
+
+// Running
+- (void)run;
+
+@end
@@ -0,0 +1,322 @@
+//
+//  BCCPersistentCacheBenchmarks.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCPersistentCacheBenchmarks.h"
+#import "BCCBenchmarkRunner.h"
+#import "BCCPersistentCache.h"
+
+#import <unistd.h>
+
+
+// Constants
+NSString *BCCPersistentCacheBenchmarksIdentifier = @"Benchmarks";
+
+const NSUInteger BCCPersistentCacheBenchmarksMaximumSampleBytes = 33554432;
+const NSUInteger BCCPersistentCacheBenchmarksMinimumEntryCount = 8;
+const NSUInteger BCCPersistentCacheBenchmarksMissCount = 1000;
+
+// BCCPersistentCache's default maximumSegmentedEntrySize
+const NSUInteger BCCPersistentCacheBenchmarksMaximumSegmentedEntrySize = 32768;
+
+// Eviction is scheduled a couple of seconds after the cache notices it's
+// over its limit, so give it a generous window
+const NSTimeInterval BCCPersistentCacheBenchmarksEvictionTimeout = 30.0;
+
+
+@interface BCCPersistentCacheBenchmarks ()
+
+// Benchmarks
+- (void)runSetBenchmarks;
+- (void)runGetBenchmarks;
+- (void)runMissBenchmarks;
+- (void)runEvictionBenchmarks;
+
+// Caches
+- (NSArray *)storageVariantsForEntrySize:(NSUInteger)entrySize;
+- (NSUInteger)entryCountForEntrySize:(NSUInteger)entrySize;
+- (BCCPersistentCache *)newCacheUsingSegmentedStorage:(BOOL)usesSegmentedStorage;
+- (NSArray *)keysWithCount:(NSUInteger)entryCount random:(BCCBenchmarkRandom *)random;
+- (NSArray *)payloadsWithCount:(NSUInteger)entryCount entrySize:(NSUInteger)entrySize random:(BCCBenchmarkRandom *)random;
+- (void)fillCache:(BCCPersistentCache *)cache withKeys:(NSArray *)keys payloads:(NSArray *)payloads;
+- (NSArray *)fillCache:(BCCPersistentCache *)cache withEntryCount:(NSUInteger)entryCount entrySize:(NSUInteger)entrySize random:(BCCBenchmarkRandom *)random;
+
+@end
+
+
+#pragma mark -
+
+@implementation BCCPersistentCacheBenchmarks
+
+#pragma mark - Class Methods
+
++ (NSArray *)entrySizes
+{
+    return @[@256, @4096, @65536, @1048576];
+}
+
+#pragma mark - Initialization
+
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner entryCount:(NSUInteger)entryCount
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _runner = runner;
+    _entryCount = entryCount;
+    
+    return self;
+}
+
+#pragma mark - Running
+
+- (void)run
+{
+    if (![BCCPersistentCache metadataModelPath]) {
+        NSLog(@"Skipping persistent cache benchmarks: BCCPersistentCache.momd isn't next to the benchmark executable");
+        return;
+    }
+    
+    [self runSetBenchmarks];
+    [self runGetBenchmarks];
+    [self runMissBenchmarks];
+    [self runEvictionBenchmarks];
+}
+
+#pragma mark - Benchmarks
+
+- (void)runSetBenchmarks
+{
+    NSString *benchmarkName = @"cache.set";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentEntrySize in [BCCPersistentCacheBenchmarks entrySizes]) {
+        NSUInteger entrySize = [currentEntrySize unsignedIntegerValue];
+        NSUInteger entryCount = [self entryCountForEntrySize:entrySize];
+        
+        for (NSNumber *currentUsesSegments in [self storageVariantsForEntrySize:entrySize]) {
+            BCCPersistentCache *cache = [self newCacheUsingSegmentedStorage:[currentUsesSegments boolValue]];
+            
+            NSDictionary *parameters = @{@"entrySize": currentEntrySize, @"entries": @(entryCount), @"segmented": currentUsesSegments};
+            
+            [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:entryCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+                [cache clearCache];
+                
+                NSArray *keys = [self keysWithCount:entryCount random:random];
+                NSArray *payloads = [self payloadsWithCount:entryCount entrySize:entrySize random:random];
+                
+                NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+                [self fillCache:cache withKeys:keys payloads:payloads];
+                
+                return BCCBenchmarkCurrentTime() - startTime;
+            }];
+            
+            [cache clearCache];
+        }
+    }
+}
+
+- (void)runGetBenchmarks
+{
+    NSString *benchmarkName = @"cache.get";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentEntrySize in [BCCPersistentCacheBenchmarks entrySizes]) {
+        NSUInteger entrySize = [currentEntrySize unsignedIntegerValue];
+        NSUInteger entryCount = [self entryCountForEntrySize:entrySize];
+        
+        for (NSNumber *currentUsesSegments in [self storageVariantsForEntrySize:entrySize]) {
+            for (NSNumber *currentUsesMemoryCache in @[@NO, @YES]) {
+                BCCPersistentCache *cache = [self newCacheUsingSegmentedStorage:[currentUsesSegments boolValue]];
+                cache.usesMemoryCache = [currentUsesMemoryCache boolValue];
+                cache.maximumMemoryCacheSize = BCCPersistentCacheBenchmarksMaximumSampleBytes * 2;
+                
+                BCCBenchmarkRandom *fillRandom = [[BCCBenchmarkRandom alloc] initWithSeed:self.runner.seed + entrySize];
+                NSArray *keys = [self fillCache:cache withEntryCount:entryCount entrySize:entrySize random:fillRandom];
+                
+                NSDictionary *parameters = @{@"entrySize": currentEntrySize, @"entries": @(entryCount), @"segmented": currentUsesSegments, @"memoryCache": currentUsesMemoryCache};
+                
+                // Writes also go to the memory cache when it's on, so those
+                // samples measure memory hits and the rest the file tier
+                [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:entryCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+                    NSArray *lookupKeys = [random shuffledArray:keys];
+                    NSUInteger missingCount = 0;
+                    
+                    NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+                    
+                    for (NSString *currentKey in lookupKeys) {
+                        if (![cache cacheDataForKey:currentKey]) {
+                            missingCount++;
+                        }
+                    }
+                    
+                    NSTimeInterval duration = BCCBenchmarkCurrentTime() - startTime;
+                    
+                    if (missingCount > 0) {
+                        NSLog(@"%lu of %lu cache entries missing", (unsigned long)missingCount, (unsigned long)lookupKeys.count);
+                    }
+                    
+                    return duration;
+                }];
+                
+                [cache clearCache];
+            }
+        }
+    }
+}
+
+- (void)runMissBenchmarks
+{
+    NSString *benchmarkName = @"cache.miss";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentUsesSegments in @[@NO, @YES]) {
+        BCCPersistentCache *cache = [self newCacheUsingSegmentedStorage:[currentUsesSegments boolValue]];
+        
+        // Misses go through the memory tier and the index, so give them
+        // a populated cache to miss in
+        BCCBenchmarkRandom *fillRandom = [[BCCBenchmarkRandom alloc] initWithSeed:self.runner.seed];
+        [self fillCache:cache withEntryCount:[self entryCountForEntrySize:256] entrySize:256 random:fillRandom];
+        
+        NSDictionary *parameters = @{@"lookups": @(BCCPersistentCacheBenchmarksMissCount), @"segmented": currentUsesSegments};
+        
+        [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:BCCPersistentCacheBenchmarksMissCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+            NSMutableArray *missingKeys = [[NSMutableArray alloc] initWithCapacity:BCCPersistentCacheBenchmarksMissCount];
+            for (NSUInteger i = 0; i < BCCPersistentCacheBenchmarksMissCount; i++) {
+                [missingKeys addObject:[NSString stringWithFormat:@"missing-%@", [random stringOfLength:24]]];
+            }
+            
+            NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+            
+            for (NSString *currentKey in missingKeys) {
+                [cache cacheDataForKey:currentKey];
+            }
+            
+            return BCCBenchmarkCurrentTime() - startTime;
+        }];
+        
+        [cache clearCache];
+    }
+}
+
+- (void)runEvictionBenchmarks
+{
+    NSString *benchmarkName = @"cache.eviction";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentEntrySize in [BCCPersistentCacheBenchmarks entrySizes]) {
+        NSUInteger entrySize = [currentEntrySize unsignedIntegerValue];
+        NSUInteger entryCount = [self entryCountForEntrySize:entrySize];
+        
+        for (NSNumber *currentUsesSegments in [self storageVariantsForEntrySize:entrySize]) {
+            BCCPersistentCache *cache = [self newCacheUsingSegmentedStorage:[currentUsesSegments boolValue]];
+            
+            BCCDataStoreControllerMetrics *metrics = [[BCCDataStoreControllerMetrics alloc] init];
+            cache.metricsRecorder = metrics;
+            
+            NSDictionary *parameters = @{@"entrySize": currentEntrySize, @"entries": @(entryCount), @"segmented": currentUsesSegments};
+            
+            // Each sample fills the cache, halves its limit and times the
+            // eviction run that follows, as reported by the cache itself
+            [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:entryCount / 2 sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+                [cache clearCache];
+                cache.maximumFileCacheSize = NSUIntegerMax;
+                
+                [self fillCache:cache withEntryCount:entryCount entrySize:entrySize random:random];
+                
+                [metrics reset];
+                cache.maximumFileCacheSize = cache.totalFileCacheSize / 2;
+                
+                NSTimeInterval deadline = BCCBenchmarkCurrentTime() + BCCPersistentCacheBenchmarksEvictionTimeout;
+                while ([[metrics snapshot] counterValueForName:BCCPersistentCacheMetricEvictionRuns dimension:nil] < 1) {
+                    if (BCCBenchmarkCurrentTime() > deadline) {
+                        NSLog(@"Timed out waiting for cache eviction");
+                        return 0.0;
+                    }
+                    
+                    usleep(10000);
+                }
+                
+                return [[[metrics snapshot] histogramForName:BCCPersistentCacheMetricEvictionDuration dimension:nil] totalDuration];
+            }];
+            
+            cache.metricsRecorder = nil;
+            [cache clearCache];
+        }
+    }
+}
+
+#pragma mark - Caches
+
+- (NSArray *)storageVariantsForEntrySize:(NSUInteger)entrySize
+{
+    // Only entries that fit in a segment can tell the two layouts apart
+    return (entrySize <= BCCPersistentCacheBenchmarksMaximumSegmentedEntrySize) ? @[@NO, @YES] : @[@NO];
+}
+
+- (NSUInteger)entryCountForEntrySize:(NSUInteger)entrySize
+{
+    NSUInteger entryCount = MIN(self.entryCount, BCCPersistentCacheBenchmarksMaximumSampleBytes / MAX(entrySize, 1));
+    
+    return MAX(entryCount, BCCPersistentCacheBenchmarksMinimumEntryCount);
+}
+
+- (BCCPersistentCache *)newCacheUsingSegmentedStorage:(BOOL)usesSegmentedStorage
+{
+    NSString *rootDirectory = [self.runner scratchDirectoryWithName:@"cache"];
+    
+    BCCPersistentCache *cache = [[BCCPersistentCache alloc] initWithIdentifier:BCCPersistentCacheBenchmarksIdentifier rootDirectory:rootDirectory];
+    cache.usesSegmentedFileStorage = usesSegmentedStorage;
+    cache.maximumFileCacheSize = NSUIntegerMax;
+    
+    return cache;
+}
+
+- (NSArray *)keysWithCount:(NSUInteger)entryCount random:(BCCBenchmarkRandom *)random
+{
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:entryCount];
+    for (NSUInteger i = 0; i < entryCount; i++) {
+        [keys addObject:[NSString stringWithFormat:@"entry-%06lu-%@", (unsigned long)i, [random stringOfLength:8]]];
+    }
+    
+    return keys;
+}
+
+- (NSArray *)payloadsWithCount:(NSUInteger)entryCount entrySize:(NSUInteger)entrySize random:(BCCBenchmarkRandom *)random
+{
+    NSMutableArray *payloads = [[NSMutableArray alloc] initWithCapacity:entryCount];
+    for (NSUInteger i = 0; i < entryCount; i++) {
+        [payloads addObject:[random dataOfLength:entrySize]];
+    }
+    
+    return payloads;
+}
+
+- (void)fillCache:(BCCPersistentCache *)cache withKeys:(NSArray *)keys payloads:(NSArray *)payloads
+{
+    [keys enumerateObjectsUsingBlock:^(NSString *currentKey, NSUInteger idx, BOOL *stop) {
+        [cache setCacheData:[payloads objectAtIndex:idx] forKey:currentKey];
+    }];
+}
+
+- (NSArray *)fillCache:(BCCPersistentCache *)cache withEntryCount:(NSUInteger)entryCount entrySize:(NSUInteger)entrySize random:(BCCBenchmarkRandom *)random
+{
+    NSArray *keys = [self keysWithCount:entryCount random:random];
+    [self fillCache:cache withKeys:keys payloads:[self payloadsWithCount:entryCount entrySize:entrySize random:random]];
+    
+    return keys;
+}
+
+@end
@@ -0,0 +1,28 @@
+//
+//  BCCPersistentCacheSegmentStoreBenchmarks.h
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+
+@class BCCBenchmarkRunner;
+
+
+// Appends and reads straight against BCCPersistentCacheSegmentStore. These
+// don't touch Core Data, so they're the ones that can run where it isn't
+// available.
+@interface BCCPersistentCacheSegmentStoreBenchmarks : NSObject
+
+@property (strong, nonatomic, readonly) BCCBenchmarkRunner *runner;
+@property (nonatomic, readonly) NSUInteger recordCount;
+
+// Initialization
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner recordCount:(NSUInteger)recordCount;
+
+// Running
+- (void)run;
+
+@end
@@ -0,0 +1,175 @@
+//
+//  BCCPersistentCacheSegmentStoreBenchmarks.m
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import "BCCPersistentCacheSegmentStoreBenchmarks.h"
+#import "BCCBenchmarkRunner.h"
+#import "BCCPersistentCacheSegmentStore.h"
+
+
+typedef struct {
+    NSUInteger segmentIdentifier;
+    NSUInteger offset;
+} BCCPersistentCacheSegmentStoreBenchmarksLocation;
+
+
+@interface BCCPersistentCacheSegmentStoreBenchmarks ()
+
+// Benchmarks
+- (void)runAppendBenchmarks;
+- (void)runReadBenchmarks;
+
+// Records
+- (NSArray *)keysWithCount:(NSUInteger)recordCount random:(BCCBenchmarkRandom *)random;
+- (NSData *)appendPayload:(NSData *)payload forKeys:(NSArray *)keys toSegmentStore:(BCCPersistentCacheSegmentStore *)segmentStore;
+
+@end
+
+
+#pragma mark -
+
+@implementation BCCPersistentCacheSegmentStoreBenchmarks
+
+#pragma mark - Class Methods
+
++ (NSArray *)recordSizes
+{
+    return @[@64, @512, @4096, @32768];
+}
+
+#pragma mark - Initialization
+
+- (id)initWithRunner:(BCCBenchmarkRunner *)runner recordCount:(NSUInteger)recordCount
+{
+    if (!(self = [super init])) {
+        return nil;
+    }
+    
+    _runner = runner;
+    _recordCount = recordCount;
+    
+    return self;
+}
+
+#pragma mark - Running
+
+- (void)run
+{
+    [self runAppendBenchmarks];
+    [self runReadBenchmarks];
+}
+
+#pragma mark - Benchmarks
+
+- (void)runAppendBenchmarks
+{
+    NSString *benchmarkName = @"segments.append";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentRecordSize in [BCCPersistentCacheSegmentStoreBenchmarks recordSizes]) {
+        NSUInteger recordSize = [currentRecordSize unsignedIntegerValue];
+        NSDictionary *parameters = @{@"recordSize": currentRecordSize, @"records": @(self.recordCount)};
+        
+        [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:self.recordCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+            BCCPersistentCacheSegmentStore *segmentStore = [[BCCPersistentCacheSegmentStore alloc] initWithDirectoryPath:[self.runner scratchDirectoryWithName:@"segments"]];
+            NSArray *keys = [self keysWithCount:self.recordCount random:random];
+            NSData *payload = [random dataOfLength:recordSize];
+            
+            NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+            [self appendPayload:payload forKeys:keys toSegmentStore:segmentStore];
+            NSTimeInterval duration = BCCBenchmarkCurrentTime() - startTime;
+            
+            [segmentStore removeAllSegments];
+            
+            return duration;
+        }];
+    }
+}
+
+- (void)runReadBenchmarks
+{
+    NSString *benchmarkName = @"segments.read";
+    if (![self.runner shouldRunBenchmarkNamed:benchmarkName]) {
+        return;
+    }
+    
+    for (NSNumber *currentRecordSize in [BCCPersistentCacheSegmentStoreBenchmarks recordSizes]) {
+        NSUInteger recordSize = [currentRecordSize unsignedIntegerValue];
+        NSUInteger recordCount = self.recordCount;
+        
+        BCCPersistentCacheSegmentStore *segmentStore = [[BCCPersistentCacheSegmentStore alloc] initWithDirectoryPath:[self.runner scratchDirectoryWithName:@"segments"]];
+        
+        BCCBenchmarkRandom *fillRandom = [[BCCBenchmarkRandom alloc] initWithSeed:self.runner.seed + recordSize];
+        NSArray *keys = [self keysWithCount:recordCount random:fillRandom];
+        NSData *locationData = [self appendPayload:[fillRandom dataOfLength:recordSize] forKeys:keys toSegmentStore:segmentStore];
+        
+        NSMutableArray *recordIndexes = [[NSMutableArray alloc] initWithCapacity:recordCount];
+        for (NSUInteger i = 0; i < recordCount; i++) {
+            [recordIndexes addObject:@(i)];
+        }
+        
+        NSDictionary *parameters = @{@"recordSize": currentRecordSize, @"records": @(recordCount)};
+        
+        [self.runner runBenchmarkNamed:benchmarkName parameters:parameters operationCount:recordCount sampleBlock:^NSTimeInterval(NSUInteger sampleIndex, BCCBenchmarkRandom *random) {
+            const BCCPersistentCacheSegmentStoreBenchmarksLocation *locations = locationData.bytes;
+            NSArray *readOrder = [random shuffledArray:recordIndexes];
+            NSUInteger failedCount = 0;
+            
+            NSTimeInterval startTime = BCCBenchmarkCurrentTime();
+            
+            for (NSNumber *currentIndex in readOrder) {
+                NSUInteger recordIndex = [currentIndex unsignedIntegerValue];
+                BCCPersistentCacheSegmentStoreBenchmarksLocation location = locations[recordIndex];
+                
+                if (![segmentStore dataForKey:[keys objectAtIndex:recordIndex] segmentIdentifier:location.segmentIdentifier offset:location.offset length:recordSize]) {
+                    failedCount++;
+                }
+            }
+            
+            NSTimeInterval duration = BCCBenchmarkCurrentTime() - startTime;
+            
+            if (failedCount > 0) {
+                NSLog(@"%lu of %lu segment reads failed", (unsigned long)failedCount, (unsigned long)readOrder.count);
+            }
+            
+            return duration;
+        }];
+        
+        [segmentStore removeAllSegments];
+    }
+}
+
+#pragma mark - Records
+
+- (NSArray *)keysWithCount:(NSUInteger)recordCount random:(BCCBenchmarkRandom *)random
+{
+    NSMutableArray *keys = [[NSMutableArray alloc] initWithCapacity:recordCount];
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        [keys addObject:[NSString stringWithFormat:@"record-%06lu-%@", (unsigned long)i, [random stringOfLength:8]]];
+    }
+    
+    return keys;
+}
+
+- (NSData *)appendPayload:(NSData *)payload forKeys:(NSArray *)keys toSegmentStore:(BCCPersistentCacheSegmentStore *)segmentStore
+{
+    // Every record shares one payload, which keeps data generation out of
+    // the timings. The store checksums each record whatever it holds.
+    NSMutableData *locationData = [[NSMutableData alloc] initWithLength:keys.count * sizeof(BCCPersistentCacheSegmentStoreBenchmarksLocation)];
+    BCCPersistentCacheSegmentStoreBenchmarksLocation *locations = locationData.mutableBytes;
+    
+    [keys enumerateObjectsUsingBlock:^(NSString *currentKey, NSUInteger idx, BOOL *stop) {
+        if (![segmentStore appendData:payload forKey:currentKey segmentIdentifier:&locations[idx].segmentIdentifier offset:&locations[idx].offset]) {
+            NSLog(@"Unable to append segment record for key %@", currentKey);
+        }
+    }];
+    
+    return locationData;
+}
+
+@end
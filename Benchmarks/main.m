@@ -0,0 +1,129 @@
+//
+//  main.m
+//  BCCDataBenchmarks
+//
+//  Created by Brooklyn Computer Club on 10/16/26.
+//  Copyright 2026 Brooklyn Computer Club. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import "BCCBenchmarkRunner.h"
+#import "BCCPersistentCacheSegmentStoreBenchmarks.h"
+
+#if __has_include(<CoreData/CoreData.h>)
+#import "BCCDataStoreControllerBenchmarks.h"
+#import "BCCPersistentCacheBenchmarks.h"
+#define BCCBenchmarksHaveCoreData 1
+#endif
+
+#import <stdlib.h>
+
+
+// Constants
+const uint64_t BCCBenchmarksDefaultSeed = 1;
+const NSUInteger BCCBenchmarksDefaultSampleCount = 10;
+
+// Dataset sizes at -scale 1
+const NSUInteger BCCBenchmarksDataStoreRecordCount = 2000;
+const NSUInteger BCCBenchmarksCacheEntryCount = 1000;
+const NSUInteger BCCBenchmarksSegmentRecordCount = 10000;
+
+
+static void BCCBenchmarksPrintUsage(void)
+{
+    fprintf(stderr, "Usage: BCCDataBenchmarks [-seed N] [-samples N] [-warmup N] [-scale X] [-filter NAME] [-format json|csv] [-output PATH] [-keepFiles YES]\n");
+    fprintf(stderr, "Results go to standard output (or PATH) and progress to standard error.\n");
+}
+
+static NSUInteger BCCBenchmarksScaledCount(NSUInteger count, double scale)
+{
+    return MAX((NSUInteger)llround(count * scale), 1);
+}
+
+static int BCCBenchmarksRun(void)
+{
+    // Options come from the argument domain, e.g. "-seed 42 -format csv"
+    NSUserDefaults *arguments = [NSUserDefaults standardUserDefaults];
+    
+    NSString *seedString = [arguments stringForKey:@"seed"];
+    uint64_t seed = seedString ? strtoull([seedString UTF8String], NULL, 10) : BCCBenchmarksDefaultSeed;
+    
+    NSString *formatString = [arguments stringForKey:@"format"];
+    BCCBenchmarkOutputFormat format = [[formatString lowercaseString] isEqualToString:@"csv"] ? BCCBenchmarkOutputFormatCSV : BCCBenchmarkOutputFormatJSON;
+    
+    double scale = [arguments objectForKey:@"scale"] ? [arguments doubleForKey:@"scale"] : 1.0;
+    if (scale <= 0.0) {
+        BCCBenchmarksPrintUsage();
+        return EXIT_FAILURE;
+    }
+    
+    BCCBenchmarkRunner *runner = [[BCCBenchmarkRunner alloc] initWithSeed:seed];
+    runner.sampleCount = [arguments objectForKey:@"samples"] ? MAX((NSUInteger)[arguments integerForKey:@"samples"], 1) : BCCBenchmarksDefaultSampleCount;
+    runner.filter = [arguments stringForKey:@"filter"];
+    
+    if ([arguments objectForKey:@"warmup"]) {
+        runner.warmupSampleCount = (NSUInteger)MAX([arguments integerForKey:@"warmup"], 0);
+    }
+    
+    BCCPersistentCacheSegmentStoreBenchmarks *segmentStoreBenchmarks = [[BCCPersistentCacheSegmentStoreBenchmarks alloc] initWithRunner:runner recordCount:BCCBenchmarksScaledCount(BCCBenchmarksSegmentRecordCount, scale)];
+    [segmentStoreBenchmarks run];
+    
+#ifdef BCCBenchmarksHaveCoreData
+    BCCDataStoreControllerBenchmarks *dataStoreBenchmarks = [[BCCDataStoreControllerBenchmarks alloc] initWithRunner:runner recordCount:BCCBenchmarksScaledCount(BCCBenchmarksDataStoreRecordCount, scale)];
+    [dataStoreBenchmarks run];
+    
+    BCCPersistentCacheBenchmarks *cacheBenchmarks = [[BCCPersistentCacheBenchmarks alloc] initWithRunner:runner entryCount:BCCBenchmarksScaledCount(BCCBenchmarksCacheEntryCount, scale)];
+    [cacheBenchmarks run];
+#else
+    NSLog(@"Core Data isn't available, so only the segment store benchmarks were run");
+#endif
+    
+    NSData *outputData = [runner outputDataWithFormat:format];
+    
+    if (![arguments boolForKey:@"keepFiles"]) {
+        [runner removeWorkingDirectory];
+    } else {
+        NSLog(@"Benchmark files kept in %@", runner.workingDirectory);
+    }
+    
+    if (!outputData) {
+        return EXIT_FAILURE;
+    }
+    
+    NSString *outputPath = [arguments stringForKey:@"output"];
+    if (outputPath) {
+        NSError *error = nil;
+        if (![outputData writeToFile:outputPath options:NSDataWritingAtomic error:&error]) {
+            NSLog(@"Unable to write benchmark results to %@: %@", outputPath, error);
+            return EXIT_FAILURE;
+        }
+    } else {
+        [[NSFileHandle fileHandleWithStandardOutput] writeData:outputData];
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, const char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "-help") || !strcmp(argv[i], "--help")) {
+            BCCBenchmarksPrintUsage();
+            return EXIT_SUCCESS;
+        }
+    }
+    
+    // Controllers deliver saves and completions on the main queue, so the
+    // suite runs on another one while the main queue is serviced
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        int status = EXIT_SUCCESS;
+        
+        @autoreleasepool {
+            status = BCCBenchmarksRun();
+        }
+        
+        exit(status);
+    });
+    
+    dispatch_main();
+}